@@ -0,0 +1,78 @@
+#include "Manifest.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace cook {
+    // A text file, one line per record and the path always last so it may
+    // hold spaces:
+    //     cook <version>
+    //     = <settings> <output>
+    //     < <hash> <size> <modified> <input>
+    // Input lines belong to the output line above them.
+    Manifest Manifest::Load(const string& filename)
+    {
+        Manifest manifest;
+        ifstream in{ filename, ios::binary };
+        string line, word;
+        uint32_t version = 0;
+        if (!getline(in, line) || !(istringstream{ line } >> word >> version) || word != "cook" || version != Version) {
+            return manifest;
+        }
+
+        Entry* current = nullptr;
+        while (getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+            istringstream fields{ line };
+            char kind = 0;
+            fields >> kind >> hex;
+            if (kind == '=') {
+                uint64_t settings;
+                if (!(fields >> settings) || fields.get() != ' ') { return Manifest{}; }
+                string output;
+                getline(fields, output);
+                current = &manifest._entries[output];
+                current->settings = settings;
+                current->inputs.clear();
+            }
+            else if (kind == '<' && current) {
+                Input input;
+                if (!(fields >> input.hash >> dec >> input.size >> input.modified) || fields.get() != ' ') { return Manifest{}; }
+                getline(fields, input.path);
+                current->inputs.push_back(move(input));
+            }
+            else if (!line.empty()) {
+                return Manifest{};
+            }
+        }
+        return manifest;
+    }
+
+    void Manifest::Save(const string& filename) const
+    {
+        string temporary = filename + ".part";
+        {
+            ofstream out{ temporary, ios::binary | ios::trunc };
+            if (!out) { throw runtime_error{ "Failed to create file: " + temporary }; }
+            out << "cook " << Version << '\n';
+            for (auto& entry : _entries) {
+                out << "= " << hex << entry.second.settings << ' ' << entry.first << '\n';
+                for (auto& input : entry.second.inputs) {
+                    out << "< " << hex << input.hash << ' ' << dec << input.size << ' ' << input.modified << ' ' << input.path << '\n';
+                }
+            }
+            if (!out.flush()) { throw runtime_error{ "Failed to write file: " + temporary }; }
+        }
+        filesystem::rename(temporary, filename);
+    }
+
+    const Entry* Manifest::Find(const string& output) const
+    {
+        auto found = _entries.find(output);
+        return found != _entries.end() ? &found->second : nullptr;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#ifndef COOKER_MANIFEST
+#define COOKER_MANIFEST
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace cook {
+    // One file an output was built from, as it was when it was cooked.
+    // Paths are relative to the source root, with forward slashes.
+    struct Input {
+        static constexpr std::uint64_t Missing = std::numeric_limits<std::uint64_t>::max();
+
+        std::string path;
+        // Missing if the file did not exist, which is itself worth
+        // tracking: an mtllib that appears later changes the mesh.
+        std::uint64_t size;
+        std::int64_t modified;
+        std::uint64_t hash;
+    };
+
+    struct Entry {
+        // Identifies the converter and its options; a change rebuilds.
+        std::uint64_t settings;
+        // The source the output is named after comes first.
+        std::vector<Input> inputs;
+    };
+
+    // Record of the last cook, keyed by output path. An output is up to
+    // date when its settings match and none of its inputs changed; size and
+    // modification time are compared first, so an unchanged tree is
+    // checked without reading file contents.
+    class Manifest {
+    public:
+        static constexpr std::uint32_t Version = 1;
+
+        Manifest() = default;
+
+        // A missing, unreadable or outdated manifest loads empty, which
+        // simply cooks everything again.
+        static Manifest Load(const std::string& filename);
+        // Writes beside filename and renames over it, so an interrupted
+        // save leaves the previous manifest intact.
+        void Save(const std::string& filename) const;
+
+        const Entry* Find(const std::string& output) const;
+        void Record(const std::string& output, Entry entry) { _entries[output] = std::move(entry); }
+        void Erase(const std::string& output) { _entries.erase(output); }
+
+        const std::map<std::string, Entry>& entries() const { return _entries; }
+    private:
+        std::map<std::string, Entry> _entries;
+    };
+}
+
+#endif
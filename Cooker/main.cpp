@@ -0,0 +1,415 @@
+// Offline asset cooker. Walks a source tree and writes the runtime's
+// formats to a mirror of it: OBJ meshes are optimized and cooked to .mesh
+// files carrying their bounds, bitmaps are cooked to .tex files holding
+// their whole mip chain, .atlas lists of bitmaps are packed into one
+// cooked .atl texture, and the formats the runtime reads as they are (glb,
+// glsl) are copied. Bitmaps are taken as sRGB colour and their levels
+// filtered in linear light. A manifest in the output directory
+// records what every output was built from, so later runs redo only the
+// outputs whose inputs changed and delete those whose source is gone.
+// Each cooked mesh is listed with its vertex cache figures and the error
+// packing its vertices introduced, flagged when that is over tolerance.
+//
+//     Cooker <source> <output> [-j threads] [--force] [--no-optimize] [--no-compress] [--mip-filter box|kaiser]
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "Manifest.h"
+#include "../Math/include/gl_data.hpp"
+#include "../SDL2 Template/GL/Atlas.h"
+#include "../SDL2 Template/GL/MeshFile.h"
+#include "../SDL2 Template/GL/OBJmesh.h"
+#include "../SDL2 Template/GL/TextureFile.h"
+#include "../SDL2 Template/IO/ContentHash.h"
+#include "../SDL2 Template/IO/MappedFile.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+    // Raise when a converter's output changes for the same input.
+    constexpr uint64_t CookerVersion = 3;
+
+    constexpr char ManifestName[] = "cook.manifest";
+
+    // Packing errors past these are reported as warnings: a position off by
+    // more than this share of the mesh's largest extent, a normal turned by
+    // more degrees than this, a uv moved by more than half a texel of a
+    // 4096 texture.
+    constexpr float PositionTolerance = 1e-4f;
+    constexpr float NormalTolerance = 0.1f;
+    constexpr float UvTolerance = 0.5f / 4096;
+
+    struct Options {
+        fs::path source, output;
+        unsigned threads = 0;
+        bool force = false;
+        bool optimize = true;
+        bool compress = true;
+        lynda::MipFilter filter = lynda::MipFilter::Kaiser;
+    };
+
+    enum class Convert { Mesh, Texture, Atlas, Copy };
+
+    struct Rule {
+        const char* extension;
+        const char* output;
+        Convert convert;
+    };
+
+    const Rule rules[] = {
+        { ".obj", ".mesh", Convert::Mesh },
+        { ".atlas", ".atl", Convert::Atlas },
+        { ".glb", ".glb", Convert::Copy },
+        { ".bmp", ".tex", Convert::Texture },
+        { ".glsl", ".glsl", Convert::Copy },
+    };
+
+    const Rule* FindRule(const fs::path& file)
+    {
+        string extension = file.extension().u8string();
+        for (char& c : extension) { c = static_cast<char>(tolower(static_cast<unsigned char>(c))); }
+        for (const Rule& rule : rules) {
+            if (extension == rule.extension) { return &rule; }
+        }
+        return nullptr;
+    }
+
+    uint64_t Settings(const Rule& rule, const Options& options)
+    {
+        string key = to_string(CookerVersion) + rule.extension + rule.output;
+        if (rule.convert == Convert::Mesh) {
+            key += " mesh " + to_string(gl::MeshFile::Version) + (options.optimize ? " optimize" : "") + (options.compress ? " compress" : "");
+        }
+        if (rule.convert == Convert::Texture) {
+            key += " texture " + to_string(gl::TextureFile::Version) + (options.filter == lynda::MipFilter::Box ? " box" : " kaiser");
+        }
+        if (rule.convert == Convert::Atlas) {
+            gl::AtlasSettings atlas;
+            key += " atlas " + to_string(gl::AtlasFile::Version) + " " + to_string(atlas.maxSize) + " " + to_string(atlas.padding) + " " + to_string(atlas.levels);
+        }
+        return io::ContentHash(key.data(), key.size());
+    }
+
+    enum class Outcome { Fresh, Cooked, Failed };
+
+    struct Job {
+        const Rule* rule;
+        string input, output;
+        // From the directory walk, which gets them without another stat.
+        uint64_t size;
+        int64_t modified;
+        const cook::Entry* previous;
+
+        Outcome outcome;
+        cook::Entry result;
+        string error;
+        // Lines printed under the cooked file, each ending in a newline.
+        string notes;
+    };
+
+    int64_t Ticks(fs::file_time_type time)
+    {
+        return static_cast<int64_t>(time.time_since_epoch().count());
+    }
+
+    // The input as it is now, given its size and time. Contents are hashed
+    // only if those differ from what was recorded.
+    cook::Input Identify(const fs::path& root, const string& path, uint64_t size, int64_t modified, const cook::Input* recorded)
+    {
+        if (size == cook::Input::Missing) { return cook::Input{ path, size, 0, 0 }; }
+        if (recorded && recorded->size == size && recorded->modified == modified) { return cook::Input{ path, size, modified, recorded->hash }; }
+        io::MappedFile contents{ (root / fs::u8path(path)).string() };
+        return cook::Input{ path, size, modified, io::ContentHash(contents.data(), contents.size()) };
+    }
+
+    cook::Input Examine(const fs::path& root, const string& path, const cook::Input* recorded)
+    {
+        fs::path file = root / fs::u8path(path);
+        error_code failed;
+        uint64_t size = fs::file_size(file, failed);
+        int64_t modified = failed ? 0 : Ticks(fs::last_write_time(file, failed));
+        return Identify(root, path, failed ? cook::Input::Missing : size, modified, recorded);
+    }
+
+    // Whether job's output can stay as it is. Fills in the current state of
+    // its inputs either way, so ones touched without changing are not
+    // hashed again next time.
+    bool Fresh(const Options& options, Job& job, const fs::path& destination)
+    {
+        const cook::Entry* previous = job.previous;
+        const cook::Input* primary = previous && !previous->inputs.empty() && previous->inputs.front().path == job.input ? &previous->inputs.front() : nullptr;
+        job.result.inputs.assign(1, Identify(options.source, job.input, job.size, job.modified, primary));
+
+        if (options.force || !primary || previous->settings != job.result.settings || job.result.inputs.front().hash != primary->hash || !fs::exists(destination)) {
+            return false;
+        }
+        for (size_t i = 1; i < previous->inputs.size(); ++i) {
+            const cook::Input& recorded = previous->inputs[i];
+            job.result.inputs.push_back(Examine(options.source, recorded.path, &recorded));
+            if (job.result.inputs.back().size != recorded.size || job.result.inputs.back().hash != recorded.hash) { return false; }
+        }
+        return true;
+    }
+
+    void CookMesh(const Options& options, Job& job, const fs::path& source, const fs::path& destination)
+    {
+        // The pool already has a job per hardware thread; parsing on more
+        // would only oversubscribe it.
+        OBJmesh mesh{ source.string(), 1 };
+        char line[160];
+        if (options.optimize) {
+            gl::optimize::Report report = mesh.Optimize();
+            snprintf(line, sizeof line, "    vertex cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+                report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr);
+            job.notes += line;
+        }
+        gl::PackingError error = gl::MeshFile::Cook(mesh, destination.string(), options.compress);
+        gl::Vector3 extent = gl::Quantize(mesh.vData()).extent;
+        float size = max(extent.x, max(extent.y, extent.z));
+        snprintf(line, sizeof line, "    packing error: position %g, normal %g deg, uv %g\n", error.position, error.normal, error.uv);
+        job.notes += line;
+        if (error.position > PositionTolerance * size || error.normal > NormalTolerance || error.uv > UvTolerance) {
+            snprintf(line, sizeof line, "    warning: packing error over tolerance (position %g, normal %g deg, uv %g)\n",
+                PositionTolerance * size, NormalTolerance, UvTolerance);
+            job.notes += line;
+        }
+
+        fs::path directory = fs::u8path(job.input).parent_path();
+        for (const string& library : mesh.materialLibraries()) {
+            string path = (directory / fs::u8path(library)).lexically_normal().generic_u8string();
+            job.result.inputs.push_back(Examine(options.source, path, nullptr));
+        }
+    }
+
+    void CookTexture(const Options& options, const fs::path& source, const fs::path& destination)
+    {
+        lynda::Bitmap bitmap{ source.string().c_str() };
+        gl::Texture::Image image{ bitmap.width, bitmap.height, bitmap.BitsPerPixel / 8, bitmap.pixels.data(), 0 };
+        // One thread, for the same reason as CookMesh.
+        gl::TextureFile::Cook(image, gl::Texture::Encoding::Srgb, options.filter, destination.string(), 1);
+    }
+
+    // An atlas source lists one bitmap per line, relative to the list, and
+    // each is named in the atlas as written. Blank lines and ones starting
+    // with # are skipped. Listing images beside the MTL files that use them
+    // lets TextureAtlas::Remap match them to map_Kd.
+    void CookAtlas(const Options& options, Job& job, const fs::path& source, const fs::path& destination)
+    {
+        ifstream list{ source };
+        if (!list) { throw runtime_error{ "Failed to open " + source.string() }; }
+        vector<string> names;
+        vector<lynda::Bitmap> bitmaps;
+        fs::path directory = fs::u8path(job.input).parent_path();
+        for (string line; getline(list, line); ) {
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            line.erase(0, line.find_first_not_of(" \t"));
+            if (line.empty() || line[0] == '#') { continue; }
+            string path = (directory / fs::u8path(line)).lexically_normal().generic_u8string();
+            job.result.inputs.push_back(Examine(options.source, path, nullptr));
+            if (job.result.inputs.back().size == cook::Input::Missing) { throw runtime_error{ path + " is missing" }; }
+            bitmaps.emplace_back((options.source / fs::u8path(path)).string().c_str());
+            names.push_back(line);
+        }
+
+        vector<gl::Texture::Image> images;
+        for (const lynda::Bitmap& bitmap : bitmaps) {
+            images.push_back(gl::Texture::Image{ bitmap.width, bitmap.height, bitmap.BitsPerPixel / 8, bitmap.pixels.data(), 0 });
+        }
+        gl::AtlasFile::Cook(names, images, destination.string(), gl::AtlasSettings{}, gl::Texture::Encoding::Srgb);
+    }
+
+    void Cook(const Options& options, Job& job)
+    {
+        fs::path destination = options.output / fs::u8path(job.output);
+        job.result.settings = Settings(*job.rule, options);
+        if (Fresh(options, job, destination)) {
+            job.outcome = Outcome::Fresh;
+            return;
+        }
+
+        // Fresh hashed the source before it is read for cooking, so an edit
+        // made meanwhile shows up as a change next time.
+        job.result.inputs.resize(1);
+        fs::path source = options.source / fs::u8path(job.input);
+        fs::path partial = destination;
+        partial += ".part";
+        fs::create_directories(destination.parent_path());
+
+        switch (job.rule->convert) {
+        case Convert::Mesh:
+            CookMesh(options, job, source, partial);
+            break;
+        case Convert::Texture:
+            CookTexture(options, source, partial);
+            break;
+        case Convert::Atlas:
+            CookAtlas(options, job, source, partial);
+            break;
+        case Convert::Copy:
+            fs::copy_file(source, partial, fs::copy_options::overwrite_existing);
+            break;
+        }
+        fs::rename(partial, destination);
+        job.outcome = Outcome::Cooked;
+    }
+
+    bool Inside(const fs::path& path, const fs::path& directory)
+    {
+        auto mismatch = std::mismatch(directory.begin(), directory.end(), path.begin(), path.end());
+        return mismatch.first == directory.end();
+    }
+
+    vector<Job> Collect(const Options& options, const cook::Manifest& manifest)
+    {
+        vector<Job> jobs;
+        fs::recursive_directory_iterator walk{ options.source, fs::directory_options::skip_permission_denied };
+        for (auto entry = fs::begin(walk); entry != fs::end(walk); ++entry) {
+            if (entry->is_directory()) {
+                // Outputs written inside the source tree are not sources.
+                if (Inside(entry->path(), options.output)) { entry.disable_recursion_pending(); }
+                continue;
+            }
+            const Rule* rule = entry->is_regular_file() ? FindRule(entry->path()) : nullptr;
+            if (!rule) { continue; }
+
+            fs::path relative = entry->path().lexically_relative(options.source);
+            Job job{};
+            job.rule = rule;
+            job.input = relative.generic_u8string();
+            job.output = relative.replace_extension(rule->output).generic_u8string();
+            job.size = entry->file_size();
+            job.modified = Ticks(entry->last_write_time());
+            job.previous = manifest.Find(job.output);
+            jobs.push_back(move(job));
+        }
+
+        // Largest first, so one big mesh started last does not keep every
+        // other thread waiting on it.
+        sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) { return a.size > b.size; });
+
+        // Two sources mapping to one output would race on it.
+        vector<const Job*> byOutput;
+        for (const Job& job : jobs) { byOutput.push_back(&job); }
+        sort(byOutput.begin(), byOutput.end(), [](const Job* a, const Job* b) { return a->output < b->output; });
+        for (size_t i = 1; i < byOutput.size(); ++i) {
+            if (byOutput[i]->output == byOutput[i - 1]->output) {
+                throw runtime_error{ byOutput[i - 1]->input + " and " + byOutput[i]->input + " both cook to " + byOutput[i]->output };
+            }
+        }
+        return jobs;
+    }
+
+    void Run(const Options& options, vector<Job>& jobs)
+    {
+        atomic<size_t> next{ 0 };
+        mutex report;
+        auto work = [&]() {
+            for (size_t i; (i = next++) < jobs.size(); ) {
+                Job& job = jobs[i];
+                try {
+                    Cook(options, job);
+                }
+                catch (const exception& e) {
+                    job.outcome = Outcome::Failed;
+                    job.error = e.what();
+                }
+                if (job.outcome != Outcome::Fresh) {
+                    lock_guard<mutex> hold{ report };
+                    if (job.outcome == Outcome::Failed) { fprintf(stderr, "%s: %s\n", job.input.c_str(), job.error.c_str()); }
+                    else { printf("%s -> %s\n%s", job.input.c_str(), job.output.c_str(), job.notes.c_str()); }
+                }
+            }
+        };
+
+        unsigned count = options.threads ? options.threads : max(thread::hardware_concurrency(), 1u);
+        count = static_cast<unsigned>(min<size_t>(count, max<size_t>(jobs.size(), 1)));
+        vector<thread> workers;
+        for (unsigned t = 1; t < count; ++t) { workers.emplace_back(work); }
+        work();
+        for (auto& worker : workers) { worker.join(); }
+    }
+
+    bool Parse(int argc, char* argv[], Options& options)
+    {
+        vector<string> paths;
+        for (int i = 1; i < argc; ++i) {
+            string arg = argv[i];
+            if (arg == "-j" && i + 1 < argc) { options.threads = static_cast<unsigned>(stoul(argv[++i])); }
+            else if (arg == "--force") { options.force = true; }
+            else if (arg == "--no-optimize") { options.optimize = false; }
+            else if (arg == "--no-compress") { options.compress = false; }
+            else if (arg == "--mip-filter" && i + 1 < argc) {
+                string filter = argv[++i];
+                if (filter == "box") { options.filter = lynda::MipFilter::Box; }
+                else if (filter == "kaiser") { options.filter = lynda::MipFilter::Kaiser; }
+                else { return false; }
+            }
+            else if (!arg.empty() && arg[0] == '-') { return false; }
+            else { paths.push_back(arg); }
+        }
+        if (paths.size() != 2) { return false; }
+        options.source = fs::absolute(paths[0]).lexically_normal();
+        options.output = fs::absolute(paths[1]).lexically_normal();
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!Parse(argc, argv, options)) {
+        fprintf(stderr, "usage: %s <source> <output> [-j threads] [--force] [--no-optimize] [--no-compress] [--mip-filter box|kaiser]\n", argc ? argv[0] : "Cooker");
+        return 2;
+    }
+
+    try {
+        auto start = chrono::steady_clock::now();
+        fs::create_directories(options.output);
+        string manifestFile = (options.output / ManifestName).string();
+        cook::Manifest previous = cook::Manifest::Load(manifestFile);
+
+        vector<Job> jobs = Collect(options, previous);
+        Run(options, jobs);
+
+        cook::Manifest manifest;
+        unordered_set<string> outputs;
+        size_t cooked = 0, failed = 0, removed = 0;
+        for (Job& job : jobs) {
+            outputs.insert(job.output);
+            // A failed output is left out so the next run tries it again.
+            if (job.outcome == Outcome::Failed) { ++failed; continue; }
+            if (job.outcome == Outcome::Cooked) { ++cooked; }
+            manifest.Record(job.output, move(job.result));
+        }
+        for (auto& entry : previous.entries()) {
+            if (outputs.count(entry.first)) { continue; }
+            error_code ignored;
+            if (fs::remove(options.output / fs::u8path(entry.first), ignored)) { ++removed; }
+        }
+        manifest.Save(manifestFile);
+
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printf("%zu files: %zu cooked, %zu up to date, %zu failed, %zu removed in %.2fs\n",
+            jobs.size(), cooked, jobs.size() - cooked - failed, failed, removed, seconds);
+        return failed ? 1 : 0;
+    }
+    catch (const exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+}
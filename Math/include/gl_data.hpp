@@ -11,7 +11,7 @@
  *       Compiler:  gcc
  *
  *         Author:  Pablo Colapinto (), gmail -> wolftype
- *   Organization:  
+ *   Organization:
  *
  * =====================================================================================
  */
@@ -19,70 +19,364 @@
 #ifndef  gl_data_INC
 #define  gl_data_INC
 
-#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <future>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include <stdint.h>
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define LYNDA_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// gcc and clang only emit SSSE3/AVX2 instructions in functions marked for
+// them; msvc emits any intrinsic anywhere.
+#if defined(LYNDA_X86) && !defined(_MSC_VER)
+#define LYNDA_TARGET(isa) __attribute__((target(isa)))
+#else
+#define LYNDA_TARGET(isa)
+#endif
+
 namespace lynda {
 
+namespace detail {
+
+    // Read-only mapping of a whole file.
+    struct MappedFile {
+        const uint8_t* data;
+        size_t size;
+
+        explicit MappedFile(const std::string& path) : data(nullptr), size(0) {
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            mapping = nullptr;
+            if (file == INVALID_HANDLE_VALUE) return;
+            LARGE_INTEGER length;
+            if (!GetFileSizeEx(file, &length) || length.QuadPart == 0) return;
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mapping) return;
+            data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            if (data) size = static_cast<size_t>(length.QuadPart);
+#else
+            file = open(path.c_str(), O_RDONLY);
+            if (file < 0) return;
+            struct stat status;
+            if (fstat(file, &status) != 0 || status.st_size == 0) return;
+            void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+            if (view == MAP_FAILED) return;
+            data = static_cast<const uint8_t*>(view);
+            size = static_cast<size_t>(status.st_size);
+#endif
+        }
+
+        ~MappedFile() {
+#ifdef _WIN32
+            if (data) UnmapViewOfFile(data);
+            if (mapping) CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+            if (data) munmap(const_cast<uint8_t*>(data), size);
+            if (file >= 0) close(file);
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Opened, though possibly empty.
+        bool exists() const {
+#ifdef _WIN32
+            return file != INVALID_HANDLE_VALUE;
+#else
+            return file >= 0;
+#endif
+        }
+
+    private:
+#ifdef _WIN32
+        HANDLE file;
+        HANDLE mapping;
+#else
+        int file;
+#endif
+    };
+
+    inline uint32_t u16(const uint8_t* p) { return p[0] | p[1] << 8; }
+    inline uint32_t u32(const uint8_t* p) { return p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24; }
+
+    // Where each of R, G, B and A sits in a source pixel; 0x80 for a
+    // missing alpha, which pshufb turns into zero.
+    struct Swizzle {
+        int bytes;
+        uint8_t channel[4];
+    };
+
+    // The source row's byte order written out as packed RGBA8, with alpha
+    // set to 255 where the source has none.
+    inline void swizzleRow(const Swizzle& s, const uint8_t* src, uint8_t* dst, size_t from, size_t count) {
+        src += from * s.bytes;
+        dst += from * 4;
+        for (size_t x = 0; x < count; ++x, src += s.bytes, dst += 4) {
+            dst[0] = src[s.channel[0]];
+            dst[1] = src[s.channel[1]];
+            dst[2] = src[s.channel[2]];
+            dst[3] = s.channel[3] & 0x80 ? 255 : src[s.channel[3]];
+        }
+    }
+
+#ifdef LYNDA_X86
+    // pshufb control gathering four source pixels into four RGBA pixels.
+    inline __m128i shuffleControl(const Swizzle& s) {
+        alignas(16) uint8_t control[16];
+        for (int i = 0; i < 4; ++i)
+            for (int c = 0; c < 4; ++c)
+                control[i * 4 + c] = s.channel[c] & 0x80 ? 0x80 : static_cast<uint8_t>(i * s.bytes + s.channel[c]);
+        return _mm_load_si128(reinterpret_cast<const __m128i*>(control));
+    }
+
+    inline __m128i opaqueMask(const Swizzle& s) {
+        return _mm_set1_epi32(s.channel[3] & 0x80 ? static_cast<int>(0xFF000000u) : 0);
+    }
+
+    // Four pixels per step. Each load reads 16 bytes, more than four 24 bit
+    // pixels, so the last few pixels of a row go through swizzleRow rather
+    // than read past it.
+    LYNDA_TARGET("ssse3")
+    inline void swizzleRowSsse3(const Swizzle& s, const uint8_t* src, uint8_t* dst, size_t width) {
+        const __m128i control = shuffleControl(s), opaque = opaqueMask(s);
+        size_t x = 0;
+        for (; (width - x) * s.bytes >= 16; x += 4) {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * s.bytes));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_or_si128(_mm_shuffle_epi8(in, control), opaque));
+        }
+        swizzleRow(s, src, dst, x, width - x);
+    }
+
+    // Eight pixels per step, four per 128 bit lane, since vpshufb does not
+    // cross lanes.
+    LYNDA_TARGET("avx2")
+    inline void swizzleRowAvx2(const Swizzle& s, const uint8_t* src, uint8_t* dst, size_t width) {
+        const __m256i control = _mm256_broadcastsi128_si256(shuffleControl(s));
+        const __m256i opaque = _mm256_broadcastsi128_si256(opaqueMask(s));
+        const size_t half = 4 * s.bytes;
+        size_t x = 0;
+        for (; (width - x) * s.bytes >= half + 16; x += 8) {
+            const uint8_t* at = src + x * s.bytes;
+            __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(at))),
+                                                 _mm_loadu_si128(reinterpret_cast<const __m128i*>(at + half)), 1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), _mm256_or_si256(_mm256_shuffle_epi8(in, control), opaque));
+        }
+        swizzleRow(s, src, dst, x, width - x);
+    }
+
+    enum class Isa { Scalar, Ssse3, Avx2 };
+
+    inline Isa detectIsa() {
+        int info[4] = { 0, 0, 0, 0 };
+#ifdef _MSC_VER
+        __cpuid(info, 0);
+        int highest = info[0];
+        __cpuid(info, 1);
+#else
+        unsigned a, b, c, d;
+        int highest = __get_cpuid_max(0, nullptr);
+        __cpuid(1, a, b, c, d);
+        info[2] = static_cast<int>(c);
+#endif
+        bool ssse3 = (info[2] & 1 << 9) != 0;
+        bool osxsave = (info[2] & 1 << 27) != 0, avx = (info[2] & 1 << 28) != 0;
+        // AVX2 needs the OS to save the ymm registers too.
+        bool ymm = false;
+        if (osxsave && avx) {
+#ifdef _MSC_VER
+            ymm = (_xgetbv(0) & 6) == 6;
+#else
+            unsigned low, high;
+            __asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+            ymm = (low & 6) == 6;
+#endif
+        }
+        bool avx2 = false;
+        if (ymm && highest >= 7) {
+#ifdef _MSC_VER
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & 1 << 5) != 0;
+#else
+            __cpuid_count(7, 0, a, b, c, d);
+            avx2 = (b & 1 << 5) != 0;
+#endif
+        }
+        return avx2 ? Isa::Avx2 : ssse3 ? Isa::Ssse3 : Isa::Scalar;
+    }
+#endif
+
+    inline void swizzleRows(const Swizzle& s, const uint8_t* src, ptrdiff_t srcPitch, uint8_t* dst, size_t width, size_t rows) {
+#ifdef LYNDA_X86
+        static const Isa isa = detectIsa();
+#endif
+        for (size_t y = 0; y < rows; ++y, src += srcPitch, dst += width * 4) {
+#ifdef LYNDA_X86
+            if (isa == Isa::Avx2) { swizzleRowAvx2(s, src, dst, width); continue; }
+            if (isa == Isa::Ssse3) { swizzleRowSsse3(s, src, dst, width); continue; }
+#endif
+            swizzleRow(s, src, dst, 0, width);
+        }
+    }
+
+    // The byte a channel mask picks out of a pixel, or throws if the mask
+    // is not a whole byte.
+    inline uint8_t maskByte(uint32_t mask, int bytes) {
+        for (int i = 0; i < bytes; ++i)
+            if (mask == 0xFFu << (8 * i)) return static_cast<uint8_t>(i);
+        throw std::invalid_argument("Error: Unsupported Bitmap Channel Masks.");
+    }
+
+} //detail::
+
 
 struct Bitmap{
 
 
     int width;
     int height;
+    // Of pixels, which always hold RGBA8 whatever the file stored.
     short BitsPerPixel;
+    // Tightly packed rows, bottom row first as glTexImage2D expects.
     std::vector<unsigned char> pixels;
 
+    // Empty until load or decode fills it.
+    Bitmap() : width(0), height(0), BitsPerPixel(0){}
+
     Bitmap(const char* FilePath) : width(0), height(0), BitsPerPixel(0){
-      load(FilePath);  
+      load(FilePath);
     }
 
-    //adapted from http://stackoverflow.com/questions/20595340/loading-a-tga-bmp-file-in-c-opengl
+    // Reads 24 and 32 bit uncompressed or bit field bitmaps, with any of
+    // the header versions, stored bottom-up or top-down. The file is mapped
+    // rather than read, and its rows are converted to RGBA on all cores.
+    // A 32 bit file without an alpha mask loads opaque, since its fourth
+    // byte is unused.
     void load(const char* FilePath)
     {
-        std::fstream hFile;
-       
         //search for file by going up file directory tree up to 5 times
-        int attempts = 0;
-        string nfilepath = FilePath;
-        while (!hFile.is_open() && attempts < 5) {
-            hFile.open(nfilepath.c_str(), std::ios::in | std::ios::binary);
-            nfilepath = "../" + nfilepath;   
-            attempts += 1;
+        std::string nfilepath = FilePath;
+        for (int attempts = 1; attempts < 5; ++attempts) {
+            if (detail::MappedFile(nfilepath).exists()) break;
+            nfilepath = "../" + nfilepath;
         }
-        if (!hFile.is_open()) throw std::invalid_argument("Error: File Not Found.");
+        detail::MappedFile file(nfilepath);
+        if (!file.exists()) throw std::invalid_argument("Error: File Not Found.");
+        decode(file.data, file.size);
+    }
 
-        hFile.seekg(0, std::ios::end);
-        int Length = hFile.tellg();
-        hFile.seekg(0, std::ios::beg);
-        std::vector<uint8_t> FileInfo(Length);
-        hFile.read(reinterpret_cast<char*>(FileInfo.data()), 54);
+    void decode(const uint8_t* data, size_t size)
+    {
+        using detail::u16;
+        using detail::u32;
 
-        if(FileInfo[0] != 'B' && FileInfo[1] != 'M')
-        {
-            hFile.close();
+        // BITMAPFILEHEADER, then the size of the info header that follows.
+        if (size < 18 || data[0] != 'B' || data[1] != 'M')
             throw std::invalid_argument("Error: Invalid File Format. Bitmap Required.");
-        }
+        uint32_t pixelsOffset = u32(data + 10);
+        uint32_t infoSize = u32(data + 14);
+        if ((infoSize != 12 && infoSize < 40) || size < 14 + static_cast<uint64_t>(infoSize))
+            throw std::invalid_argument("Error: Invalid File Format. Bitmap Header Truncated.");
 
-        if (FileInfo[28] != 24 && FileInfo[28] != 32)
-        {
-            hFile.close();
+        const uint8_t* info = data + 14;
+        int64_t w, h;
+        uint32_t planes, bits, compression = 0;
+        if (infoSize == 12) {
+            // BITMAPCOREHEADER, with unsigned 16 bit sizes.
+            w = u16(info + 4);
+            h = u16(info + 6);
+            planes = u16(info + 8);
+            bits = u16(info + 10);
+        }
+        else {
+            w = static_cast<int32_t>(u32(info + 4));
+            h = static_cast<int32_t>(u32(info + 8));
+            planes = u16(info + 12);
+            bits = u16(info + 14);
+            compression = u32(info + 16);
+        }
+        if (planes != 1 || w <= 0 || h == 0 || h == INT32_MIN)
+            throw std::invalid_argument("Error: Invalid File Format. Bad Bitmap Dimensions.");
+        if (bits != 24 && bits != 32)
             throw std::invalid_argument("Error: Invalid File Format. 24 or 32 bit Image Required.");
+
+        // Stored BGR(X); bit fields may say otherwise for 32 bit pixels.
+        detail::Swizzle swizzle = { static_cast<int>(bits / 8), { 2, 1, 0, 0x80 } };
+        enum { BI_RGB = 0, BI_BITFIELDS = 3, BI_ALPHA_BITFIELDS = 6 };
+        if (compression == BI_BITFIELDS || compression == BI_ALPHA_BITFIELDS) {
+            if (bits != 32) throw std::invalid_argument("Error: Invalid File Format. Bit Fields Require 32 bit Pixels.");
+            // The masks follow a 40 byte header and are part of later ones.
+            bool alpha = compression == BI_ALPHA_BITFIELDS || infoSize >= 56;
+            size_t masksEnd = 14 + 40 + (alpha ? 16 : 12);
+            if (size < masksEnd) throw std::invalid_argument("Error: Invalid File Format. Bitmap Header Truncated.");
+            for (int c = 0; c < 3; ++c) swizzle.channel[c] = detail::maskByte(u32(info + 40 + 4 * c), 4);
+            uint32_t alphaMask = alpha ? u32(info + 52) : 0;
+            if (alphaMask) swizzle.channel[3] = detail::maskByte(alphaMask, 4);
         }
+        else if (compression != BI_RGB) {
+            throw std::invalid_argument("Error: Invalid File Format. Compressed Bitmaps Are Not Supported.");
+        }
+
+        // Rows are padded to four bytes, though the last may be cut short.
+        bool topDown = h < 0;
+        uint64_t rows = topDown ? -h : h;
+        uint64_t rowBytes = static_cast<uint64_t>(w) * (bits / 8);
+        uint64_t pitch = (rowBytes + 3) & ~uint64_t(3);
+        if (pixelsOffset < 14 + infoSize || pixelsOffset > size || size - pixelsOffset < rowBytes || (size - pixelsOffset - rowBytes) / pitch < rows - 1)
+            throw std::invalid_argument("Error: Invalid File Format. Bitmap Pixels Truncated.");
+
+        width = static_cast<int>(w);
+        height = static_cast<int>(rows);
+        BitsPerPixel = 32;
+        pixels.resize(static_cast<size_t>(w * rows * 4));
 
-        BitsPerPixel = FileInfo[28];
-        width = FileInfo[18] + (FileInfo[19] << 8);
-        height = FileInfo[22] + (FileInfo[23] << 8);
-        uint32_t pixelsOffset = FileInfo[10] + (FileInfo[11] << 8);
-        uint32_t size = ((width * BitsPerPixel + 31) / 32) * 4 * height;
-        pixels.resize(size);
+        // GL wants the bottom row first, so a top-down file is read upwards.
+        const uint8_t* first = data + pixelsOffset + (topDown ? (rows - 1) * pitch : 0);
+        ptrdiff_t step = topDown ? -static_cast<ptrdiff_t>(pitch) : static_cast<ptrdiff_t>(pitch);
+        size_t cols = static_cast<size_t>(w);
+        uint8_t* out = pixels.data();
 
-        hFile.seekg (pixelsOffset, std::ios::beg);
-        hFile.read(reinterpret_cast<char*>(pixels.data()), size);
-        hFile.close();
+        // Below this many pixels per worker, thread start-up costs more than it saves.
+        const size_t minimumPart = 1 << 18;
+        size_t parts = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u),
+                                        std::max<size_t>(cols * rows / minimumPart, 1));
+        auto band = [&](size_t begin, size_t end) {
+            detail::swizzleRows(swizzle, first + static_cast<ptrdiff_t>(begin) * step, step, out + begin * cols * 4, cols, end - begin);
+        };
+        std::vector<std::future<void>> workers;
+        for (size_t i = 1; i < parts; ++i)
+            workers.push_back(std::async(std::launch::async, band, rows * i / parts, rows * (i + 1) / parts));
+        band(0, rows / parts);
+        for (auto& worker : workers) worker.get();
     }
 
 };
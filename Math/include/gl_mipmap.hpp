@@ -0,0 +1,315 @@
+/*
+ * gl_mipmap.hpp
+ *
+ * Mip chains filtered on the CPU: box or Kaiser-windowed sinc levels,
+ * sRGB-aware, with their rows spread over threads.
+ */
+
+#ifndef  gl_mipmap_INC
+#define  gl_mipmap_INC
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+#include "gl_data.hpp"
+
+namespace lynda {
+
+  enum class MipFilter {
+    Box,      //<-- the mean of the texels each one covers
+    Kaiser    //<-- Kaiser-windowed sinc: keeps detail a box blurs, rings slightly at hard edges
+  };
+
+  // One level of a chain: packed rows, bottom row first.
+  struct MipLevel {
+    int width, height;
+    std::vector<uint8_t> texels;
+  };
+
+namespace detail {
+
+    // sRGB-encoded byte to linear light.
+    inline const float* srgbDecodeTable() {
+        static const std::vector<float> table = [] {
+            std::vector<float> t(256);
+            for (int i = 0; i < 256; ++i) {
+                double c = i / 255.0;
+                t[i] = static_cast<float>(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+            }
+            return t;
+        }();
+        return table.data();
+    }
+
+    // Linear light in steps of 1/65535 to the nearest sRGB-encoded byte.
+    // The steps are fine enough that rounding the input moves no output.
+    inline const uint8_t* srgbEncodeTable() {
+        static const std::vector<uint8_t> table = [] {
+            std::vector<uint8_t> t(65536);
+            for (int i = 0; i < 65536; ++i) {
+                double l = i / 65535.0;
+                double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1 / 2.4) - 0.055;
+                t[i] = static_cast<uint8_t>(c * 255 + 0.5);
+            }
+            return t;
+        }();
+        return table.data();
+    }
+
+    inline double besselI0(double x) {
+        double sum = 1, term = 1;
+        for (int k = 1; k < 64 && term > 1e-12 * sum; ++k) {
+            term *= (x / (2 * k)) * (x / (2 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // Sinc windowed to 3 texels of the level either side, with alpha 4.
+    inline double kaiserSinc(double d) {
+        const double radius = 3, alpha = 4, pi = 3.14159265358979323846;
+        if (std::fabs(d) >= radius) return 0;
+        double sinc = d == 0 ? 1 : std::sin(pi * d) / (pi * d);
+        double r = d / radius;
+        return sinc * besselI0(alpha * std::sqrt(1 - r * r)) / besselI0(alpha);
+    }
+
+    // How one axis of a level reads the full image: texel i of the level is
+    // the sum over t < count of weight[i * count + t] times full image texel
+    // index[i * count + t]. Taps past an edge read the edge texel.
+    struct Taps {
+        int count;
+        std::vector<int> index;
+        std::vector<float> weight;
+    };
+
+    inline Taps taps(int from, int to, MipFilter filter) {
+        const double scale = static_cast<double>(from) / to;
+        const double reach = filter == MipFilter::Box ? 0.5 : 3.0;
+        std::vector<std::vector<std::pair<int, double>>> all(to);
+        size_t count = 1;
+        for (int i = 0; i < to; ++i) {
+            double center = (i + 0.5) * scale;
+            int first = static_cast<int>(std::floor(center - reach * scale));
+            int last = static_cast<int>(std::ceil(center + reach * scale));
+            std::vector<std::pair<int, double>>& out = all[i];
+            double total = 0;
+            for (int j = first; j < last; ++j) {
+                double w = filter == MipFilter::Box
+                    ? std::min(j + 1.0, center + 0.5 * scale) - std::max(static_cast<double>(j), center - 0.5 * scale)
+                    : kaiserSinc((j + 0.5 - center) / scale);
+                if (w == 0) continue;
+                // Clamped taps land on the edge texel, so they are merged there.
+                int k = std::min(std::max(j, 0), from - 1);
+                if (!out.empty() && out.back().first == k) out.back().second += w;
+                else out.push_back(std::make_pair(k, w));
+                total += w;
+            }
+            for (auto& tap : out) tap.second /= total;
+            count = std::max(count, out.size());
+        }
+        Taps result = { static_cast<int>(count), std::vector<int>(to * count), std::vector<float>(to * count, 0.0f) };
+        for (int i = 0; i < to; ++i) {
+            for (size_t t = 0; t < count; ++t) {
+                // Short lists are padded with weightless reads of their last texel.
+                const std::pair<int, double>& tap = all[i][std::min(t, all[i].size() - 1)];
+                result.index[i * count + t] = tap.first;
+                result.weight[i * count + t] = t < all[i].size() ? static_cast<float>(tap.second) : 0.0f;
+            }
+        }
+        return result;
+    }
+
+    // dst = the sum of weights[t] * rows[t] over count floats.
+    inline void blendRows(const float* const* rows, const float* weights, int taps, float* dst, size_t from, size_t count) {
+        for (size_t k = from; k < count; ++k) {
+            float sum = 0;
+            for (int t = 0; t < taps; ++t) sum += weights[t] * rows[t][k];
+            dst[k] = sum;
+        }
+    }
+
+    // Texel x of dst is the weighted sum of the src texels its taps name,
+    // all four channels at once.
+    inline void filterRow(const Taps& h, const float* src, float* dst, int width) {
+        for (int x = 0; x < width; ++x) {
+            const int* index = &h.index[x * h.count];
+            const float* weight = &h.weight[x * h.count];
+            float sum[4] = { 0, 0, 0, 0 };
+            for (int t = 0; t < h.count; ++t)
+                for (int c = 0; c < 4; ++c) sum[c] += weight[t] * src[index[t] * 4 + c];
+            for (int c = 0; c < 4; ++c) dst[x * 4 + c] = sum[c];
+        }
+    }
+
+#ifdef LYNDA_X86
+    LYNDA_TARGET("sse2")
+    inline void blendRowsSse(const float* const* rows, const float* weights, int taps, float* dst, size_t count) {
+        size_t k = 0;
+        for (; k + 8 <= count; k += 8) {
+            __m128 a = _mm_setzero_ps(), b = _mm_setzero_ps();
+            for (int t = 0; t < taps; ++t) {
+                __m128 w = _mm_set1_ps(weights[t]);
+                a = _mm_add_ps(a, _mm_mul_ps(w, _mm_loadu_ps(rows[t] + k)));
+                b = _mm_add_ps(b, _mm_mul_ps(w, _mm_loadu_ps(rows[t] + k + 4)));
+            }
+            _mm_storeu_ps(dst + k, a);
+            _mm_storeu_ps(dst + k + 4, b);
+        }
+        blendRows(rows, weights, taps, dst, k, count);
+    }
+
+    // Sixteen floats a step, in two registers so each add need not wait
+    // on the one before.
+    LYNDA_TARGET("avx")
+    inline void blendRowsAvx(const float* const* rows, const float* weights, int taps, float* dst, size_t count) {
+        size_t k = 0;
+        for (; k + 16 <= count; k += 16) {
+            __m256 a = _mm256_setzero_ps(), b = _mm256_setzero_ps();
+            for (int t = 0; t < taps; ++t) {
+                __m256 w = _mm256_set1_ps(weights[t]);
+                a = _mm256_add_ps(a, _mm256_mul_ps(w, _mm256_loadu_ps(rows[t] + k)));
+                b = _mm256_add_ps(b, _mm256_mul_ps(w, _mm256_loadu_ps(rows[t] + k + 8)));
+            }
+            _mm256_storeu_ps(dst + k, a);
+            _mm256_storeu_ps(dst + k + 8, b);
+        }
+        blendRows(rows, weights, taps, dst, k, count);
+    }
+
+    // A texel's four channels fill one register.
+    LYNDA_TARGET("sse2")
+    inline void filterRowSse(const Taps& h, const float* src, float* dst, int width) {
+        for (int x = 0; x < width; ++x) {
+            const int* index = &h.index[x * h.count];
+            const float* weight = &h.weight[x * h.count];
+            __m128 sum = _mm_setzero_ps();
+            for (int t = 0; t < h.count; ++t)
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weight[t]), _mm_loadu_ps(src + index[t] * 4)));
+            _mm_storeu_ps(dst + x * 4, sum);
+        }
+    }
+#endif
+
+    // Calls work(i) for every i below count, spread over threads threads;
+    // 0 uses one per hardware thread.
+    template <typename Work>
+    inline void parallelFor(size_t count, unsigned threads, const Work& work) {
+        if (!threads) threads = std::max(std::thread::hardware_concurrency(), 1u);
+        size_t workers = std::min<size_t>(threads, count);
+        std::atomic<size_t> next(0);
+        auto run = [&] { for (size_t i; (i = next++) < count; ) work(i); };
+        std::vector<std::future<void>> pool;
+        for (size_t i = 1; i < workers; ++i) pool.push_back(std::async(std::launch::async, run));
+        run();
+        for (auto& worker : pool) worker.get();
+    }
+
+} //detail::
+
+  /*-----------------------------------------------------------------------------
+   *  Builds the levels below a width x height image of 1 to 4 byte channels,
+   *  pitch bytes a row (0 when packed), down to 1x1 or until there are
+   *  levels in all, the full image counting as the first. Sizes halve and
+   *  round down as GL's do.
+   *
+   *  When srgb is set the colour channels of a 3 or 4 channel image are
+   *  filtered as linear light, so a level keeps the brightness of the one
+   *  above rather than darkening as averaged sRGB values do; alpha and
+   *  other images are filtered as stored. Every level is filtered from the
+   *  full image, so no blur builds up from level to level and each can be
+   *  made apart from the rest: their rows are spread over threads threads
+   *  (0 for one per hardware thread), and each row is filtered down the
+   *  columns, sixteen floats a step with AVX on AVX2 machines or eight
+   *  with SSE, then along the row, a texel at a time with SSE. Edges clamp.
+   *-----------------------------------------------------------------------------*/
+  inline std::vector<MipLevel> mipChain(const uint8_t* pixels, int width, int height, int channels, bool srgb,
+                                        MipFilter filter = MipFilter::Kaiser, int levels = 0, size_t pitch = 0, unsigned threads = 0) {
+    if (!pixels || width <= 0 || height <= 0 || channels < 1 || channels > 4)
+      throw std::invalid_argument("Error: Mip Chain Needs an Image of 1 to 4 Channels.");
+    int full = 1;
+    for (int extent = std::max(width, height); extent > 1; extent >>= 1) ++full;
+    int count = levels > 0 ? std::min(levels, full) : full;
+    if (!pitch) pitch = static_cast<size_t>(width) * channels;
+
+    std::vector<MipLevel> chain(count - 1);
+    if (chain.empty()) return chain;
+    std::vector<detail::Taps> across, down;
+    for (int level = 1; level < count; ++level) {
+      MipLevel& mip = chain[level - 1];
+      mip.width = std::max(width >> level, 1);
+      mip.height = std::max(height >> level, 1);
+      mip.texels.resize(static_cast<size_t>(mip.width) * mip.height * channels);
+      across.push_back(detail::taps(width, mip.width, filter));
+      down.push_back(detail::taps(height, mip.height, filter));
+    }
+
+    const int encoded = srgb && channels >= 3 ? 3 : 0;
+    const float* decode = detail::srgbDecodeTable();
+    const uint8_t* encode = detail::srgbEncodeTable();
+#ifdef LYNDA_X86
+    static const detail::Isa isa = detail::detectIsa();
+#endif
+
+    // The full image as four floats a texel, whatever it stores.
+    const size_t stride = static_cast<size_t>(width) * 4;
+    std::vector<float> source(stride * height);
+    detail::parallelFor(height, threads, [&](size_t y) {
+      const uint8_t* in = pixels + y * pitch;
+      float* out = &source[y * stride];
+      for (int x = 0; x < width; ++x, in += channels, out += 4) {
+        for (int c = 0; c < 4; ++c)
+          out[c] = c >= channels ? 0.0f : c < encoded ? decode[in[c]] : in[c] / 255.0f;
+      }
+    });
+
+    // One task per row of every level, so the levels are made side by side.
+    std::vector<std::pair<int, int>> rows;
+    for (int level = 0; level < count - 1; ++level)
+      for (int y = 0; y < chain[level].height; ++y) rows.push_back(std::make_pair(level, y));
+
+    detail::parallelFor(rows.size(), threads, [&](size_t i) {
+      const int level = rows[i].first, y = rows[i].second;
+      const detail::Taps& v = down[level];
+      const detail::Taps& h = across[level];
+      MipLevel& mip = chain[level];
+
+      std::vector<const float*> taps(v.count);
+      for (int t = 0; t < v.count; ++t) taps[t] = &source[v.index[y * v.count + t] * stride];
+      std::vector<float> column(stride), row(static_cast<size_t>(mip.width) * 4);
+      const float* weights = &v.weight[y * v.count];
+#ifdef LYNDA_X86
+      if (isa == detail::Isa::Avx2) detail::blendRowsAvx(taps.data(), weights, v.count, column.data(), stride);
+      else if (isa != detail::Isa::Scalar) detail::blendRowsSse(taps.data(), weights, v.count, column.data(), stride);
+      else
+#endif
+      detail::blendRows(taps.data(), weights, v.count, column.data(), 0, stride);
+#ifdef LYNDA_X86
+      if (isa != detail::Isa::Scalar) detail::filterRowSse(h, column.data(), row.data(), mip.width);
+      else
+#endif
+      detail::filterRow(h, column.data(), row.data(), mip.width);
+
+      // Sinc lobes can overshoot, so values are clamped before encoding.
+      uint8_t* out = &mip.texels[static_cast<size_t>(y) * mip.width * channels];
+      for (int x = 0; x < mip.width; ++x, out += channels) {
+        for (int c = 0; c < channels; ++c) {
+          float value = std::min(std::max(row[x * 4 + c], 0.0f), 1.0f);
+          out[c] = c < encoded ? encode[static_cast<int>(value * 65535 + 0.5f)] : static_cast<uint8_t>(value * 255 + 0.5f);
+        }
+      }
+    });
+    return chain;
+  }
+
+} //lynda::
+
+#endif   /* ----- #ifndef gl_mipmap_INC  ----- */
@@ -3,7 +3,7 @@
  *
  *       Filename:  gl_texture.hpp
  *
- *    Description:  2D RGBA floats texture generation 
+ *    Description:  2D RGBA8 texture generation 
  *
  *    Note: include OpenGL first
  *
@@ -18,14 +18,74 @@
  * =====================================================================================
  */
 
+#include <algorithm>
+#include <vector>
+
+#include "gl_mipmap.hpp"
 
 namespace lynda {
 
+  // A region of a texture level, in texels.
+  struct Rect {
+    int x, y, width, height;
+
+    int right() const { return x + width; }
+    int top() const { return y + height; }
+    long long area() const { return (long long)width * height; }
+  };
+
+  /*-----------------------------------------------------------------------------
+   *  Clips rects to a width x height image and merges them wherever one
+   *  upload of the bounding box costs less than two separate ones. Each
+   *  upload is charged callCost texels on top of its area, so strokes of
+   *  small overlapping dabs become a few calls while far apart edits stay
+   *  apart.
+   *-----------------------------------------------------------------------------*/
+  inline std::vector<Rect> coalesce(const std::vector<Rect>& rects, int width, int height, long long callCost = 64 * 64) {
+    std::vector<Rect> out;
+    for (const Rect& r : rects) {
+      int x0 = std::max(r.x, 0), y0 = std::max(r.y, 0);
+      int x1 = std::min(r.right(), width), y1 = std::min(r.top(), height);
+      if (x0 < x1 && y0 < y1) out.push_back(Rect{ x0, y0, x1 - x0, y1 - y0 });
+    }
+    for (bool merged = true; merged; ) {
+      merged = false;
+      for (size_t i = 0; i < out.size(); ++i) {
+        for (size_t j = i + 1; j < out.size(); ++j) {
+          const Rect& a = out[i];
+          const Rect& b = out[j];
+          Rect u = { std::min(a.x, b.x), std::min(a.y, b.y), 0, 0 };
+          u.width = std::max(a.right(), b.right()) - u.x;
+          u.height = std::max(a.top(), b.top()) - u.y;
+          long long ix = std::max(0, std::min(a.right(), b.right()) - std::max(a.x, b.x));
+          long long iy = std::max(0, std::min(a.top(), b.top()) - std::max(a.y, b.y));
+          if (u.area() > a.area() + b.area() - ix * iy + callCost) continue;
+          out[i] = u;
+          out.erase(out.begin() + j);
+          merged = true;
+          j = i;
+        }
+      }
+    }
+    return out;
+  }
+
   struct Texture {
 
     GLuint tID;
     int width, height;
 
+    // What an update does to the smaller mip levels.
+    enum class Mipmaps {
+      Full,       //<-- glGenerateMipmap over the whole texture
+      Dirty,      //<-- rebuild only what lies under the dirty rects, on every level
+      Defer,      //<-- remember those regions until generateMipmaps()
+      None        //<-- leave them as they are
+    };
+
+    // Level 0 regions whose smaller levels are out of date.
+    std::vector<Rect> stale;
+
     GLuint id() const { return tID; }
     
     Texture(int w, int h) : width(w), height(h) {
@@ -41,10 +101,19 @@ namespace lynda {
       glBindTexture(GL_TEXTURE_2D, tID); 
 
       /*-----------------------------------------------------------------------------
-       *  Allocate Memory on the GPU
+       *  Allocate Memory on the GPU: 4 bytes a texel, for every mip level
        *-----------------------------------------------------------------------------*/
-       // target | lod | internal_format | width | height | border | format | type | data
-      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+      int levels = 1;
+      for (int extent = std::max(width, height); extent > 1; extent >>= 1) ++levels;
+      if (GLEW_VERSION_4_2 || GLEW_ARB_texture_storage) {
+        // target | levels | internal_format | width | height
+        glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, width, height);
+      } else {
+        // target | lod | internal_format | width | height | border | format | type | data
+        for (int level = 0; level < levels; ++level)
+          glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, std::max(width >> level, 1), std::max(height >> level, 1), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+      }
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
         
       /*-----------------------------------------------------------------------------
        *  Set Texture Parameters
@@ -69,19 +138,133 @@ namespace lynda {
     void unbind() { glBindTexture(GL_TEXTURE_2D, 0); }
 
 
-    void update(void * data){
+    // data holds width x height RGBA texels of the given type; bytes are
+    // stored as they are, other types are converted on upload.
+    void update(void * data, GLenum type = GL_UNSIGNED_BYTE){
        
        bind(); 
       /*-----------------------------------------------------------------------------
        *  Load data onto GPU
        *-----------------------------------------------------------------------------*/
       // target | lod | xoffset | yoffset | width | height | format | type | data
-	    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_FLOAT, data );
+	    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, type, data );
       glGenerateMipmap(GL_TEXTURE_2D);
+      stale.clear();
 
       unbind();
 
     }
+
+    // data holds width x height RGBA bytes; the mip levels are filtered on
+    // the CPU rather than by glGenerateMipmap, in linear light when srgb
+    // says the colour is sRGB-encoded, so every driver gets the same
+    // levels. For images made once; updates every frame are cheaper on
+    // the GPU.
+    void load(const void * data, MipFilter filter = MipFilter::Kaiser, bool srgb = true){
+
+      bind();
+      // target | lod | xoffset | yoffset | width | height | format | type | data
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+      std::vector<MipLevel> chain = mipChain(static_cast<const uint8_t*>(data), width, height, 4, srgb, filter);
+      for (size_t i = 0; i < chain.size(); ++i)
+        glTexSubImage2D(GL_TEXTURE_2D, (GLint)i + 1, 0, 0, chain[i].width, chain[i].height, GL_RGBA, GL_UNSIGNED_BYTE, chain[i].texels.data());
+      stale.clear();
+
+      unbind();
+
+    }
+
+    // Uploads only the dirty rects of data, which still holds the whole
+    // width x height image, and brings the mip levels up to date as asked.
+    void update(const void * data, const std::vector<Rect>& dirty, Mipmaps mipmaps = Mipmaps::Dirty, GLenum type = GL_UNSIGNED_BYTE){
+
+      std::vector<Rect> regions = coalesce(dirty, width, height);
+      if (regions.empty()) return;
+
+      bind();
+      /*-----------------------------------------------------------------------------
+       *  Load each region onto GPU, picked out of the full image by the unpack state
+       *-----------------------------------------------------------------------------*/
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+      for (const Rect& r : regions) {
+        glPixelStorei(GL_UNPACK_SKIP_PIXELS, r.x);
+        glPixelStorei(GL_UNPACK_SKIP_ROWS, r.y);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, r.x, r.y, r.width, r.height, GL_RGBA, type, data);
+      }
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+      glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+      glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+
+      switch (mipmaps) {
+      case Mipmaps::Full:
+        glGenerateMipmap(GL_TEXTURE_2D);
+        stale.clear();
+        break;
+      case Mipmaps::Dirty:
+        stale.insert(stale.end(), regions.begin(), regions.end());
+        generateMipmaps();
+        break;
+      case Mipmaps::Defer:
+        stale.insert(stale.end(), regions.begin(), regions.end());
+        break;
+      case Mipmaps::None:
+        break;
+      }
+
+      unbind();
+
+    }
+
+    /*-----------------------------------------------------------------------------
+     *  Rebuilds the stale regions of every smaller level, each from the one
+     *  above it. A linear 2:1 blit averages each 2x2 block as glGenerateMipmap
+     *  does, without touching the rest of the level. An odd side drops its
+     *  last texel, where drivers may filter it in, so on a non power of two
+     *  texture keep to one of Dirty and Full.
+     *-----------------------------------------------------------------------------*/
+    void generateMipmaps(){
+
+      if (stale.empty()) return;
+      std::vector<Rect> regions = coalesce(stale, width, height);
+      stale.clear();
+
+      GLint readFramebuffer, drawFramebuffer;
+      glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+      glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+      GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+      glDisable(GL_SCISSOR_TEST);
+
+      GLuint framebuffers[2];
+      glGenFramebuffers(2, framebuffers);
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+
+      for (int level = 1; (width >> level) || (height >> level); ++level) {
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tID, level - 1);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tID, level);
+        int w = std::max(width >> level, 1), h = std::max(height >> level, 1);
+        // A side already down to 1 stays 1 rather than halving.
+        int sx = (width >> (level - 1)) > 1 ? 2 : 1, sy = (height >> (level - 1)) > 1 ? 2 : 1;
+        for (Rect& r : regions) {
+          // Every texel of this level that one of the region's fed into.
+          int x1 = std::min((r.right() + sx - 1) / sx, w), y1 = std::min((r.top() + sy - 1) / sy, h);
+          r.x /= sx;
+          r.y /= sy;
+          r.width = x1 - r.x;
+          r.height = y1 - r.y;
+          glBlitFramebuffer(r.x * sx, r.y * sy, r.right() * sx, r.top() * sy,
+                            r.x, r.y, r.right(), r.top(), GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        }
+        // Regions meet as they shrink.
+        regions = coalesce(regions, w, h);
+      }
+
+      glDeleteFramebuffers(2, framebuffers);
+      glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer);
+      glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+      if (scissor) glEnable(GL_SCISSOR_TEST);
+
+    }
     
 
   };
@@ -18,6 +18,7 @@
 #include "glfw_app.hpp"
 #include "gl_shader.hpp"
 #include "gl_macros.hpp"
+#include "gl_mipmap.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -114,18 +115,19 @@ struct MyApp : App {
 
 
         /*-----------------------------------------------------------------------------
-         *  Make some rgba data (can also load a file here)
+         *  Make some rgba data, a byte per channel (can also load a file here)
          *-----------------------------------------------------------------------------*/
         tw = 40;
         th = 40;
-        vector<vec4> data;
+        vector<GLubyte> data;
 
         bool checker = false;
         for (int i = 0; i < tw; ++i) {
-            float tu = (float)i / tw;
+            GLubyte tu = (GLubyte)(255 * i / tw);
             for (int j = 0; j < th; ++j) {
-                float tv = (float)j / th;
-                data.push_back(vec4(tu, 0, tv, checker));
+                GLubyte tv = (GLubyte)(255 * j / th);
+                GLubyte texel[] = { tu, 0, tv, (GLubyte)(checker ? 255 : 0) };
+                data.insert(data.end(), texel, texel + 4);
                 checker = !checker;
             }
             checker = !checker;
@@ -195,20 +197,36 @@ struct MyApp : App {
         glBindTexture(GL_TEXTURE_2D, tID);
 
         /*-----------------------------------------------------------------------------
-         *  Allocate Memory on the GPU
+         *  Allocate Memory on the GPU: 4 bytes a texel, for every mip level
          *-----------------------------------------------------------------------------*/
-         // target | lod | internal_format | width | height | border | format | type | data
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tw, th, 0, GL_RGBA, GL_FLOAT, NULL);
+        int levels = 1;
+        for (int extent = tw > th ? tw : th; extent > 1; extent >>= 1) ++levels;
+        if (GLEW_VERSION_4_2 || GLEW_ARB_texture_storage) {
+            // target | levels | internal_format | width | height
+            glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, tw, th);
+        }
+        else {
+            // target | lod | internal_format | width | height | border | format | type | data
+            for (int level = 0; level < levels; ++level) {
+                glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, tw >> level ? tw >> level : 1, th >> level ? th >> level : 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            }
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
 
         /*-----------------------------------------------------------------------------
          *  Load data onto GPU
          *-----------------------------------------------------------------------------*/
          // target | lod | xoffset | yoffset | width | height | format | type | data
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tw, th, GL_RGBA, GL_FLOAT, &(data[0]));
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tw, th, GL_RGBA, GL_UNSIGNED_BYTE, &(data[0]));
 
         //Mipmaps are good -- the regenerate the texture at various scales
-        // and are necessary to avoid black screen if texParameters below are not set
-        glGenerateMipmap(GL_TEXTURE_2D);
+        // and are necessary to avoid black screen if texParameters below are not set.
+        // They are filtered here rather than by glGenerateMipmap, in linear light,
+        // so they look the same on every driver
+        vector<lynda::MipLevel> mips = lynda::mipChain(&(data[0]), tw, th, 4, true);
+        for (size_t level = 0; level < mips.size(); ++level) {
+            glTexSubImage2D(GL_TEXTURE_2D, (GLint)level + 1, 0, 0, mips[level].width, mips[level].height, GL_RGBA, GL_UNSIGNED_BYTE, &(mips[level].texels[0]));
+        }
 
         // Set these parameters to avoid a black screen
         // caused by improperly mipmapped textures
@@ -9,8 +9,6 @@
 
 #include "Display.h"
 
-#include "glm/gtc/type_ptr.hpp"
-
 Display::Display(sdl::Library& context, int width, int height)
 {
     context.gl[sdl::gl::ProfileMask] = SDL_GL_CONTEXT_PROFILE_CORE;
@@ -26,7 +24,8 @@ Display::Display(sdl::Library& context, int width, int height)
     glGetError();
 #endif
     
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_FLOAT, glm::value_ptr(glm::vec4(1.0f)));
+    const GLubyte white[] = { 255, 255, 255, 255 };
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
     
     glClearColor( 0.0f, 0.0f, 0.0f, 0.0f );
     glClearDepth( 1.0f );
@@ -0,0 +1,106 @@
+#include "AssetStream.h"
+
+#include <algorithm>
+#include <exception>
+using namespace std;
+
+namespace gl {
+    AssetStream::AssetStream(size_t frameBudget, unsigned workers, size_t capacity)
+    :   _budget{ max<size_t>(frameBudget, 1) }, _capacity{ max<size_t>(capacity, 1) },
+        _outstanding{ 0 }, _stopping{ false }, _offset{ 0 }
+    {
+        for (unsigned i = 0; i < max(workers, 1u); ++i) { _workers.emplace_back(&AssetStream::Work, this); }
+    }
+
+    AssetStream::~AssetStream()
+    {
+        {
+            lock_guard<mutex> hold{ _lock };
+            _stopping = true;
+        }
+        _requested.notify_all();
+        _drained.notify_all();
+        for (auto& worker : _workers) { worker.join(); }
+        // Anything still queued is dropped; its promise breaks and the
+        // handle reports broken_promise.
+    }
+
+    AssetStream::MeshHandle AssetStream::Load(const string& filename)
+    {
+        Request request{ filename, {} };
+        MeshHandle handle = request.result.get_future().share();
+        {
+            lock_guard<mutex> hold{ _lock };
+            _requests.push_back(move(request));
+            ++_outstanding;
+        }
+        _requested.notify_one();
+        return handle;
+    }
+
+    size_t AssetStream::pending() const
+    {
+        lock_guard<mutex> hold{ _lock };
+        return _outstanding;
+    }
+
+    void AssetStream::Work()
+    {
+        for (;;) {
+            Request request;
+            {
+                unique_lock<mutex> hold{ _lock };
+                _requested.wait(hold, [this] { return _stopping || !_requests.empty(); });
+                if (_stopping) { return; }
+                request = move(_requests.front());
+                _requests.pop_front();
+            }
+
+            Decoded decoded;
+            decoded.result = move(request.result);
+            try {
+                decoded.source.reset(new Mesh::Source{ request.filename });
+            }
+            catch (...) {
+                decoded.result.set_exception(current_exception());
+                lock_guard<mutex> hold{ _lock };
+                --_outstanding;
+                continue;
+            }
+
+            unique_lock<mutex> hold{ _lock };
+            _drained.wait(hold, [this] { return _stopping || _decoded.size() < _capacity; });
+            if (_stopping) { return; }
+            _decoded.push_back(move(decoded));
+        }
+    }
+
+    size_t AssetStream::Upload()
+    {
+        size_t sent = 0;
+        while (sent < _budget) {
+            if (!_current) {
+                {
+                    lock_guard<mutex> hold{ _lock };
+                    if (_decoded.empty()) { break; }
+                    _current.reset(new Decoded{ move(_decoded.front()) });
+                    _decoded.pop_front();
+                }
+                _drained.notify_one();
+                _mesh = make_shared<Mesh>(*_current->source, false);
+                _offset = 0;
+            }
+
+            size_t count = _mesh->Upload(*_current->source, _offset, _budget - sent);
+            _offset += count;
+            sent += count;
+            if (_offset < _current->source->bytes()) { continue; }
+
+            _current->result.set_value(move(_mesh));
+            _current.reset();
+            lock_guard<mutex> hold{ _lock };
+            --_outstanding;
+        }
+        return sent;
+    }
+}
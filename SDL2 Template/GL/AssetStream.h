@@ -0,0 +1,75 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_ASSETSTREAM
+#define OPENGL_WRAPPER_ASSETSTREAM
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Mesh.h"
+
+namespace gl {
+    // Loads assets without stalling the render thread. Worker threads read
+    // and decode files into CPU-side blobs and hand them to a bounded
+    // queue; the GL thread drains that queue a few megabytes per frame,
+    // and each handle becomes ready once its asset is fully on the GPU.
+    class AssetStream {
+    public:
+        using MeshHandle = std::shared_future<std::shared_ptr<const Mesh>>;
+
+        // capacity bounds how many decoded assets may wait for upload, so
+        // workers stall instead of filling memory when the GL falls behind.
+        explicit AssetStream(std::size_t frameBudget = 4 << 20, unsigned workers = 1, std::size_t capacity = 4);
+        ~AssetStream();
+
+        AssetStream(const AssetStream&) = delete;
+        AssetStream& operator= (const AssetStream&) = delete;
+
+        // Safe from any thread. A file that fails to load throws from get().
+        MeshHandle Load(const std::string& filename);
+
+        // Call on the GL thread once per frame. Uploads queued data until
+        // the frame budget is spent, always making some progress, and
+        // returns the number of bytes sent.
+        std::size_t Upload();
+
+        // Assets requested but not yet resident.
+        std::size_t pending() const;
+    private:
+        struct Request {
+            std::string filename;
+            std::promise<std::shared_ptr<const Mesh>> result;
+        };
+        struct Decoded {
+            std::unique_ptr<Mesh::Source> source;
+            std::promise<std::shared_ptr<const Mesh>> result;
+        };
+
+        std::size_t _budget;
+        std::size_t _capacity;
+
+        mutable std::mutex _lock;
+        std::condition_variable _requested, _drained;
+        std::deque<Request> _requests;
+        std::deque<Decoded> _decoded;
+        std::size_t _outstanding;
+        bool _stopping;
+        std::vector<std::thread> _workers;
+
+        // Touched only by the GL thread.
+        std::unique_ptr<Decoded> _current;
+        std::shared_ptr<Mesh> _mesh;
+        std::size_t _offset;
+
+        void Work();
+    };
+}
+
+#endif
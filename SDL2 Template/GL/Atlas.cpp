@@ -0,0 +1,344 @@
+#include "Atlas.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+using namespace std;
+
+namespace {
+    size_t Align(size_t offset)
+    {
+        return (offset + gl::AtlasFile::Alignment - 1) & ~(gl::AtlasFile::Alignment - 1);
+    }
+}
+
+namespace gl {
+    static_assert(is_standard_layout<AtlasFile::Header>::value && sizeof(AtlasFile::Header) == 72, "cooked atlas header layout changed");
+    static_assert(is_standard_layout<AtlasFile::Region>::value && sizeof(AtlasFile::Region) == 24, "cooked atlas region layout changed");
+
+    SkylinePacker::SkylinePacker(Size width, Size height)
+    :   _width{ width }, _height{ height }, _skyline{ Segment{ 0, 0, width } }
+    {}
+
+    bool SkylinePacker::Fit(size_t index, Size width, Size height, Int& y, int64_t& waste) const
+    {
+        Int x = _skyline[index].x;
+        if (x + width > _width) { return false; }
+        // The rectangle rests on the highest segment it spans.
+        y = 0;
+        for (size_t i = index; i < _skyline.size() && _skyline[i].x < x + width; ++i) { y = max(y, _skyline[i].y); }
+        if (y + height > _height) { return false; }
+        waste = 0;
+        for (size_t i = index; i < _skyline.size() && _skyline[i].x < x + width; ++i) {
+            Int covered = min(_skyline[i].x + _skyline[i].width, x + width) - _skyline[i].x;
+            waste += int64_t{ y - _skyline[i].y } * covered;
+        }
+        return true;
+    }
+
+    bool SkylinePacker::Insert(Size width, Size height, Int& x, Int& y)
+    {
+        if (width <= 0 || height <= 0) { throw invalid_argument{ "Packed rectangles must not be empty" }; }
+        size_t best = _skyline.size();
+        Int bestY = 0;
+        int64_t bestWaste = 0;
+        for (size_t i = 0; i < _skyline.size(); ++i) {
+            Int at;
+            int64_t waste;
+            if (!Fit(i, width, height, at, waste)) { continue; }
+            if (best == _skyline.size() || at < bestY || (at == bestY && waste < bestWaste)) {
+                best = i;
+                bestY = at;
+                bestWaste = waste;
+            }
+        }
+        if (best == _skyline.size()) { return false; }
+
+        x = _skyline[best].x;
+        y = bestY;
+        // The rectangle's top replaces the skyline under it.
+        _skyline.insert(_skyline.begin() + best, Segment{ x, y + height, width });
+        Int end = x + width;
+        for (size_t i = best + 1; i < _skyline.size() && _skyline[i].x < end; ) {
+            Segment& segment = _skyline[i];
+            if (segment.x + segment.width <= end) {
+                _skyline.erase(_skyline.begin() + i);
+                continue;
+            }
+            segment.width -= end - segment.x;
+            segment.x = end;
+            break;
+        }
+        for (size_t i = 1; i < _skyline.size(); ) {
+            if (_skyline[i].y == _skyline[i - 1].y) {
+                _skyline[i - 1].width += _skyline[i].width;
+                _skyline.erase(_skyline.begin() + i);
+            }
+            else { ++i; }
+        }
+        return true;
+    }
+
+    Size SkylinePacker::height() const
+    {
+        Int top = 0;
+        for (const Segment& segment : _skyline) { top = max(top, segment.y); }
+        return top;
+    }
+
+    AtlasLayout PackAtlas(const vector<Texture::Image>& images, const AtlasSettings& settings)
+    {
+        if (settings.levels < 1 || settings.levels > 16) { throw invalid_argument{ "Atlas must keep 1 to 16 mip levels" }; }
+        if (settings.padding < 0) { throw invalid_argument{ "Atlas padding must not be negative" }; }
+        AtlasLayout layout{ 0, 0, images.empty() ? 4 : images.front().channels, settings.levels, 0, {} };
+        for (const Texture::Image& image : images) {
+            if (image.width <= 0 || image.height <= 0) { throw invalid_argument{ "Atlas image is empty" }; }
+            if (image.channels != layout.channels) { throw invalid_argument{ "Atlas images must all have the same channel count" }; }
+        }
+
+        // Cells are placed in units of the texels one texel of the last
+        // kept level covers, so none straddles two cells on any level.
+        const Size unit = Size{ 1 } << (settings.levels - 1);
+        layout.gutter = settings.levels > 1 ? max(settings.padding, unit) : settings.padding;
+        auto cells = [&](Size extent) { return (extent + 2 * layout.gutter + unit - 1) / unit; };
+
+        // Tallest first keeps the skyline flat; widest first breaks ties.
+        vector<size_t> order(images.size());
+        iota(order.begin(), order.end(), size_t{ 0 });
+        sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            Size ha = cells(images[a].height), hb = cells(images[b].height);
+            return ha != hb ? ha > hb : cells(images[a].width) > cells(images[b].width);
+        });
+
+        const Size limit = settings.maxSize / unit;
+        int64_t area = 0;
+        Size widest = 1, tallest = 1;
+        for (const Texture::Image& image : images) {
+            area += int64_t{ cells(image.width) } * cells(image.height);
+            widest = max(widest, cells(image.width));
+            tallest = max(tallest, cells(image.height));
+        }
+        if (widest > limit || tallest > limit) { throw length_error{ "Atlas image is larger than the atlas may grow" }; }
+
+        // Widths from the square that could hold everything upwards; a
+        // wider atlas is kept only while it is smaller.
+        Size widestAllowed = 1;
+        while (widestAllowed <= limit / 2) { widestAllowed <<= 1; }
+        Size width = 1;
+        while (width < widest || int64_t{ width } * width < area) { width <<= 1; }
+        width = min(width, widestAllowed);
+        vector<Int> xs(images.size()), ys(images.size());
+        int64_t bestArea = numeric_limits<int64_t>::max();
+        for (; width <= widestAllowed; width <<= 1) {
+            SkylinePacker packer{ width, limit };
+            vector<Int> x(images.size()), y(images.size());
+            bool placed = true;
+            for (size_t i : order) {
+                if (!packer.Insert(cells(images[i].width), cells(images[i].height), x[i], y[i])) {
+                    placed = false;
+                    break;
+                }
+            }
+            if (!placed) { continue; }
+            Size height = max<Size>(packer.height(), 1);
+            if (int64_t{ width } * height < bestArea) {
+                bestArea = int64_t{ width } * height;
+                layout.width = width * unit;
+                layout.height = height * unit;
+                xs.swap(x);
+                ys.swap(y);
+            }
+            if (height <= width) { break; }
+        }
+        if (bestArea == numeric_limits<int64_t>::max()) { throw length_error{ "Atlas images do not fit in the largest atlas allowed" }; }
+
+        layout.regions.reserve(images.size());
+        for (size_t i = 0; i < images.size(); ++i) {
+            AtlasRegion region;
+            region.x = xs[i] * unit + layout.gutter;
+            region.y = ys[i] * unit + layout.gutter;
+            region.width = images[i].width;
+            region.height = images[i].height;
+            Vector2 size{ static_cast<Float>(layout.width), static_cast<Float>(layout.height) };
+            region.lower = Vector2{ region.x, region.y } / size;
+            region.extent = Vector2{ region.width, region.height } / size;
+            layout.regions.push_back(region);
+        }
+        return layout;
+    }
+
+    vector<Ubyte> ComposeAtlas(const vector<Texture::Image>& images, const AtlasLayout& layout)
+    {
+        if (images.size() != layout.regions.size()) { throw invalid_argument{ "Atlas layout is for a different set of images" }; }
+        const size_t channels = layout.channels;
+        const size_t pitch = static_cast<size_t>(layout.width) * channels;
+        vector<Ubyte> pixels(pitch * layout.height);
+
+        for (size_t i = 0; i < images.size(); ++i) {
+            const Texture::Image& image = images[i];
+            const AtlasRegion& region = layout.regions[i];
+            if (image.width != region.width || image.height != region.height || static_cast<size_t>(image.channels) != channels || !image.pixels) {
+                throw invalid_argument{ "Atlas layout is for a different set of images" };
+            }
+            size_t rowBytes = static_cast<size_t>(image.width) * channels;
+            size_t source = image.pitch ? image.pitch : rowBytes;
+            Int left = max(region.x - layout.gutter, 0);
+            Int right = min(region.x + region.width + layout.gutter, layout.width);
+            Int bottom = max(region.y - layout.gutter, 0);
+            Int top = min(region.y + region.height + layout.gutter, layout.height);
+
+            // Each row, then its edge texels repeated out to either side.
+            for (Size row = 0; row < region.height; ++row) {
+                Ubyte* out = pixels.data() + (region.y + row) * pitch;
+                const Ubyte* in = image.pixels + row * source;
+                memcpy(out + region.x * channels, in, rowBytes);
+                for (Int x = left; x < region.x; ++x) { memcpy(out + x * channels, in, channels); }
+                for (Int x = region.x + region.width; x < right; ++x) { memcpy(out + x * channels, in + rowBytes - channels, channels); }
+            }
+            // Then the first and last rows, corners and all, out to either end.
+            size_t span = (right - left) * channels;
+            const Ubyte* first = pixels.data() + region.y * pitch + left * channels;
+            const Ubyte* last = pixels.data() + (region.y + region.height - 1) * pitch + left * channels;
+            for (Int y = bottom; y < region.y; ++y) { memcpy(pixels.data() + y * pitch + left * channels, first, span); }
+            for (Int y = region.y + region.height; y < top; ++y) { memcpy(pixels.data() + y * pitch + left * channels, last, span); }
+        }
+        return pixels;
+    }
+
+    bool AtlasFile::Identify(const io::MappedFile& source)
+    {
+        return source.size() >= sizeof(Uint) && *reinterpret_cast<const Uint*>(source.data()) == Signature;
+    }
+
+    AtlasFile::AtlasFile(const io::MappedFile& source)
+    :   _base{ source.data() }, _header{ reinterpret_cast<const Header*>(source.data()) }
+    {
+        if (source.size() < sizeof(Header) || _header->signature != Signature) { throw invalid_argument{ "Not a cooked atlas" }; }
+        if (_header->version != Version) { throw invalid_argument{ "Unsupported cooked atlas version " + to_string(_header->version) }; }
+        if (_header->width <= 0 || _header->height <= 0 || _header->channels < 1 || _header->channels > 4 || _header->gutter < 0
+            || _header->levels < 1 || _header->levels > Texture::Levels(_header->width, _header->height) || _header->encoding > static_cast<Uint>(Texture::Encoding::Srgb)) {
+            throw invalid_argument{ "Cooked atlas has an invalid size" };
+        }
+
+        auto fits = [&](uint64_t offset, uint64_t bytes) {
+            return offset % Alignment == 0 && offset <= source.size() && bytes <= source.size() - offset;
+        };
+        if (!fits(_header->regionOffset, uint64_t{ _header->regionCount } * sizeof(Region))
+            || !fits(_header->stringOffset, _header->stringSize)
+            || !fits(_header->pixelOffset, 0)) {
+            throw invalid_argument{ "Cooked atlas is truncated" };
+        }
+        uint64_t offset = _header->pixelOffset;
+        for (Size level = 0; level < _header->levels; ++level) {
+            uint64_t bytes = uint64_t{ static_cast<Uint>(max(_header->width >> level, 1)) } * static_cast<Uint>(max(_header->height >> level, 1)) * static_cast<Uint>(_header->channels);
+            if (!fits(offset, bytes)) { throw invalid_argument{ "Cooked atlas is truncated" }; }
+            offset = Align(offset + bytes);
+        }
+
+        auto records = reinterpret_cast<const Region*>(_base + _header->regionOffset);
+        for (Uint r = 0; r < _header->regionCount; ++r) {
+            const Region& record = records[r];
+            if (uint64_t{ record.name } + record.nameLength > _header->stringSize) { throw invalid_argument{ "Cooked atlas has an invalid region name" }; }
+            if (record.x < 0 || record.y < 0 || record.width <= 0 || record.height <= 0
+                || record.x + int64_t{ record.width } > _header->width || record.y + int64_t{ record.height } > _header->height) {
+                throw invalid_argument{ "Cooked atlas has a region outside it" };
+            }
+        }
+    }
+
+    AtlasLayout AtlasFile::layout() const
+    {
+        AtlasLayout result{ _header->width, _header->height, _header->channels, _header->levels, _header->gutter, {} };
+        Vector2 size{ static_cast<Float>(_header->width), static_cast<Float>(_header->height) };
+        auto records = reinterpret_cast<const Region*>(_base + _header->regionOffset);
+        result.regions.reserve(_header->regionCount);
+        for (Uint r = 0; r < _header->regionCount; ++r) {
+            const Region& record = records[r];
+            result.regions.push_back(AtlasRegion{ record.x, record.y, record.width, record.height,
+                Vector2{ record.x, record.y } / size, Vector2{ record.width, record.height } / size });
+        }
+        return result;
+    }
+
+    vector<Texture::Image> AtlasFile::levels() const
+    {
+        vector<Texture::Image> result;
+        uint64_t offset = _header->pixelOffset;
+        for (Size level = 0; level < _header->levels; ++level) {
+            Texture::Image image{ max(_header->width >> level, 1), max(_header->height >> level, 1), _header->channels, reinterpret_cast<const Ubyte*>(_base + offset), 0 };
+            result.push_back(image);
+            offset = Align(offset + static_cast<size_t>(image.width) * image.height * image.channels);
+        }
+        return result;
+    }
+
+    vector<string> AtlasFile::names() const
+    {
+        auto records = reinterpret_cast<const Region*>(_base + _header->regionOffset);
+        const char* strings = _base + _header->stringOffset;
+        vector<string> result;
+        result.reserve(_header->regionCount);
+        for (Uint r = 0; r < _header->regionCount; ++r) { result.emplace_back(strings + records[r].name, records[r].nameLength); }
+        return result;
+    }
+
+    AtlasLayout AtlasFile::Cook(const vector<string>& names, const vector<Texture::Image>& images, const string& destination, const AtlasSettings& settings, Texture::Encoding encoding)
+    {
+        if (names.size() != images.size()) { throw invalid_argument{ "Every atlas image needs a name" }; }
+        AtlasLayout layout = PackAtlas(images, settings);
+        vector<Ubyte> pixels = ComposeAtlas(images, layout);
+        vector<lynda::MipLevel> chain = lynda::mipChain(pixels.data(), layout.width, layout.height, layout.channels,
+            encoding == Texture::Encoding::Srgb, lynda::MipFilter::Box, layout.levels);
+
+        Header header{};
+        header.signature = Signature;
+        header.version = Version;
+        header.width = layout.width;
+        header.height = layout.height;
+        header.channels = layout.channels;
+        header.levels = layout.levels;
+        header.gutter = layout.gutter;
+        header.regionCount = static_cast<Uint>(layout.regions.size());
+        header.encoding = static_cast<Uint>(encoding);
+
+        vector<Region> records;
+        string strings;
+        for (size_t i = 0; i < layout.regions.size(); ++i) {
+            const AtlasRegion& region = layout.regions[i];
+            records.push_back(Region{ region.x, region.y, region.width, region.height, static_cast<Uint>(strings.size()), static_cast<Uint>(names[i].size()) });
+            strings += names[i];
+        }
+        header.stringSize = strings.size();
+        header.regionOffset = Align(sizeof(Header));
+        header.stringOffset = Align(header.regionOffset + records.size() * sizeof(Region));
+        header.pixelOffset = Align(header.stringOffset + strings.size());
+
+        ofstream out{ destination, ios::binary | ios::trunc };
+        if (!out) { throw runtime_error{ "Failed to create file: " + destination }; }
+
+        auto pad = [&out](uint64_t offset) {
+            static const char zeros[Alignment] = {};
+            out.write(zeros, static_cast<streamsize>(offset - static_cast<uint64_t>(out.tellp())));
+        };
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        pad(header.regionOffset);
+        out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Region));
+        pad(header.stringOffset);
+        out.write(strings.data(), strings.size());
+        pad(header.pixelOffset);
+        out.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+        uint64_t offset = header.pixelOffset + pixels.size();
+        for (const lynda::MipLevel& level : chain) {
+            offset = Align(offset);
+            pad(offset);
+            out.write(reinterpret_cast<const char*>(level.texels.data()), level.texels.size());
+            offset += level.texels.size();
+        }
+        if (!out) { throw runtime_error{ "Failed to write file: " + destination }; }
+        return layout;
+    }
+}
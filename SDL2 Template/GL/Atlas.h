@@ -0,0 +1,154 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_ATLAS
+#define OPENGL_WRAPPER_ATLAS
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "OpenGL.h"
+#include "Texture.h"
+#include "../IO/MappedFile.h"
+#include "../../Math/include/gl_mipmap.hpp"
+
+namespace gl {
+    // Where one image sits in an atlas.
+    struct AtlasRegion {
+        // The image's own texels, gutter excluded.
+        Int x, y;
+        Size width, height;
+        // The same area in texture coordinates: a uv across the image maps
+        // to lower + uv * extent.
+        Vector2 lower, extent;
+
+        Vector2 Remap(Vector2 uv) const { return lower + uv * extent; }
+        // As the vertex shader's uv_bounds take it.
+        Vector4 bounds() const { return Vector4{ lower, extent }; }
+    };
+
+    struct AtlasSettings {
+        // Largest width or height the atlas may grow to.
+        Size maxSize = 4096;
+        // Texels of each image's edge repeated around it, so filtering at
+        // the edge reads the image rather than its neighbour.
+        Size padding = 1;
+        // Mip levels, the full size included, that must not bleed between
+        // images. Each image's cell starts and ends on a multiple of the
+        // texels one texel of the last of them covers, and is padded by at
+        // least that many, so no texel of those levels averages two images.
+        // The levels past them are left out of the texture.
+        Size levels = 3;
+    };
+
+    struct AtlasLayout {
+        Size width, height;
+        Int channels;
+        Size levels;
+        // Edge texels repeated on each side of every region.
+        Size gutter;
+        // In the order the images were given.
+        std::vector<AtlasRegion> regions;
+    };
+
+    // Places rectangles into a fixed area by keeping the outline of the
+    // filled part, its skyline, as runs of equal height. Each rectangle
+    // goes where its top would be lowest, ties going to the spot wasting
+    // the least area beneath it, and then to the leftmost.
+    class SkylinePacker {
+    public:
+        SkylinePacker(Size width, Size height);
+
+        // Finds room for a width x height rectangle and gives its lower
+        // left corner; false when it fits nowhere.
+        bool Insert(Size width, Size height, Int& x, Int& y);
+        // Top of the highest rectangle placed so far.
+        Size height() const;
+    private:
+        struct Segment {
+            Int x, y;
+            Size width;
+        };
+
+        Size _width, _height;
+        std::vector<Segment> _skyline;
+
+        // Where a rectangle resting on the skyline from segment index would
+        // have its bottom, and the area it would leave empty below it.
+        bool Fit(std::size_t index, Size width, Size height, Int& y, std::int64_t& waste) const;
+    };
+
+    // Lays images out in the smallest atlas found, power of two wide and
+    // trimmed to the height used. Only their sizes are read. Throws if the
+    // images differ in channel count or will not fit in settings.maxSize.
+    AtlasLayout PackAtlas(const std::vector<Texture::Image>& images, const AtlasSettings& settings = {});
+
+    // Texels of the atlas layout describes, bottom row first and packed,
+    // with every region's gutter filled from its edges.
+    std::vector<Ubyte> ComposeAtlas(const std::vector<Texture::Image>& images, const AtlasLayout& layout);
+
+    // Cooked atlas. A Header is followed by the Region table, the name
+    // strings and the composed texels of each kept mip level, each starting
+    // on a 16-byte boundary. Values are stored in the byte order of the
+    // machine that cooked them.
+    class AtlasFile {
+    public:
+        static constexpr Uint Signature = 0x4C544147; // "GATL"
+        static constexpr Uint Version = 2;
+        static constexpr std::size_t Alignment = 16;
+
+        struct Header {
+            Uint signature;
+            Uint version;
+            Size width;
+            Size height;
+            Int channels;
+            Size levels;
+            Size gutter;
+            Uint regionCount;
+            // A Texture::Encoding.
+            Uint encoding;
+            Uint reserved;
+            std::uint64_t regionOffset;
+            std::uint64_t stringOffset;
+            std::uint64_t stringSize;
+            // Of the first level; each of the rest follows the one above,
+            // on the next boundary.
+            std::uint64_t pixelOffset;
+        };
+        // An AtlasRegion's texels with its name given as a range of the
+        // string blob; the uv area follows from the atlas size.
+        struct Region {
+            Int x, y;
+            Size width, height;
+            Uint name;
+            Uint nameLength;
+        };
+
+        // Views a mapped cooked atlas; throws if the contents are not one.
+        explicit AtlasFile(const io::MappedFile& source);
+
+        static bool Identify(const io::MappedFile& source);
+
+        // Packs and composes images and writes them with their names and
+        // the settings.levels levels below, box filtered in linear light
+        // when encoding is Srgb. Box filtering keeps within the cells, so
+        // the levels do not bleed; a wider filter would cross the gutters.
+        static AtlasLayout Cook(const std::vector<std::string>& names, const std::vector<Texture::Image>& images, const std::string& destination,
+            const AtlasSettings& settings = {}, Texture::Encoding encoding = Texture::Encoding::Linear);
+
+        const Header& header() const { return *_header; }
+        AtlasLayout layout() const;
+        std::vector<std::string> names() const;
+        Texture::Encoding encoding() const { return static_cast<Texture::Encoding>(_header->encoding); }
+        const Ubyte* pixels() const { return reinterpret_cast<const Ubyte*>(_base + _header->pixelOffset); }
+        // Full size first; the pixels point into the mapping.
+        std::vector<Texture::Image> levels() const;
+    private:
+        const char* _base;
+        const Header* _header;
+    };
+}
+
+#endif
@@ -35,6 +35,7 @@ namespace gl {
             VertexArray     = GL_ARRAY_BUFFER, 
             ElementArray    = GL_ELEMENT_ARRAY_BUFFER, 
             UniformBlock    = GL_UNIFORM_BUFFER,
+            PixelUnpack     = GL_PIXEL_UNPACK_BUFFER,
         };
         template <typename T> using mapped_ptr = std::unique_ptr<T, unmapper>;
     protected:
@@ -79,6 +80,14 @@ namespace gl {
             glBufferData(buffer, count, nullptr, role);
             return *this;
         }
+
+        template<typename E>
+        GeneralBuffer& Update(Contents buffer, std::size_t offset, const E* source, std::size_t count)
+        {
+            Activate(buffer);
+            glBufferSubData(buffer, sizeof(E) * offset, sizeof(E) * count, source);
+            return *this;
+        }
     };
 
     template <GeneralBuffer::Contents target>
@@ -114,6 +123,14 @@ namespace gl {
             GeneralBuffer::Reserve(target, role, count);
             return *this;
         }
+
+        // Overwrites count elements starting offset elements into the buffer.
+        template <typename E>
+        Buffer<target>& Update(std::size_t offset, const E* source, std::size_t count)
+        {
+            GeneralBuffer::Update(target, offset, source, count);
+            return *this;
+        }
     };
     
     template <>
@@ -163,6 +180,7 @@ namespace gl {
     using ArrayBuffer = Buffer<GeneralBuffer::VertexArray>;
     using ElementArrayBuffer = Buffer<GeneralBuffer::ElementArray>;
     using UniformBuffer = Buffer<GeneralBuffer::UniformBlock>;
+    using PixelUnpackBuffer = Buffer<GeneralBuffer::PixelUnpack>;
 }
 
 #endif
@@ -0,0 +1,234 @@
+#include "GeometryPool.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "MeshFile.h"
+#include "../IO/ContentHash.h"
+using namespace std;
+
+namespace gl {
+    namespace {
+        constexpr size_t Stride = sizeof(PackedVertex);
+        // Seeds the check hash apart from the key.
+        constexpr uint64_t CheckSeed = 0x9E3779B97F4A7C15ull;
+    }
+
+    bool GeometryPool::Block::Allocate(size_t bytes, size_t alignment, size_t& offset)
+    {
+        for (auto at = free.begin(); at != free.end(); ++at) {
+            size_t begin = at->first, end = at->first + at->second;
+            size_t start = (begin + alignment - 1) / alignment * alignment;
+            if (start > end || end - start < bytes) { continue; }
+            free.erase(at);
+            if (start > begin) { free.emplace(begin, start - begin); }
+            if (start + bytes < end) { free.emplace(start + bytes, end - start - bytes); }
+            live += bytes;
+            offset = start;
+            return true;
+        }
+        return false;
+    }
+
+    void GeometryPool::Block::Release(size_t offset, size_t bytes)
+    {
+        live -= bytes;
+        auto at = free.emplace(offset, bytes).first;
+        auto next = std::next(at);
+        if (next != free.end() && at->first + at->second == next->first) {
+            at->second += next->second;
+            free.erase(next);
+        }
+        if (at != free.begin()) {
+            auto previous = std::prev(at);
+            if (previous->first + previous->second == at->first) {
+                previous->second += at->second;
+                free.erase(at);
+            }
+        }
+    }
+
+    GeometryPool::VertexBlock::VertexBlock(size_t bytes)
+        : Block{ bytes }
+    {
+        buffer.Reserve(ArrayBuffer::StaticDraw, bytes);
+    }
+
+    GeometryPool::ElementBlock::ElementBlock(size_t bytes)
+        : Block{ bytes }
+    {
+        // Binding the buffer would attach it to whatever array is active.
+        Vertex::Array::Deactivate();
+        buffer.Reserve(ElementArrayBuffer::StaticDraw, bytes);
+    }
+
+    GeometryPool::Lease::~Lease()
+    {
+        pool->Release(*this);
+    }
+
+    GeometryPool::GeometryPool(size_t blockBytes)
+        : _blockBytes{ blockBytes }, _used{ 0 }, _capacity{ 0 }, _reused{ 0 }
+    {}
+
+    shared_ptr<const Mesh> GeometryPool::Build(const Mesh::Source& source)
+    {
+        auto drawn = [](const Mesh::SubMesh& surface) { return surface.count > 0; };
+        if (!Shares(source) || none_of(source.surfaces.begin(), source.surfaces.end(), drawn)) { return make_shared<Mesh>(source); }
+
+        auto lease = make_shared<Lease>();
+        lease->pool = shared_from_this();
+        shared_ptr<Mesh> mesh{ new Mesh{ source, lease } };
+        mesh->bindings.resize(source.surfaces.size());
+
+        // Each part is packed against its own bounds, so the same part has
+        // the same vertex bytes in every file.
+        vector<const Range*> parts;
+        for (const Mesh::Part& part : source.parts) {
+            size_t vertexBytes = static_cast<size_t>(part.count) * Stride;
+            lease->vertices.push_back(AcquireVertices(source.vertexData + static_cast<size_t>(part.first) * Stride, vertexBytes));
+            parts.push_back(&_vertexRanges.at(lease->vertices.back()));
+            mesh->byteCount += vertexBytes;
+        }
+
+        vector<Uint> rebased;
+        for (size_t s = 0; s < source.surfaces.size(); ++s) {
+            const Mesh::SubMesh& surface = source.surfaces[s];
+            if (!surface.count) { continue; }
+            Uint p = source.bindings[s].part;
+            const Mesh::Part& part = source.parts[p];
+            const Range& vertices = *parts[p];
+
+            // Counted from the part, indices need only address its vertices,
+            // which also makes a part's indices the same in every file.
+            TypeCode type = NarrowestElement(static_cast<size_t>(part.count));
+            rebased.resize(surface.count);
+            for (Size i = 0; i < surface.count; ++i) {
+                rebased[i] = ReadElement(source.elementData, source.elementType, static_cast<size_t>(surface.start) + i) - static_cast<Uint>(part.first);
+                if (rebased[i] >= static_cast<Uint>(part.count)) { throw invalid_argument{ "Mesh surface draws outside its part" }; }
+            }
+            vector<Ubyte> elements = NarrowElements(rebased, type);
+            lease->elements.push_back(AcquireElements(elements, type, vertices.block));
+            const Range& range = _elementRanges.at(lease->elements.back());
+            mesh->byteCount += elements.size();
+
+            shared_ptr<Vertex::Array> array = Array(vertices.block, range.block);
+            auto layout = find(mesh->arrays.begin(), mesh->arrays.end(), array);
+            if (layout == mesh->arrays.end()) { layout = mesh->arrays.insert(layout, array); }
+            mesh->surfaces[s].start = static_cast<Size>(range.offset / TypeAlloc[type]);
+            mesh->bindings[s] = Mesh::Binding{ static_cast<Uint>(layout - mesh->arrays.begin()), type, static_cast<Int>(vertices.offset / Stride), p };
+        }
+        // Empty surfaces draw nothing, but still need a valid binding.
+        const Mesh::Binding& first = mesh->bindings[find_if(source.surfaces.begin(), source.surfaces.end(), drawn) - source.surfaces.begin()];
+        for (size_t s = 0; s < source.surfaces.size(); ++s) {
+            if (!source.surfaces[s].count) { mesh->bindings[s] = first; }
+        }
+        for (Mesh::Cluster& cluster : mesh->clusters) {
+            cluster.start = mesh->surfaces[cluster.surface].start + (cluster.start - source.surfaces[cluster.surface].start);
+        }
+        Vertex::Array::Deactivate();
+        ArrayBuffer::Deactivate();
+        return mesh;
+    }
+
+    template <typename B>
+    GeometryPool::Range GeometryPool::Place(vector<unique_ptr<B>>& blocks, size_t bytes, size_t alignment)
+    {
+        Range range{ 0, 0, alignment, 1, bytes, 0 };
+        for (range.block = 0; range.block < blocks.size(); ++range.block) {
+            if (blocks[range.block] && blocks[range.block]->Allocate(bytes, alignment, range.offset)) { return range; }
+        }
+
+        auto empty = find(blocks.begin(), blocks.end(), nullptr);
+        range.block = static_cast<Uint>(empty - blocks.begin());
+        size_t size = max(_blockBytes, bytes);
+        if (empty == blocks.end()) { blocks.emplace_back(); }
+        blocks[range.block].reset(new B{ size });
+        _capacity += size;
+        blocks[range.block]->Allocate(bytes, alignment, range.offset);
+        return range;
+    }
+
+    bool GeometryPool::Find(unordered_map<uint64_t, Range>& ranges, uint64_t& key, size_t bytes, size_t alignment, uint64_t check)
+    {
+        for (auto held = ranges.find(key); held != ranges.end(); held = ranges.find(++key)) {
+            const Range& range = held->second;
+            if (range.alignment == alignment && range.bytes == bytes && range.check == check) { return true; }
+        }
+        return false;
+    }
+
+    uint64_t GeometryPool::AcquireVertices(const Ubyte* data, size_t bytes)
+    {
+        uint64_t key = io::ContentHash(data, bytes);
+        uint64_t check = io::ContentHash(data, bytes, CheckSeed);
+        if (Find(_vertexRanges, key, bytes, Stride, check)) {
+            ++_vertexRanges[key].users;
+            _reused += bytes;
+            return key;
+        }
+
+        Range range = Place(_vertexBlocks, bytes, Stride);
+        _vertexBlocks[range.block]->buffer.Update(range.offset, data, bytes);
+        range.check = check;
+        _vertexRanges.emplace(key, move(range));
+        _used += bytes;
+        return key;
+    }
+
+    uint64_t GeometryPool::AcquireElements(const vector<Ubyte>& data, TypeCode type, Uint vertexBlock)
+    {
+        uint64_t key = io::ContentHash(data.data(), data.size(), static_cast<uint64_t>(type));
+        uint64_t check = io::ContentHash(data.data(), data.size(), CheckSeed ^ static_cast<uint64_t>(type));
+        if (Find(_elementRanges, key, data.size(), TypeAlloc[type], check)) {
+            ++_elementRanges[key].users;
+            _reused += data.size();
+            return key;
+        }
+
+        Range range = Place(_elementBlocks, data.size(), TypeAlloc[type]);
+        // The element buffer binding belongs to the active array, so upload
+        // through one that already uses this block.
+        Array(vertexBlock, range.block)->Activate();
+        _elementBlocks[range.block]->buffer.Update(range.offset, data.data(), data.size());
+        range.check = check;
+        _elementRanges.emplace(key, move(range));
+        _used += data.size();
+        return key;
+    }
+
+    shared_ptr<Vertex::Array> GeometryPool::Array(Uint vertexBlock, Uint elementBlock)
+    {
+        auto& array = _arrays[{ vertexBlock, elementBlock }];
+        if (!array) {
+            array = make_shared<Vertex::Array>();
+            *array << _elementBlocks[elementBlock]->buffer;
+            Mesh::AttachPacked(*array, _vertexBlocks[vertexBlock]->buffer);
+        }
+        return array;
+    }
+
+    void GeometryPool::Release(const Lease& lease)
+    {
+        auto release = [this](auto& ranges, auto& blocks, uint64_t key, bool vertices) {
+            auto held = ranges.find(key);
+            if (--held->second.users) { return; }
+            const Range& range = held->second;
+            auto& block = blocks[range.block];
+            block->Release(range.offset, range.bytes);
+            _used -= range.bytes;
+            if (!block->live) {
+                _capacity -= block->size;
+                block.reset();
+                for (auto array = _arrays.begin(); array != _arrays.end(); ) {
+                    Uint uses = vertices ? array->first.first : array->first.second;
+                    array = uses == range.block ? _arrays.erase(array) : std::next(array);
+                }
+            }
+            ranges.erase(held);
+        };
+        for (uint64_t key : lease.vertices) { release(_vertexRanges, _vertexBlocks, key, true); }
+        for (uint64_t key : lease.elements) { release(_elementRanges, _elementBlocks, key, false); }
+    }
+}
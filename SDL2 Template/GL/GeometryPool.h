@@ -0,0 +1,109 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_GEOMETRYPOOL
+#define OPENGL_WRAPPER_GEOMETRYPOOL
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Mesh.h"
+
+namespace gl {
+    // Vertex and element storage shared by every mesh built through it.
+    // A mesh is split into vertex ranges, one per part, which is packed
+    // against its own bounds, and element ranges, one per surface with
+    // indices counted from the start of its part. Each range is keyed by a
+    // hash of its bytes and checked against a second, differently seeded
+    // hash of them, so without keeping a copy a part that
+    // turns up in many files, such as a bolt, is uploaded and held once
+    // however many meshes draw it; each mesh keeps only offsets into the
+    // shared buffers. Ranges live in large blocks and go back to them when
+    // the last mesh using them goes. Meshes with their own vertex layouts,
+    // or not packed in parts, are built on their own.
+    // Create with make_shared, since meshes keep the pool alive; use from
+    // the GL thread only.
+    class GeometryPool : public std::enable_shared_from_this<GeometryPool> {
+    public:
+        // Ranges larger than blockBytes get a block of their own.
+        explicit GeometryPool(std::size_t blockBytes = 16 << 20);
+
+        GeometryPool(const GeometryPool&) = delete;
+        GeometryPool& operator= (const GeometryPool&) = delete;
+
+        static bool Shares(const Mesh::Source& source) { return source.layouts.empty() && !source.parts.empty(); }
+
+        // Uploads only the ranges of source not already held.
+        std::shared_ptr<const Mesh> Build(const Mesh::Source& source);
+
+        // Bytes in ranges some mesh still uses, each counted once.
+        std::size_t used() const { return _used; }
+        // Bytes of GL buffer the blocks hold, free space included.
+        std::size_t capacity() const { return _capacity; }
+        // Bytes meshes asked for that were already held, since creation.
+        std::size_t reused() const { return _reused; }
+    private:
+        // First-fit free list over one GL buffer.
+        struct Block {
+            std::size_t size;
+            std::size_t live;
+            std::map<std::size_t, std::size_t> free;
+
+            explicit Block(std::size_t bytes) : size{ bytes }, live{ 0 }, free{ { 0, bytes } } {}
+            bool Allocate(std::size_t bytes, std::size_t alignment, std::size_t& offset);
+            void Release(std::size_t offset, std::size_t bytes);
+        };
+        struct VertexBlock : Block {
+            ArrayBuffer buffer;
+            explicit VertexBlock(std::size_t bytes);
+        };
+        struct ElementBlock : Block {
+            ElementArrayBuffer buffer;
+            explicit ElementBlock(std::size_t bytes);
+        };
+        struct Range {
+            Uint block;
+            std::size_t offset;
+            std::size_t alignment;
+            std::size_t users;
+            std::size_t bytes;
+            // Second hash of what the GL buffer holds, so a match on the
+            // key can be confirmed without reading the buffer back.
+            std::uint64_t check;
+        };
+        // Ranges one mesh holds, handed back when it goes.
+        struct Lease {
+            std::shared_ptr<GeometryPool> pool;
+            std::vector<std::uint64_t> vertices, elements;
+            ~Lease();
+        };
+
+        std::size_t _blockBytes;
+        std::size_t _used, _capacity, _reused;
+        // Emptied blocks leave a null slot so block numbers stay valid.
+        std::vector<std::unique_ptr<VertexBlock>> _vertexBlocks;
+        std::vector<std::unique_ptr<ElementBlock>> _elementBlocks;
+        std::unordered_map<std::uint64_t, Range> _vertexRanges, _elementRanges;
+        // One vertex array per pair of blocks some surface draws from.
+        std::map<std::pair<Uint, Uint>, std::shared_ptr<Vertex::Array>> _arrays;
+
+        template <typename B>
+        Range Place(std::vector<std::unique_ptr<B>>& blocks, std::size_t bytes, std::size_t alignment);
+        // Looks for a range with the given size and check hash among ranges
+        // from key on, stepping past ranges that only share the key. Leaves
+        // key at the match, or at the free key to place them under.
+        static bool Find(std::unordered_map<std::uint64_t, Range>& ranges, std::uint64_t& key, std::size_t bytes, std::size_t alignment, std::uint64_t check);
+        // Finds the range holding bytes, or places and uploads it, and
+        // returns its key.
+        std::uint64_t AcquireVertices(const Ubyte* data, std::size_t bytes);
+        std::uint64_t AcquireElements(const std::vector<Ubyte>& data, TypeCode type, Uint vertexBlock);
+        std::shared_ptr<Vertex::Array> Array(Uint vertexBlock, Uint elementBlock);
+        void Release(const Lease& lease);
+    };
+}
+
+#endif
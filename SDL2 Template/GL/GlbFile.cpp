@@ -0,0 +1,313 @@
+#include "GlbFile.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "../IO/Json.h"
+using namespace std;
+
+namespace {
+    constexpr uint32_t Magic = 0x46546C67;      // "glTF"
+    constexpr uint32_t JsonChunk = 0x4E4F534A;  // "JSON"
+    constexpr uint32_t BinChunk = 0x004E4942;   // "BIN\0"
+
+    uint32_t Word(const char* at)
+    {
+        uint32_t word;
+        memcpy(&word, at, sizeof(word));
+        return word;
+    }
+
+    // A glTF index or size: a whole, non-negative number.
+    size_t Index(const io::Json& value)
+    {
+        double number = value.number(-1);
+        if (value.kind() != io::Json::Number || number < 0 || number > 9007199254740992.0 || number != static_cast<double>(static_cast<uint64_t>(number))) {
+            throw invalid_argument{ "Bad index or size in glTF file" };
+        }
+        return static_cast<size_t>(number);
+    }
+
+    size_t Index(const io::Json& value, size_t fallback)
+    {
+        return value.null() ? fallback : Index(value);
+    }
+
+    gl::Uint Components(const string& type)
+    {
+        if (type == "SCALAR") { return 1; }
+        if (type == "VEC2") { return 2; }
+        if (type == "VEC3") { return 3; }
+        if (type == "VEC4") { return 4; }
+        throw invalid_argument{ "Unsupported glTF accessor type: " + type };
+    }
+
+    // glTF component types are the GL enums themselves.
+    size_t ComponentSize(gl::TypeCode type)
+    {
+        switch (type) {
+        case gl::TypeCode::Byte:
+        case gl::TypeCode::Ubyte: return 1;
+        case gl::TypeCode::Short:
+        case gl::TypeCode::Ushort: return 2;
+        case gl::TypeCode::Uint:
+        case gl::TypeCode::Float: return 4;
+        default: throw invalid_argument{ "Unsupported glTF component type" };
+        }
+    }
+
+    // What a normalized integer component's largest value stands for.
+    float Scale(gl::TypeCode type, gl::Bool normalized)
+    {
+        if (!normalized) { return 1.0f; }
+        switch (type) {
+        case gl::TypeCode::Byte: return 127.0f;
+        case gl::TypeCode::Ubyte: return 255.0f;
+        case gl::TypeCode::Short: return 32767.0f;
+        case gl::TypeCode::Ushort: return 65535.0f;
+        default: return 1.0f;
+        }
+    }
+
+    // Where an accessor's data sits in the BIN chunk.
+    struct Location {
+        gl::TypeCode type;
+        gl::Uint count;
+        gl::Bool normalized;
+        size_t stride;
+        size_t offset;
+        size_t elements;
+        size_t viewBegin, viewEnd;
+    };
+
+    // The part of the BIN chunk one GL buffer takes, widened to cover
+    // whole buffer views.
+    struct Span {
+        size_t begin = numeric_limits<size_t>::max();
+        size_t end = 0;
+
+        void Cover(size_t first, size_t last)
+        {
+            begin = min(begin, first);
+            end = max(end, last);
+        }
+        // The BIN chunk starts 4-aligned, so aligning here keeps every
+        // offset taken from the span aligned as the file had it.
+        void Align()
+        {
+            if (begin > end) { begin = end = 0; }
+            begin &= ~size_t{ 3 };
+        }
+    };
+
+    bool Same(const vector<gl::Mesh::Attribute>& first, const vector<gl::Mesh::Attribute>& second)
+    {
+        return equal(first.begin(), first.end(), second.begin(), second.end(), [](const gl::Mesh::Attribute& a, const gl::Mesh::Attribute& b) {
+            return a.channel == b.channel && a.count == b.count && a.type == b.type && a.normalized == b.normalized && a.stride == b.stride && a.offset == b.offset;
+        });
+    }
+
+    gl::Size Fit(size_t value)
+    {
+        if (value > static_cast<size_t>(INT_MAX)) { throw invalid_argument{ "glTF buffer too large to draw" }; }
+        return static_cast<gl::Size>(value);
+    }
+}
+
+namespace gl {
+    bool IdentifyGlb(const io::MappedFile& file)
+    {
+        return file.size() >= 12 && Word(file.data()) == Magic;
+    }
+
+    void LoadGlb(const io::MappedFile& file, Mesh::Source& source)
+    {
+        const char* data = file.data();
+        if (!IdentifyGlb(file)) { throw invalid_argument{ "Not a glTF binary file" }; }
+        if (Word(data + 4) != 2) { throw invalid_argument{ "Unsupported glTF version" }; }
+        size_t length = min<size_t>(Word(data + 8), file.size());
+
+        const char* text = nullptr;
+        size_t textSize = 0;
+        const Ubyte* bin = nullptr;
+        size_t binSize = 0;
+        for (size_t at = 12; at + 8 <= length; ) {
+            size_t size = Word(data + at);
+            uint32_t type = Word(data + at + 4);
+            if (size > length - at - 8) { throw invalid_argument{ "Truncated glTF chunk" }; }
+            if (type == JsonChunk && !text) {
+                text = data + at + 8;
+                textSize = size;
+            }
+            else if (type == BinChunk && !bin) {
+                bin = reinterpret_cast<const Ubyte*>(data + at + 8);
+                binSize = size;
+            }
+            at += 8 + ((size + 3) & ~size_t{ 3 });
+        }
+        if (!text) { throw invalid_argument{ "glTF file has no JSON chunk" }; }
+
+        io::Json document = io::Json::Parse(text, text + textSize);
+        const io::Json& accessors = document["accessors"];
+        const io::Json& views = document["bufferViews"];
+        bool embedded = bin && !document["buffers"][0].has("uri");
+
+        auto locate = [&](size_t index) {
+            const io::Json& accessor = accessors[index];
+            if (accessor.null()) { throw invalid_argument{ "Missing glTF accessor " + to_string(index) }; }
+            if (accessor.has("sparse")) { throw invalid_argument{ "Sparse glTF accessors are not supported" }; }
+            const io::Json& view = views[Index(accessor["bufferView"], numeric_limits<size_t>::max())];
+            if (view.null()) { throw invalid_argument{ "glTF accessor " + to_string(index) + " has no buffer view" }; }
+            if (Index(view["buffer"]) != 0 || !embedded) { throw invalid_argument{ "External glTF buffers are not supported" }; }
+
+            Location location;
+            location.type = static_cast<TypeCode>(Index(accessor["componentType"]));
+            location.count = Components(accessor["type"].string());
+            location.normalized = accessor["normalized"].boolean() ? GL_TRUE : GL_FALSE;
+            location.stride = Index(view["byteStride"], 0);
+            location.elements = Index(accessor["count"]);
+            location.viewBegin = Index(view["byteOffset"], 0);
+            size_t viewLength = Index(view["byteLength"]);
+            if (location.viewBegin > binSize || viewLength > binSize - location.viewBegin) { throw invalid_argument{ "glTF buffer view outside the BIN chunk" }; }
+            location.viewEnd = location.viewBegin + viewLength;
+
+            size_t inset = Index(accessor["byteOffset"], 0);
+            size_t element = location.count * ComponentSize(location.type);
+            size_t step = location.stride ? location.stride : element;
+            if (inset > viewLength || (location.elements && (location.elements - 1 > (viewLength - inset) / step || (location.elements - 1) * step + element > viewLength - inset))) {
+                throw invalid_argument{ "glTF accessor " + to_string(index) + " runs outside its buffer view" };
+            }
+            location.offset = location.viewBegin + inset;
+            return location;
+        };
+
+        const io::Json& materials = document["materials"];
+        source.materials.clear();
+        for (size_t m = 0; m < materials.size(); ++m) {
+            const io::Json& entry = materials[m];
+            const io::Json& pbr = entry["pbrMetallicRoughness"];
+            const io::Json& factor = pbr["baseColorFactor"];
+            Material material;
+            material.name = entry["name"].string();
+            if (factor.size() == 4) {
+                material.diffuse = ColorAlpha{ factor[0].number(), factor[1].number(), factor[2].number(), factor[3].number() };
+            }
+            const io::Json& texture = document["textures"][Index(pbr["baseColorTexture"]["index"], numeric_limits<size_t>::max())];
+            material.diffuseMap = document["images"][Index(texture["source"], numeric_limits<size_t>::max())]["uri"].string();
+            source.materials.push_back(move(material));
+        }
+
+        static const struct {
+            const char* name;
+            Mesh::Channel channel;
+        } channels[] = { { "POSITION", Mesh::Position }, { "NORMAL", Mesh::Normal }, { "TEXCOORD_0", Mesh::UV } };
+
+        struct Primitive {
+            Mesh::SubMesh surface;
+            vector<Mesh::Attribute> layout;
+            TypeCode elementType;
+            size_t indexOffset;
+        };
+        vector<Primitive> primitives;
+        Span vertexSpan, elementSpan;
+        Point3 lower{ numeric_limits<Float>::max() }, upper{ numeric_limits<Float>::lowest() };
+
+        const io::Json& meshes = document["meshes"];
+        for (size_t m = 0; m < meshes.size(); ++m) {
+            const io::Json& list = meshes[m]["primitives"];
+            for (size_t p = 0; p < list.size(); ++p) {
+                const io::Json& primitive = list[p];
+                if (!primitive.has("indices")) { throw invalid_argument{ "Unindexed glTF primitives are not supported" }; }
+                const io::Json& attributes = primitive["attributes"];
+                if (!attributes.has("POSITION")) { throw invalid_argument{ "glTF primitive has no POSITION" }; }
+
+                Location indices = locate(Index(primitive["indices"]));
+                if (indices.count != 1 || (indices.type != TypeCode::Ubyte && indices.type != TypeCode::Ushort && indices.type != TypeCode::Uint) || indices.stride) {
+                    throw invalid_argument{ "Bad glTF index accessor" };
+                }
+                elementSpan.Cover(indices.viewBegin, indices.viewEnd);
+
+                size_t mode = Index(primitive["mode"], Mesh::Triangles);
+                if (mode > Mesh::TriangleFan) { throw invalid_argument{ "Bad glTF primitive mode" }; }
+                size_t material = Index(primitive["material"], materials.size());
+                if (material > materials.size()) { throw invalid_argument{ "Missing glTF material" }; }
+
+                Primitive entry{ Mesh::SubMesh{ static_cast<Mesh::Assembly>(mode), 0, Fit(indices.elements), static_cast<Uint>(material) }, {}, indices.type, indices.offset };
+                for (const auto& channel : channels) {
+                    if (!attributes.has(channel.name)) { continue; }
+                    Location at = locate(Index(attributes[channel.name]));
+                    entry.layout.push_back(Mesh::Attribute{ channel.channel, at.count, at.type, at.normalized, Fit(at.stride), Fit(at.offset) });
+                    vertexSpan.Cover(at.viewBegin, at.viewEnd);
+                }
+
+                // The spec requires bounds on positions, which saves reading them.
+                const io::Json& position = accessors[Index(attributes["POSITION"])];
+                const io::Json& minimum = position["min"];
+                const io::Json& maximum = position["max"];
+                if (minimum.size() < 3 || maximum.size() < 3) { throw invalid_argument{ "glTF positions have no bounds" }; }
+                const Mesh::Attribute& layout = entry.layout.front();
+                float scale = Scale(layout.type, layout.normalized);
+                for (int axis = 0; axis < 3; ++axis) {
+                    Float low = static_cast<Float>(minimum[axis].number()) / scale;
+                    // Signed normalized values clamp at -1.
+                    if (layout.normalized) { low = max(low, -1.0f); }
+                    lower[axis] = min(lower[axis], low);
+                    upper[axis] = max(upper[axis], static_cast<Float>(maximum[axis].number()) / scale);
+                }
+                primitives.push_back(move(entry));
+            }
+        }
+
+        vertexSpan.Align();
+        elementSpan.Align();
+        Fit(vertexSpan.end - vertexSpan.begin);
+        Fit(elementSpan.end - elementSpan.begin);
+
+        // Surfaces go in material order, then by layout, so a level draws
+        // with as few state changes as it can.
+        source.layouts.clear();
+        vector<Mesh::Binding> bindings;
+        for (auto& primitive : primitives) {
+            for (auto& attribute : primitive.layout) { attribute.offset -= static_cast<Size>(vertexSpan.begin); }
+            auto found = find_if(source.layouts.begin(), source.layouts.end(), [&](const vector<Mesh::Attribute>& layout) { return Same(layout, primitive.layout); });
+            if (found == source.layouts.end()) { found = source.layouts.insert(found, primitive.layout); }
+
+            size_t inset = primitive.indexOffset - elementSpan.begin;
+            size_t size = ComponentSize(primitive.elementType);
+            if (inset % size) { throw invalid_argument{ "Misaligned glTF index accessor" }; }
+            primitive.surface.start = Fit(inset / size);
+            bindings.push_back(Mesh::Binding{ static_cast<Uint>(found - source.layouts.begin()), primitive.elementType, 0, 0 });
+        }
+        vector<size_t> order(primitives.size());
+        iota(order.begin(), order.end(), size_t{ 0 });
+        stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            const Mesh::SubMesh& first = primitives[a].surface;
+            const Mesh::SubMesh& second = primitives[b].surface;
+            return first.material != second.material ? first.material < second.material : bindings[a].layout < bindings[b].layout;
+        });
+        source.surfaces.clear();
+        source.bindings.clear();
+        for (size_t index : order) {
+            source.surfaces.push_back(primitives[index].surface);
+            source.bindings.push_back(bindings[index]);
+        }
+
+        source.vertexData = bin + vertexSpan.begin;
+        source.vertexBytes = vertexSpan.end - vertexSpan.begin;
+        source.elementData = bin + elementSpan.begin;
+        source.elementBytes = elementSpan.end - elementSpan.begin;
+        source.elementType = source.bindings.empty() ? TypeCode::Ushort : source.bindings.front().elementType;
+        source.levels.assign(1, Mesh::Level{ 0, static_cast<Size>(source.surfaces.size()), 0.0f });
+        source.clusters.clear();
+        if (primitives.empty()) { lower = upper = Point3{ 0.0f }; }
+        source.sphere = Mesh::Sphere{ (lower + upper) * 0.5f, glm::distance(lower, upper) * 0.5f };
+        // The attributes arrive as the file stores them, so the shader's
+        // dequantization does nothing.
+        source.packing = Quantization{ Point3{ 0.0f }, Vector3{ 1.0f }, Vector2{ 0.0f }, Vector2{ 1.0f }, GL_FALSE };
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_GLBFILE
+#define OPENGL_WRAPPER_GLBFILE
+
+#include "Mesh.h"
+#include "../IO/MappedFile.h"
+
+namespace gl {
+    // Binary glTF 2.0. Vertex and index bytes are used in place from the
+    // BIN chunk, never copied or converted: each accessor becomes a vertex
+    // attribute with the file's own type, stride and offset, and each
+    // primitive a surface drawn through the vertex array for its layout.
+    bool IdentifyGlb(const io::MappedFile& file);
+
+    // Points source at the BIN chunk of file, which must outlive it, and
+    // fills in its surfaces, layouts, materials and bounds. Every primitive
+    // of every mesh is drawn; node transforms are not applied. Throws
+    // invalid_argument for files that cannot be drawn that way, such as
+    // those with external buffers, sparse accessors or unindexed primitives.
+    void LoadGlb(const io::MappedFile& file, Mesh::Source& source);
+}
+
+#endif
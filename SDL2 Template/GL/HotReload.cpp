@@ -0,0 +1,218 @@
+#include "HotReload.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <sstream>
+using namespace std;
+
+namespace {
+    // Editors often save in several writes, so changes are gathered until
+    // the files have been quiet this long.
+    constexpr chrono::milliseconds Settle{ 50 };
+
+    string ReadText(const string& filename)
+    {
+        ifstream file{ filename, ios::binary };
+        if (!file) { throw runtime_error{ "Failed to open file: " + filename }; }
+        ostringstream text;
+        text << file.rdbuf();
+        return text.str();
+    }
+}
+
+namespace gl {
+    HotReload::HotReload(Report report, size_t frameBudget)
+    :   _report{ move(report) }, _budget{ max<size_t>(frameBudget, 1) }, _stopping{ false }, _offset{ 0 }
+    {
+        _worker = thread{ &HotReload::Work, this };
+    }
+
+    HotReload::~HotReload()
+    {
+        {
+            lock_guard<mutex> hold{ _lock };
+            _stopping = true;
+        }
+        _watcher.Cancel();
+        _worker.join();
+    }
+
+    shared_ptr<const Mesh> HotReload::Load(const string& filename)
+    {
+        {
+            lock_guard<mutex> hold{ _lock };
+            auto found = _meshes.find(filename);
+            if (found != _meshes.end()) {
+                if (auto mesh = found->second.lock()) { return mesh; }
+            }
+        }
+        // Watched before loading, so a write during the load is not missed.
+        _watcher.Watch(filename);
+        auto mesh = make_shared<Mesh>(filename);
+        lock_guard<mutex> hold{ _lock };
+        _meshes[filename] = mesh;
+        return mesh;
+    }
+
+    void HotReload::Watch(Program& program, const string& vertexFile, const string& fragmentFile)
+    {
+        _watcher.Watch(vertexFile);
+        _watcher.Watch(fragmentFile);
+        lock_guard<mutex> hold{ _lock };
+        auto found = find_if(_programs.begin(), _programs.end(), [&](const Watched& watched) { return watched.program == &program; });
+        if (found != _programs.end()) { *found = Watched{ &program, vertexFile, fragmentFile }; }
+        else { _programs.push_back(Watched{ &program, vertexFile, fragmentFile }); }
+    }
+
+    void HotReload::Forget(const Program& program)
+    {
+        lock_guard<mutex> hold{ _lock };
+        _programs.erase(remove_if(_programs.begin(), _programs.end(), [&](const Watched& watched) { return watched.program == &program; }), _programs.end());
+        _relinks.erase(remove_if(_relinks.begin(), _relinks.end(), [&](const Relink& relink) { return relink.program == &program; }), _relinks.end());
+    }
+
+    void HotReload::Work()
+    {
+        for (;;) {
+            vector<string> changed = _watcher.Wait();
+            for (;;) {
+                vector<string> more = _watcher.Wait(Settle);
+                if (more.empty()) { break; }
+                for (auto& filename : more) {
+                    if (find(changed.begin(), changed.end(), filename) == changed.end()) { changed.push_back(filename); }
+                }
+            }
+            {
+                lock_guard<mutex> hold{ _lock };
+                if (_stopping) { return; }
+            }
+            for (auto& filename : changed) { Reload(filename); }
+        }
+    }
+
+    void HotReload::Reload(const string& filename)
+    {
+        bool mesh = false;
+        vector<Relink> relinks;
+        {
+            lock_guard<mutex> hold{ _lock };
+            auto found = _meshes.find(filename);
+            if (found != _meshes.end()) {
+                mesh = !found->second.expired();
+                if (!mesh) { _meshes.erase(found); }
+            }
+            for (auto& watched : _programs) {
+                if (watched.vertexFile == filename || watched.fragmentFile == filename) {
+                    relinks.push_back(Relink{ watched.program, watched.vertexFile, watched.fragmentFile, {}, {} });
+                }
+            }
+        }
+
+        if (mesh) {
+            try {
+                unique_ptr<Mesh::Source> source{ new Mesh::Source{ filename } };
+                lock_guard<mutex> hold{ _lock };
+                auto queued = find_if(_decoded.begin(), _decoded.end(), [&](const Decoded& decoded) { return decoded.filename == filename; });
+                if (queued != _decoded.end()) { queued->source = move(source); }
+                else { _decoded.push_back(Decoded{ filename, move(source) }); }
+            }
+            catch (const exception& error) {
+                lock_guard<mutex> hold{ _lock };
+                _failures.push_back(Failure{ filename, error.what() });
+            }
+        }
+
+        for (auto& relink : relinks) {
+            try {
+                relink.vertexSource = ReadText(relink.vertexFile);
+                relink.fragmentSource = ReadText(relink.fragmentFile);
+            }
+            catch (const exception& error) {
+                lock_guard<mutex> hold{ _lock };
+                _failures.push_back(Failure{ filename, error.what() });
+                continue;
+            }
+            lock_guard<mutex> hold{ _lock };
+            // The files were read unlocked, so the program may have been
+            // forgotten, and even destroyed, or watched with other files
+            // meanwhile; Update must not touch it then.
+            bool watched = any_of(_programs.begin(), _programs.end(), [&](const Watched& other) {
+                return other.program == relink.program && other.vertexFile == relink.vertexFile && other.fragmentFile == relink.fragmentFile;
+            });
+            if (!watched) { continue; }
+            auto queued = find_if(_relinks.begin(), _relinks.end(), [&](const Relink& other) { return other.program == relink.program; });
+            if (queued != _relinks.end()) { *queued = move(relink); }
+            else { _relinks.push_back(move(relink)); }
+        }
+    }
+
+    size_t HotReload::Update()
+    {
+        vector<Relink> relinks;
+        vector<Failure> failures;
+        {
+            lock_guard<mutex> hold{ _lock };
+            relinks.swap(_relinks);
+            failures.swap(_failures);
+        }
+        for (auto& failure : failures) { _report(failure.filename, failure.error); }
+
+        for (auto& relink : relinks) {
+            // Compile errors name the shader's own file; link errors the vertex file.
+            const string* failed = &relink.vertexFile;
+            try {
+                Shader vertex{ Shader::Vertex, relink.vertexSource };
+                failed = &relink.fragmentFile;
+                Shader fragment{ Shader::Fragment, relink.fragmentSource };
+                failed = &relink.vertexFile;
+                Program fresh{ vertex, fragment };
+                fresh.Adopt(*relink.program);
+                relink.program->swap(fresh);
+            }
+            catch (const exception& error) {
+                _report(*failed, error.what());
+            }
+        }
+
+        size_t sent = 0;
+        while (sent < _budget) {
+            if (_current) {
+                // A newer version of the same file overtakes this upload.
+                lock_guard<mutex> hold{ _lock };
+                if (any_of(_decoded.begin(), _decoded.end(), [this](const Decoded& decoded) { return decoded.filename == _current->filename; })) {
+                    _current.reset();
+                    _staging.reset();
+                }
+            }
+            if (!_current) {
+                {
+                    lock_guard<mutex> hold{ _lock };
+                    if (_decoded.empty()) { break; }
+                    _current.reset(new Decoded{ move(_decoded.front()) });
+                    _decoded.pop_front();
+                }
+                _staging.reset(new Mesh{ *_current->source, false });
+                _offset = 0;
+            }
+
+            size_t count = _staging->Upload(*_current->source, _offset, _budget - sent);
+            _offset += count;
+            sent += count;
+            if (_offset < _current->source->bytes()) { continue; }
+
+            shared_ptr<Mesh> mesh;
+            {
+                lock_guard<mutex> hold{ _lock };
+                auto found = _meshes.find(_current->filename);
+                if (found != _meshes.end()) { mesh = found->second.lock(); }
+            }
+            // The previous contents leave with the staging mesh.
+            if (mesh) { mesh->swap(*_staging); }
+            _staging.reset();
+            _current.reset();
+        }
+        return sent;
+    }
+}
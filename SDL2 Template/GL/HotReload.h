@@ -0,0 +1,96 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_HOTRELOAD
+#define OPENGL_WRAPPER_HOTRELOAD
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Mesh.h"
+#include "Shader.h"
+#include "../IO/FileWatcher.h"
+
+namespace gl {
+    // Keeps meshes and programs current with the files they came from
+    // while the app runs. A worker thread waits for writes and re-reads
+    // only the file that changed; the GL thread uploads the result within
+    // a per-frame budget and swaps it into the existing Mesh or Program,
+    // so every Object using it draws the new version from the next frame.
+    // Apart from its own worker, use it from the GL thread only.
+    class HotReload {
+    public:
+        // Called on the GL thread when a changed file fails to load,
+        // compile or link. The previous version stays in use.
+        using Report = std::function<void(const std::string& filename, const std::string& error)>;
+
+        explicit HotReload(Report report, std::size_t frameBudget = 4 << 20);
+        ~HotReload();
+
+        HotReload(const HotReload&) = delete;
+        HotReload& operator= (const HotReload&) = delete;
+
+        // Loads filename now and reloads it whenever it changes, for as
+        // long as anything holds the mesh. Loading a file again returns the
+        // same mesh.
+        std::shared_ptr<const Mesh> Load(const std::string& filename);
+
+        // Relinks program from the two files whenever either changes.
+        // program must outlive this, or be passed to Forget first.
+        void Watch(Program& program, const std::string& vertexFile, const std::string& fragmentFile);
+        void Forget(const Program& program);
+
+        // Call on the GL thread once per frame, before drawing. Relinks
+        // changed programs, uploads changed meshes until the frame budget
+        // is spent and swaps in those that are complete. Returns the number
+        // of mesh bytes sent.
+        std::size_t Update();
+    private:
+        struct Watched {
+            Program* program;
+            std::string vertexFile, fragmentFile;
+        };
+        struct Decoded {
+            std::string filename;
+            std::unique_ptr<Mesh::Source> source;
+        };
+        struct Relink {
+            Program* program;
+            std::string vertexFile, fragmentFile;
+            std::string vertexSource, fragmentSource;
+        };
+        struct Failure {
+            std::string filename, error;
+        };
+
+        Report _report;
+        std::size_t _budget;
+        io::FileWatcher _watcher;
+
+        mutable std::mutex _lock;
+        std::unordered_map<std::string, std::weak_ptr<Mesh>> _meshes;
+        std::vector<Watched> _programs;
+        // At most one entry per file; a newer version replaces the queued one.
+        std::deque<Decoded> _decoded;
+        std::vector<Relink> _relinks;
+        std::vector<Failure> _failures;
+        bool _stopping;
+        std::thread _worker;
+
+        // Touched only by the GL thread.
+        std::unique_ptr<Decoded> _current;
+        std::unique_ptr<Mesh> _staging;
+        std::size_t _offset;
+
+        void Work();
+        void Reload(const std::string& filename);
+    };
+}
+
+#endif
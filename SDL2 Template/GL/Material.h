@@ -0,0 +1,26 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_MATERIAL
+#define OPENGL_WRAPPER_MATERIAL
+
+#include <string>
+
+#include "OpenGL.h"
+
+namespace gl {
+    // Surface settings from an MTL newmtl block. Colours left out of the
+    // file keep these defaults.
+    struct Material {
+        std::string name;
+        ColorAlpha diffuse{ 1.0f };
+        Color specular{ 0.0f };
+        Float shininess = 0.0f;
+        // map_Kd as written, relative to the MTL file.
+        std::string diffuseMap;
+        // Where diffuseMap lies in the texture drawn from, as the uv lower
+        // corner and extent: all of it unless packed into a TextureAtlas.
+        Vector4 diffuseRegion{ 0.0f, 0.0f, 1.0f, 1.0f };
+    };
+}
+
+#endif
@@ -8,155 +8,343 @@
 
 #include "Mesh.h"
 
-#include <iostream>
-#include <fstream>
-#include <sstream>
-#include <unordered_map>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+
+#include "OBJmesh.h"
+#include "MeshFile.h"
+#include "GlbFile.h"
 
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
 using namespace std;
 
-class OBJmesh {
-public:
-	using vertex_type = gl::Vertex;
-	using index_type = gl::Ushort;
-	using count_type = gl::Ushort;
-
-	OBJmesh(const string& filename);
-	const vector<vertex_type>& vData() const { return vertices; }
-	const vector<index_type>& fData() const { return faces; }
-	const vector<count_type>& faceSegments() const { return ranges; }
-private:
-	vector<vertex_type> vertices;
-	vector<index_type> faces;
-	vector<count_type> ranges;
-
-	struct Index {
-		gl::Short p, t, n;
-		Index(const string& encoding, gl::Short pCount, gl::Short tCount, gl::Short nCount);
-
-		bool operator==(const Index& other) const
+namespace gl {
+	namespace {
+		// Faults a mapping in here rather than in the middle of a frame.
+		void Prefault(const io::MappedFile& file)
+		{
+			volatile Ubyte sink = 0;
+			for (size_t at = 0; at < file.size(); at += 4096) { sink = sink + static_cast<Ubyte>(file.data()[at]); }
+		}
+
+		Size IndexSize(TypeCode type)
 		{
-			return ((p == other.p) || (p < 0 && other.p < 0))
-				&& ((t == other.t) || (t < 0 && other.t < 0))
-				&& ((n == other.n) || (n < 0 && other.n < 0));
+			return type == TypeCode::Uint ? 4 : type == TypeCode::Ushort ? 2 : 1;
 		}
-	private:
-		gl::Short Enter(istream& source, gl::Short limit)
+
+		// Names the part each surface draws from, found by its first vertex.
+		vector<Mesh::Binding> PartBindings(const Mesh::Source& source)
 		{
-			gl::Short result;
-			if (source.peek() != '/' && source >> result) {
-				result = result < 0 ? limit - result : --result;
+			vector<Mesh::Binding> result;
+			if (source.parts.empty()) { return result; }
+			for (const Mesh::SubMesh& surface : source.surfaces) {
+				Uint part = 0;
+				if (surface.count) {
+					Uint vertex = ReadElement(source.elementData, source.elementType, static_cast<size_t>(surface.start));
+					auto after = upper_bound(source.parts.begin(), source.parts.end(), vertex, [](Uint v, const Mesh::Part& p) { return v < static_cast<Uint>(p.first); });
+					part = after == source.parts.begin() ? 0 : static_cast<Uint>(after - source.parts.begin() - 1);
+				}
+				result.push_back(Mesh::Binding{ 0, source.elementType, 0, part });
 			}
-			else {
-				result = -1;
+			return result;
+		}
+
+		vector<Quantization> PartPacking(const Mesh::Source& source)
+		{
+			vector<Quantization> result;
+			for (const Mesh::Part& part : source.parts) {
+				result.push_back(Quantization{ part.lower, part.extent, part.uvLower, part.uvExtent, source.packing.octahedral });
 			}
-			source.ignore();
 			return result;
 		}
-	};
+	}
+
+	Mesh::Source::Source(const std::string& filename)
+		: file{ new io::MappedFile{ filename } }
+	{
+		if (MeshFile::Identify(*file)) {
+			MeshFile cooked{ *file };
+			const auto& header = cooked.header();
+			vertexData = reinterpret_cast<const Ubyte*>(cooked.vertices());
+			vertexBytes = size_t{ header.vertexCount } * sizeof(PackedVertex);
+			elementType = header.elementType;
+			elementData = static_cast<const Ubyte*>(cooked.elements());
+			elementBytes = size_t{ header.elementCount } * TypeAlloc[elementType];
+			surfaces.assign(cooked.surfaces(), cooked.surfaces() + header.surfaceCount);
+			levels.assign(cooked.levels(), cooked.levels() + header.levelCount);
+			clusters.assign(cooked.clusters(), cooked.clusters() + header.clusterCount);
+			materials = cooked.materials();
+			sphere = Sphere{ (header.lower + header.upper) * 0.5f, glm::distance(header.lower, header.upper) * 0.5f };
+			packing = cooked.quantization();
+			parts.assign(cooked.parts(), cooked.parts() + header.partCount);
 
-	class hash : public std::hash<string> {
-	public:
-		size_t operator() (Index const i) const {
-			return std::hash<string>::operator () (string(reinterpret_cast<char const*>(&i), sizeof(Index)));
+			if (cooked.compressed()) {
+				// Decoding here keeps the work on the loading thread.
+				cooked.Decode(packed, elements);
+				vertexData = reinterpret_cast<const Ubyte*>(packed.data());
+				elementData = elements.data();
+				bindings = PartBindings(*this);
+				file.reset();
+				return;
+			}
+			bindings = PartBindings(*this);
+			Prefault(*file);
+			return;
 		}
-	};
-};
 
-OBJmesh::Index::Index(const string& encoding, gl::Short pCount, gl::Short tCount, gl::Short nCount)
-{
-	istringstream description(encoding);
+		if (IdentifyGlb(*file)) {
+			LoadGlb(*file, *this);
+			Prefault(*file);
+			return;
+		}
 
-	p = Enter(description, pCount);
-	t = Enter(description, tCount);
-	n = Enter(description, nCount);
-}
+		OBJmesh source{ *file };
+		file.reset();
+		source.LoadMaterials(filesystem::path{ filename }.parent_path().string());
+		materials = source.materials();
+		vector<Uint> indices = source.fData();
+		surfaces = FaceSurfaces(source.faceSegments(), source.faceMaterials());
+		clusters = BuildClusters(source.vData(), indices, surfaces);
+		levels = BuildLevels(source.vData(), indices, surfaces);
+		elementType = NarrowestElement(source.vData().size());
+		elements = NarrowElements(indices, elementType);
+		packing = Quantize(source.vData());
+		PackParts(source.vData(), indices, surfaces, packing, packed, parts);
+		sphere = Sphere{ packing.lower + packing.extent * 0.5f, glm::length(packing.extent) * 0.5f };
 
-OBJmesh::OBJmesh(const string& filename)
-{
-/*
-	string line;
-	vector<gl::Point3> vList;
-	vector<gl::Vector3> vnList;
-	vector<gl::Vector2> vtList;
-	unordered_map<Index, gl::Short, OBJmesh::hash> verts;
-	for (ifstream source(filename); getline(source, line); ) {
-		istringstream input(line);
-		string command;
-		input >> command;
-		if (command == "v") {
-			gl::Point3 v;
-			input >> v.x >> v.y >> v.z;
-			vList.push_back(v);
-		}
-		else if (command == "vt") {
-			gl::Vector2 t;
-			input >> t.x >> t.y;
-			vtList.push_back(t);
-		}
-		else if (command == "vn") {
-			gl::Vector3 n;
-			input >> n.x >> n.y >> n.z;
-			vnList.push_back(n);
-		}
-		else if (command == "f") {
-			string corner;
-			int corners = 0;
-			while (input >> corner) {
-				Index id(corner, vList.size(), vtList.size(), vnList.size());
-				if (!verts.count(id)) {
-					gl::Vertex v;
-					if (id.p >= 0) v.position = vList[id.p];
-					if (id.t >= 0) v.uv = vtList[id.t];
-					if (id.n >= 0) v.normal = vnList[id.n];
-					verts[id] = vertices.size();
-					vertices.push_back(v);
-				}
-				corners++;
-				faces.push_back(verts[id]);
+		vertexData = reinterpret_cast<const Ubyte*>(packed.data());
+		vertexBytes = packed.size() * sizeof(PackedVertex);
+		elementData = elements.data();
+		elementBytes = elements.size();
+		bindings = PartBindings(*this);
+	}
+
+	Mesh::Mesh(const std::string& filename)
+		: Mesh{ Source{ filename } }
+	{}
+
+	Mesh::Mesh(const Source& source, bool upload)
+		: elementType{ source.elementType }, elementSize{ IndexSize(source.elementType) }, bindings{ source.bindings },
+		surfaces{ source.surfaces }, levels{ source.levels }, clusters{ source.clusters },
+		library{ source.materials }, sphere{ source.sphere }, packing{ source.packing }, parts{ PartPacking(source) }, byteCount{ source.bytes() }
+	{
+		// Bind the array first so the element buffer attaches to it.
+		vertices.Activate();
+		if (upload) {
+			vertexData.Load(ArrayBuffer::StaticDraw, source.vertexData, source.vertexBytes);
+			elementData.Load(ElementArrayBuffer::StaticDraw, source.elementData, source.elementBytes);
+		}
+		else {
+			vertexData.Reserve(ArrayBuffer::StaticDraw, source.vertexBytes);
+			elementData.Reserve(ElementArrayBuffer::StaticDraw, source.elementBytes);
+		}
+
+		if (source.layouts.empty()) { AttachPacked(vertices, vertexData); }
+		for (const auto& layout : source.layouts) {
+			arrays.emplace_back(new Vertex::Array{});
+			*arrays.back() << elementData;
+			// Attributes disable their channel when they go, so the array
+			// is let go first.
+			std::vector<Vertex::Attribute> attributes;
+			attributes.reserve(layout.size());
+			for (const Attribute& attribute : layout) {
+				attributes.emplace_back(attribute.channel, vertexData, attribute.count, attribute.type, attribute.normalized, attribute.stride, attribute.offset);
+				*arrays.back() << attributes.back();
 			}
-			ranges.push_back(corners);
+			Vertex::Array::Deactivate();
 		}
+		ArrayBuffer::Deactivate();
+		ElementArrayBuffer::Deactivate();
 	}
-*/
-}
 
-vector<OBJmesh::count_type> loadShape(const string& filename, gl::Vertex::Array& vertexArray)
-{
-	OBJmesh source{ filename };
+	Mesh::Mesh(const Source& source, std::shared_ptr<void> storage)
+		: elementType{ source.elementType }, elementSize{ IndexSize(source.elementType) }, surfaces{ source.surfaces }, levels{ source.levels }, clusters{ source.clusters },
+		library{ source.materials }, sphere{ source.sphere }, packing{ source.packing }, parts{ PartPacking(source) }, byteCount{ 0 }, storage{ move(storage) }
+	{}
 
-	//gl::ArrayBuffer vbo;
-	//gl::ElementArrayBuffer ebo;
-	//vbo.Load(GL_STATIC_DRAW, source.vData());
-	//vertexArray.Bind(vbo);
+	void Mesh::AttachPacked(Vertex::Array& array, ArrayBuffer& contents)
+	{
+		Vertex::ArrayAttribute<Ushort[3], PackedVertex> position{ Position, contents, GL_TRUE, static_cast<Size>(offsetof(PackedVertex, position)) };
+		Vertex::ArrayAttribute<Short[2], PackedVertex> normal{ Normal, contents, GL_TRUE, static_cast<Size>(offsetof(PackedVertex, normal)) };
+		Vertex::ArrayAttribute<Ushort[2], PackedVertex> uv{ UV, contents, GL_TRUE, static_cast<Size>(offsetof(PackedVertex, uv)) };
+		array << position << normal << uv;
+		Vertex::Array::Deactivate();
+	}
 
-	//vertexArray.Activate();
-	//ebo.Load(GL_STATIC_DRAW, source.fData());
-	//vertexArray.Deactivate();
+	std::size_t Mesh::Upload(const Source& source, std::size_t offset, std::size_t limit)
+	{
+		const size_t vertexBytes = source.vertexBytes;
+		const Ubyte* vertexBlob = source.vertexData;
+		size_t sent = 0;
 
-	//ebo.Release();
-	//vbo.Release();
+		// The element buffer binding belongs to the vertex array.
+		vertices.Activate();
+		if (offset < vertexBytes && sent < limit) {
+			size_t count = min(vertexBytes - offset, limit - sent);
+			vertexData.Update(offset, vertexBlob + offset, count);
+			sent += count;
+			offset += count;
+		}
+		if (offset >= vertexBytes && offset - vertexBytes < source.elementBytes && sent < limit) {
+			size_t inset = offset - vertexBytes;
+			size_t count = min(source.elementBytes - inset, limit - sent);
+			elementData.Update(inset, source.elementData + inset, count);
+			sent += count;
+		}
+		Vertex::Array::Deactivate();
+		ArrayBuffer::Deactivate();
+		return sent;
+	}
 
-	return source.faceSegments();
-}
+	void Mesh::swap(Mesh& other) noexcept
+	{
+		using std::swap;
+		vertices.swap(other.vertices);
+		vertexData.swap(other.vertexData);
+		elementData.swap(other.elementData);
+		swap(elementType, other.elementType);
+		swap(elementSize, other.elementSize);
+		swap(arrays, other.arrays);
+		swap(bindings, other.bindings);
+		swap(surfaces, other.surfaces);
+		swap(levels, other.levels);
+		swap(clusters, other.clusters);
+		swap(library, other.library);
+		swap(sphere, other.sphere);
+		swap(packing, other.packing);
+		swap(parts, other.parts);
+		swap(byteCount, other.byteCount);
+		swap(storage, other.storage);
+	}
 
-namespace gl {
-	Mesh::Mesh(const std::string& filename)
-	{}
+	Mesh::Binding Mesh::Select(std::size_t& current, Size surface) const
+	{
+		if (bindings.empty()) { return Binding{ 0, elementType, 0, 0 }; }
+		// Packed meshes without arrays of their own draw every binding from
+		// vertices, which current already names.
+		const Binding& binding = bindings[surface];
+		if (binding.layout != current) {
+			arrays[binding.layout]->Activate();
+			current = binding.layout;
+		}
+		return binding;
+	}
+
+	void Mesh::Draw(const SubMesh& surface, const Binding& binding) const
+	{
+		Size size = binding.elementType == elementType ? elementSize : IndexSize(binding.elementType);
+		void* offset = reinterpret_cast<void*>(static_cast<uintptr_t>(surface.start) * size);
+		if (binding.baseVertex) {
+			glDrawElementsBaseVertex(surface.mode, surface.count, static_cast<GLenum>(binding.elementType), offset, binding.baseVertex);
+		}
+		else {
+			glDrawElements(surface.mode, surface.count, static_cast<GLenum>(binding.elementType), offset);
+		}
+	}
+
+	void Mesh::Bind(std::size_t& current, std::size_t& part, Size surface, const Binding& binding, const MaterialSwitch& bind) const
+	{
+		Uint material = surfaces[surface].material;
+		bool named = material < library.size();
+		bool switched = named && material != current;
+		bool unpacked = !parts.empty() && binding.part != part;
+		if (!bind && !parts.empty()) { throw logic_error{ "Mesh packed in parts drawn without a MaterialSwitch" }; }
+		if (!bind || !(switched || unpacked)) { return; }
+		bind(named ? &library[material] : nullptr, parts.empty() ? packing : parts[binding.part]);
+		current = material;
+		part = binding.part;
+	}
+
+	void Mesh::Render(const MaterialSwitch& bind) const 
+	{
+		if (levels.empty()) { return; }
+		RenderLevel(0, bind);
+	}
+
+	void Mesh::Render(std::size_t surface, const MaterialSwitch& bind) const
+	{
+		const SubMesh& drawn = surfaces.at(surface);
+		size_t current = library.size();
+		size_t part = parts.size();
+		size_t layout = arrays.size();
+		vertices.Activate();
+		Binding binding = Select(layout, static_cast<Size>(surface));
+		Bind(current, part, static_cast<Size>(surface), binding, bind);
+		Draw(drawn, binding);
+		vertices.Deactivate();
+	}
+
+	void Mesh::RenderLevel(std::size_t level, const MaterialSwitch& bind) const
+	{
+		const Level& lod = levels.at(level);
+		size_t current = library.size();
+		size_t part = parts.size();
+		size_t layout = arrays.size();
+		vertices.Activate();
+		for (Size s = lod.first; s < lod.first + lod.count; ++s) {
+			Binding binding = Select(layout, s);
+			Bind(current, part, s, binding, bind);
+			Draw(surfaces[s], binding);
+		}
+		vertices.Deactivate();
+	}
 
-	void Mesh::Render() const 
+	void Mesh::RenderVisible(const Matrix4& model, const Matrix4& view, const Matrix4& projection, const MaterialSwitch& bind) const
 	{
+		if (levels.empty()) { return; }
+		// Frustum planes and the eye, both carried back into model space.
+		Matrix4 clip = projection * view * model;
+		Vector4 planes[6];
+		for (int axis = 0; axis < 3; ++axis) {
+			Vector4 row{ clip[0][axis], clip[1][axis], clip[2][axis], clip[3][axis] };
+			Vector4 w{ clip[0][3], clip[1][3], clip[2][3], clip[3][3] };
+			planes[axis * 2] = w + row;
+			planes[axis * 2 + 1] = w - row;
+		}
+		for (auto& plane : planes) { plane /= glm::length(Vector3{ plane }); }
+		Point3 eye{ glm::inverse(view * model)[3] };
+
+		auto visible = [&](const Cluster& cluster) {
+			const Sphere& bounds = cluster.bounds;
+			for (const auto& plane : planes) {
+				if (glm::dot(Vector3{ plane }, bounds.center) + plane.w < -bounds.radius) { return false; }
+			}
+			Vector3 ray = bounds.center - eye;
+			return glm::dot(ray, cluster.axis) < cluster.cutoff * glm::length(ray) + bounds.radius;
+		};
+		size_t current = library.size();
+		size_t part = parts.size();
+		size_t layout = arrays.size();
 		vertices.Activate();
-		GLushort position = 0;
-		for (auto& surface : surfaces) {
-			glDrawElements(
-				surface.mode, 
-				surface.count, 
-				static_cast<GLenum>(elementType), 
-				reinterpret_cast<void*>(surface.start * TypeAlloc[elementType])
-			);
+		auto cluster = clusters.begin();
+		const Level& full = levels.front();
+		for (Size s = full.first; s < full.first + full.count; ++s) {
+			const SubMesh& surface = surfaces[s];
+			Binding binding = Select(layout, s);
+			if (cluster == clusters.end() || cluster->surface != s) {
+				Bind(current, part, s, binding, bind);
+				Draw(surface, binding);
+				continue;
+			}
+			// Visible clusters that follow each other in the element buffer
+			// are drawn as one range.
+			SubMesh run{ Triangles, 0, 0, surface.material };
+			for (; cluster != clusters.end() && cluster->surface == s; ++cluster) {
+				if (!visible(*cluster)) { continue; }
+				if (run.count && run.start + run.count == cluster->start) {
+					run.count += cluster->count;
+					continue;
+				}
+				if (run.count) { Draw(run, binding); }
+				Bind(current, part, s, binding, bind);
+				run.start = cluster->start;
+				run.count = cluster->count;
+			}
+			if (run.count) { Draw(run, binding); }
 		}
 		vertices.Deactivate();
 	}
@@ -166,17 +354,68 @@ namespace gl {
 	{}
 
 	Object::Object(std::shared_ptr<const Mesh> mesh, Program& program)
-		:	_mesh { mesh }, _program {program}, color{1}, highlight {0, 0, 0, 1}
+		:	_mesh { mesh }, _program {program}, color{1}, highlight {0, 0, 0, 1}, _level{ 0 }
 	{}
 
-	void Object::Render() const 
+	void Object::Prepare() const
 	{
+		const Quantization& packing = _mesh->quantization();
 		_program.Activate();
 		_program.Uniform<ColorAlpha>("color") = color;
 		_program.Uniform<Matrix4>("transform") = _transform;
 		_program.Uniform<Float>("shininess") = highlight.a;
 		_program.Uniform<Color>("specular_color") = Color{ highlight };
-		_mesh->Render();
+		_program.Uniform<Vector3>("position_lower") = packing.lower;
+		_program.Uniform<Vector3>("position_extent") = packing.extent;
+		_program.Uniform<Vector4>("uv_bounds") = Vector4{ packing.uvLower, packing.uvExtent };
+		_program.Uniform<Int>("octahedral_normals") = packing.octahedral;
+	}
+
+	void Object::Apply(const Material* material, const Quantization& packing) const
+	{
+		// The material's region of an atlas is applied after the part's own
+		// uv bounds.
+		Vector4 region = material ? material->diffuseRegion : Vector4{ 0.0f, 0.0f, 1.0f, 1.0f };
+		_program.Uniform<Vector3>("position_lower") = packing.lower;
+		_program.Uniform<Vector3>("position_extent") = packing.extent;
+		_program.Uniform<Vector4>("uv_bounds") = Vector4{ Vector2{ region } + packing.uvLower * Vector2{ region.z, region.w }, packing.uvExtent * Vector2{ region.z, region.w } };
+		if (!material) { return; }
+		_program.Uniform<ColorAlpha>("color") = color * material->diffuse;
+		_program.Uniform<Float>("shininess") = material->shininess;
+		_program.Uniform<Color>("specular_color") = material->specular;
+	}
+
+	void Object::Render() const 
+	{
+		Prepare();
+		_mesh->Render([this](const Material* material, const Quantization& packing) { Apply(material, packing); });
+	}
+
+	void Object::Render(const Matrix4& view, const Matrix4& projection, Float viewportHeight, Float tolerance)
+	{
+		// A level must fall this far under the tolerance before it is chosen.
+		constexpr Float hysteresis = 0.25f;
+
+		const Mesh::Sphere& bounds = _mesh->bounds();
+		Vector4 center = view * _transform * Vector4{ bounds.center, 1 };
+		Float scale = glm::sqrt(glm::max(
+			glm::max(glm::dot(Vector3{ _transform[0] }, Vector3{ _transform[0] }), glm::dot(Vector3{ _transform[1] }, Vector3{ _transform[1] })),
+			glm::dot(Vector3{ _transform[2] }, Vector3{ _transform[2] })
+		));
+		// Pixels covered by one model unit at the nearest point of the bounds.
+		Float distance = glm::max(glm::length(Vector3{ center }) - bounds.radius * scale, 1e-3f);
+		Float pixels = scale * projection[1][1] * viewportHeight * 0.5f / distance;
+
+		std::size_t count = _mesh->levelCount();
+		if (count == 0) { return; }
+		_level = glm::min(_level, count - 1);
+		while (_level > 0 && _mesh->levelError(_level) * pixels > tolerance) { --_level; }
+		while (_level + 1 < count && _mesh->levelError(_level + 1) * pixels <= tolerance * (1 - hysteresis)) { ++_level; }
+
+		Prepare();
+		auto apply = [this](const Material* material, const Quantization& packing) { Apply(material, packing); };
+		if (_level) { _mesh->RenderLevel(_level, apply); }
+		else { _mesh->RenderVisible(_transform, view, projection, apply); }
 	}
 
 	void Object::Rotate(float angle, Vector3 axis) 
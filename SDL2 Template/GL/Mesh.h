@@ -11,11 +11,15 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <functional>
 
 #include "OpenGL.h"
 #include "Buffer.h"
 #include "Vertex.h"
+#include "PackedVertex.h"
+#include "Material.h"
 #include "Shader.h"
+#include "../IO/MappedFile.h"
 
 #include "glm/glm.hpp"
 
@@ -32,19 +36,185 @@ namespace gl {
 			Triangles = GL_TRIANGLES, 
 			Patches = GL_PATCHES
 		};
+		// Attribute locations the mesh binds its vertex layout to.
+		enum Channel : Uint {
+			Position = 0,
+			Normal = 1,
+			UV = 2,
+		};
 		struct SubMesh {
 			Assembly mode;
 			Size start;
 			Size count;
+			Uint material;
+		};
+		// A run of surfaces drawing the whole mesh at one level of detail,
+		// sorted by material. Coarser levels simplify the same vertices;
+		// error is the largest distance from the full mesh, in model units.
+		struct Level {
+			Size first;
+			Size count;
+			Float error;
+		};
+		struct Sphere {
+			Point3 center;
+			Float radius;
+		};
+		// A run of at most 64 vertices and 124 triangles inside a triangle
+		// surface. The cluster faces away from an eye at e when
+		// dot(center - e, axis) >= cutoff * |center - e| + radius; cutoff
+		// is 1 when the normals spread too far for that to ever hold.
+		struct Cluster {
+			Size surface;
+			Size start;
+			Size count;
+			Sphere bounds;
+			Vector3 axis;
+			Float cutoff;
+		};
+		// Where one attribute of a vertex layout taken from the file sits
+		// in the vertex data.
+		struct Attribute {
+			Channel channel;
+			Uint count;
+			TypeCode type;
+			Bool normalized;
+			Size stride;
+			Size offset;
+		};
+		// A run of packed vertices quantized against its own bounds rather
+		// than the mesh's, so a part repeated across files packs to the same
+		// bytes in each. Every surface draws from a single part.
+		struct Part {
+			Size first;
+			Size count;
+			Point3 lower;
+			Vector3 extent;
+			Vector2 uvLower;
+			Vector2 uvExtent;
+		};
+		// The layout and element type a surface draws with, the value added
+		// to its indices, for surfaces drawn from shared storage, and the
+		// part its packed vertices decode with.
+		struct Binding {
+			Uint layout;
+			TypeCode elementType;
+			Int baseVertex;
+			Uint part;
 		};
+		// Everything a mesh needs read and decoded before any GL call, so it
+		// can be built on a worker thread. Cooked and glTF binary files are
+		// viewed in place through their mapping; OBJ files are parsed into
+		// owned blobs.
+		struct Source {
+			explicit Source(const std::string& filename);
+
+			const Ubyte* vertexData;
+			std::size_t vertexBytes;
+			const Ubyte* elementData;
+			std::size_t elementBytes;
+			TypeCode elementType;
+			std::vector<SubMesh> surfaces;
+			std::vector<Level> levels;
+			std::vector<Cluster> clusters;
+			std::vector<Material> materials;
+			Sphere sphere;
+			Quantization packing;
+			// Runs of the packed vertices each quantized against their own
+			// bounds; vertices outside them, which no surface draws, use
+			// packing. Empty when every vertex uses packing.
+			std::vector<Part> parts;
+			// Set when the file brings its own vertex layouts, one binding
+			// per surface. Otherwise the vertex data is PackedVertex records
+			// and every surface uses elementType, so the bindings, if any,
+			// only name each surface's part.
+			std::vector<std::vector<Attribute>> layouts;
+			std::vector<Binding> bindings;
+
+			std::size_t bytes() const { return vertexBytes + elementBytes; }
+		private:
+			std::unique_ptr<io::MappedFile> file;
+			std::vector<PackedVertex> packed;
+			std::vector<Ubyte> elements;
+		};
+
 		Mesh(const std::string& filename);
-		void Render() const;
-		void Render(std::size_t index) const;
+		// Creates the GL objects for source. Unless upload is set the buffers
+		// are only sized, and the contents follow through Upload.
+		explicit Mesh(const Source& source, bool upload = true);
+		// Sends at most limit bytes of source, starting offset bytes into its
+		// vertex and then element data. Returns how many bytes were sent.
+		std::size_t Upload(const Source& source, std::size_t offset, std::size_t limit);
+		// Called before surfaces are drawn whenever their material, or for
+		// meshes packed in parts their vertex decoding, changes. material is
+		// null when the surfaces have none.
+		using MaterialSwitch = std::function<void(const Material* material, const Quantization& packing)>;
+
+		// Every draw takes a MaterialSwitch; meshes packed in parts cannot
+		// be drawn without one, since each part decodes differently. Meshes
+		// without levels, as a cooked file may store, draw nothing.
+		void Render(const MaterialSwitch& bind = {}) const;
+		void Render(std::size_t surface, const MaterialSwitch& bind = {}) const;
+		// Level 0 is the full mesh; higher levels are progressively coarser.
+		void RenderLevel(std::size_t level, const MaterialSwitch& bind = {}) const;
+		// Draws the full mesh, skipping clusters outside the frustum or
+		// facing away from the eye. Adjacent visible clusters share a draw.
+		void RenderVisible(const Matrix4& model, const Matrix4& view, const Matrix4& projection, const MaterialSwitch& bind = {}) const;
+		std::size_t levelCount() const { return levels.size(); }
+		Float levelError(std::size_t level) const { return levels.at(level).error; }
+		// Empty for meshes without materials, whose surfaces all use index 0.
+		const std::vector<Material>& materials() const { return library; }
+		const Sphere& bounds() const { return sphere; }
+		// Decoding constants for the packed vertex attributes. Meshes packed
+		// in parts decode each with its own, passed to the MaterialSwitch.
+		const Quantization& quantization() const { return packing; }
+		// Bytes held in GL buffers.
+		std::size_t bytes() const { return byteCount; }
+		// Exchanges everything, GL objects included, with other, so Objects
+		// drawing either mesh draw the other's contents from then on.
+		void swap(Mesh& other) noexcept;
 	private:
+		friend class GeometryPool;
+
+		// Copies everything but the geometry, which lives in storage.
+		Mesh(const Source& source, std::shared_ptr<void> storage);
+
+
 		Vertex::Array vertices;
+		ArrayBuffer vertexData;
+		ElementArrayBuffer elementData;
+		// The narrowest index type that addresses every vertex, and its
+		// size in bytes. Surfaces bound to a layout from the file may use
+		// another type, named in their Binding.
 		TypeCode elementType;
 		Size elementSize;
+		// One vertex array per file-defined layout or shared block pair,
+		// used in place of vertices by the surfaces bound to it.
+		std::vector<std::shared_ptr<Vertex::Array>> arrays;
+		std::vector<Binding> bindings;
 		std::vector<SubMesh> surfaces;
+		std::vector<Level> levels;
+		std::vector<Cluster> clusters;
+		std::vector<Material> library;
+		Sphere sphere;
+		Quantization packing;
+		// Decoding for each part the bindings name; empty when every surface
+		// uses packing.
+		std::vector<Quantization> parts;
+		std::size_t byteCount;
+		// Keeps shared vertex and element ranges alive while this draws them.
+		std::shared_ptr<void> storage;
+
+		// Points array at PackedVertex records in contents.
+		static void AttachPacked(Vertex::Array& array, ArrayBuffer& contents);
+		// Activates the vertex array surface draws from, unless it is the
+		// current layout, and returns how to draw it.
+		Binding Select(std::size_t& current, Size surface) const;
+		void Draw(const SubMesh& surface, const Binding& binding) const;
+		// Calls bind if surface changes the material from current or the
+		// part from part. Throws logic_error if the mesh is packed in parts
+		// and bind is empty.
+		void Bind(std::size_t& current, std::size_t& part, Size surface, const Binding& binding, const MaterialSwitch& bind) const;
 	};
 
 	class Object {
@@ -53,6 +223,11 @@ namespace gl {
 		Object(std::shared_ptr<const Mesh> mesh, Program& program);
 
 		void Render() const;
+		// Draws the coarsest level whose error projects to no more than
+		// tolerance pixels. The level only changes once the error moves
+		// clear of the tolerance, so objects near the switching distance
+		// do not flicker between levels.
+		void Render(const Matrix4& view, const Matrix4& projection, Float viewportHeight, Float tolerance = 1.0f);
 
 		void Rotate(float angle, Vector3 axis);
 		void Translate(Vector3 distance);
@@ -67,5 +242,9 @@ namespace gl {
 		std::shared_ptr<const Mesh> _mesh;
 		Program& _program;
 		Matrix4 _transform;
+		std::size_t _level;
+
+		void Prepare() const;
+		void Apply(const Material* material, const Quantization& packing) const;
 	};
 }
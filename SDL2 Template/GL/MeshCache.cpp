@@ -0,0 +1,73 @@
+#include "MeshCache.h"
+
+#include <filesystem>
+
+#include "../IO/ContentHash.h"
+#include "../IO/MappedFile.h"
+using namespace std;
+
+namespace gl {
+    MeshCache::MeshCache(size_t budget)
+    :   _budget{ budget }, _used{ 0 }, _pool{ make_shared<GeometryPool>() }
+    {}
+
+    shared_ptr<const Mesh> MeshCache::Load(const string& filename)
+    {
+        namespace fs = std::filesystem;
+        Stamp stamp{ 0, fs::file_size(filename), static_cast<int64_t>(fs::last_write_time(filename).time_since_epoch().count()) };
+
+        auto path = _paths.find(filename);
+        if (path != _paths.end() && path->second.size == stamp.size && path->second.modified == stamp.modified) {
+            stamp.key = path->second.key;
+        }
+        else {
+            io::MappedFile file{ filename };
+            stamp.key = io::ContentHash(file.data(), file.size());
+            _paths[filename] = stamp;
+        }
+
+        auto found = _entries.find(stamp.key);
+        if (found != _entries.end()) {
+            _recent.splice(_recent.begin(), _recent, found->second.recent);
+            return found->second.mesh;
+        }
+
+        Mesh::Source source{ filename };
+        shared_ptr<const Mesh> mesh = _pool->Build(source);
+        size_t own = GeometryPool::Shares(source) ? 0 : mesh->bytes();
+        _recent.push_front(stamp.key);
+        _entries.emplace(stamp.key, Entry{ mesh, _recent.begin(), own });
+        _used += own;
+        Evict();
+        return mesh;
+    }
+
+    void MeshCache::Budget(size_t bytes)
+    {
+        _budget = bytes;
+        Evict();
+    }
+
+    void MeshCache::Clear()
+    {
+        _entries.clear();
+        _paths.clear();
+        _recent.clear();
+        _used = 0;
+    }
+
+    void MeshCache::Evict()
+    {
+        // Dropping a mesh something still draws would free nothing, and the
+        // next load of it would upload a second copy. Parts it shares with
+        // other meshes stay too, so a drop may free less than its size.
+        for (auto at = _recent.end(); used() > _budget && at != _recent.begin(); ) {
+            --at;
+            auto entry = _entries.find(*at);
+            if (entry->second.mesh.use_count() > 1) { continue; }
+            _used -= entry->second.own;
+            _entries.erase(entry);
+            at = _recent.erase(at);
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_MESHCACHE
+#define OPENGL_WRAPPER_MESHCACHE
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "Mesh.h"
+#include "GeometryPool.h"
+
+namespace gl {
+    // Hands out one shared Mesh per distinct file content. Entries are found
+    // by path, then by a hash of the bytes, so copies of a file under other
+    // names share buffers too. Meshes are built through a GeometryPool, so
+    // parts repeated across different files share storage as well. Once the
+    // meshes held exceed the budget, the least recently loaded ones that no
+    // Object still uses are dropped. Use from the GL thread only.
+    class MeshCache {
+    public:
+        explicit MeshCache(std::size_t budget);
+
+        std::shared_ptr<const Mesh> Load(const std::string& filename);
+
+        // Changes the budget, evicting at once if it shrank.
+        void Budget(std::size_t bytes);
+        std::size_t budget() const { return _budget; }
+        // GL bytes held by cached meshes, in use or not, with shared parts
+        // counted once.
+        std::size_t used() const { return _used + _pool->used(); }
+        const GeometryPool& pool() const { return *_pool; }
+        std::size_t size() const { return _entries.size(); }
+
+        void Clear();
+    private:
+        using Key = std::uint64_t;
+
+        struct Entry {
+            std::shared_ptr<const Mesh> mesh;
+            std::list<Key>::iterator recent;
+            // Bytes counted in _used; zero for meshes held in the pool.
+            std::size_t own;
+        };
+        // What the file looked like when it was last hashed, so unchanged
+        // files are not read again.
+        struct Stamp {
+            Key key;
+            std::uintmax_t size;
+            std::int64_t modified;
+        };
+
+        std::size_t _budget;
+        // Bytes of meshes that could not be built in the pool.
+        std::size_t _used;
+        std::shared_ptr<GeometryPool> _pool;
+        std::unordered_map<Key, Entry> _entries;
+        std::unordered_map<std::string, Stamp> _paths;
+        std::list<Key> _recent;
+
+        void Evict();
+    };
+}
+
+#endif
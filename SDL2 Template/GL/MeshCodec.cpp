@@ -0,0 +1,371 @@
+#include "MeshCodec.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <emmintrin.h>
+using namespace std;
+
+namespace {
+    // Vertices coded together; their planes stay in the L1 cache while
+    // being scattered back into vertices.
+    constexpr size_t BlockVertices = 256;
+    constexpr size_t GroupSize = 16;
+    // Indices decoded together, a whole number of triangles.
+    constexpr size_t BlockIndices = 3 * 512;
+
+    // Index codes below FirstStep refer to the next vertex or a corner of
+    // the previous triangle; Escape sends the step to the varint stream.
+    constexpr gl::Ubyte FirstStep = 4;
+    constexpr gl::Ubyte Escape = 255;
+
+    gl::Uint Zigzag(gl::Uint step)
+    {
+        return step << 1 ^ (step & 0x80000000u ? 0xFFFFFFFFu : 0u);
+    }
+
+    gl::Uint Unzigzag(gl::Uint zigzag)
+    {
+        return zigzag >> 1 ^ (0u - (zigzag & 1));
+    }
+
+    // What each code byte means, as masks so the decoder can merge the
+    // cases without branching: the step it stands for, whether to take the
+    // step, the next vertex or the escaped step, and which corner of the
+    // previous triangle it repeats, counting from 1. Codes that are not
+    // steps stand for a step of zero.
+    struct Meanings {
+        gl::Uint step[256];
+        gl::Uint stepped[256];
+        gl::Uint fresh[256];
+        gl::Uint escape[256];
+        gl::Uint corner[256];
+    };
+
+    const Meanings Meaning = [] {
+        Meanings meaning{};
+        meaning.fresh[0] = ~0u;
+        for (gl::Uint code = 1; code < FirstStep; ++code) { meaning.corner[code] = code; }
+        for (gl::Uint code = FirstStep; code < Escape; ++code) {
+            meaning.step[code] = Unzigzag(code - FirstStep);
+            meaning.stepped[code] = ~0u;
+        }
+        meaning.stepped[Escape] = ~0u;
+        meaning.escape[Escape] = ~0u;
+        return meaning;
+    }();
+
+    void WriteVarint(vector<gl::Ubyte>& out, gl::Uint value)
+    {
+        while (value >= 0x80) {
+            out.push_back(static_cast<gl::Ubyte>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<gl::Ubyte>(value));
+    }
+
+    // A Uint takes at most five varint bytes.
+    constexpr size_t VarintBytes = 5;
+
+    gl::Uint ReadVarint(const gl::Ubyte*& data, const gl::Ubyte* end)
+    {
+        gl::Uint result = 0;
+        for (unsigned shift = 0; shift < 7 * VarintBytes; shift += 7) {
+            if (data == end) { throw invalid_argument{ "Encoded indices are truncated" }; }
+            gl::Ubyte byte = *data++;
+            result |= static_cast<gl::Uint>(byte & 0x7Fu) << shift;
+            if (byte < 0x80) { return result; }
+        }
+        throw invalid_argument{ "Encoded indices are corrupt" };
+    }
+
+    // The same for when the caller knows VarintBytes are left.
+    gl::Uint ReadVarint(const gl::Ubyte*& data)
+    {
+        gl::Uint result = 0;
+        for (unsigned shift = 0; shift < 7 * VarintBytes; shift += 7) {
+            gl::Ubyte byte = *data++;
+            result |= static_cast<gl::Uint>(byte & 0x7Fu) << shift;
+            if (byte < 0x80) { return result; }
+        }
+        throw invalid_argument{ "Encoded indices are corrupt" };
+    }
+
+    // Escape codes among the first n, counted 16 at a time. Each byte lane
+    // counts at most n / 16 of them, which stays below 256 for a block.
+    size_t CountEscapes(const gl::Ubyte* codes, size_t n)
+    {
+        const __m128i escape = _mm_set1_epi8(static_cast<char>(Escape));
+        __m128i lanes = _mm_setzero_si128();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m128i code = _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i));
+            lanes = _mm_sub_epi8(lanes, _mm_cmpeq_epi8(code, escape));
+        }
+        __m128i sums = _mm_sad_epu8(lanes, _mm_setzero_si128());
+        size_t result = static_cast<size_t>(_mm_cvtsi128_si32(sums)) + static_cast<size_t>(_mm_cvtsi128_si32(_mm_unpackhi_epi64(sums, sums)));
+        for (; i < n; ++i) { result += codes[i] == Escape; }
+        return result;
+    }
+
+    template <typename T>
+    void Decode(const gl::Ubyte* data, const gl::Ubyte* limit, T* out, size_t count)
+    {
+        // Each index has a code byte at a fixed place, and the escaped steps
+        // of a block are read from the varint stream before the block, so
+        // the loop below never waits on a varint or mispredicts an escape.
+        if (static_cast<size_t>(limit - data) < count) { throw invalid_argument{ "Encoded indices are truncated" }; }
+        const gl::Ubyte* steps = data + count;
+        gl::Uint escaped[BlockIndices + 1] = {};
+        // The previous triangle, after a zero for codes that use no corner.
+        gl::Uint corners[4] = {};
+        gl::Uint last = 0, next = 0;
+        for (size_t first = 0; first < count; first += BlockIndices) {
+            const gl::Ubyte* codes = data + first;
+            size_t n = min(BlockIndices, count - first);
+            size_t escapes = CountEscapes(codes, n);
+            if (static_cast<size_t>(limit - steps) >= escapes * VarintBytes) {
+                for (size_t e = 0; e < escapes; ++e) { escaped[e] = Unzigzag(ReadVarint(steps)); }
+            }
+            else {
+                for (size_t e = 0; e < escapes; ++e) { escaped[e] = Unzigzag(ReadVarint(steps, limit)); }
+            }
+
+            // Only last and next carry over from one index to the next, and
+            // each moves by an add and a mask, with the rest worked out
+            // beside them. Codes that are not steps take a step of zero, so
+            // next can be raised past last + step whatever the code.
+            ptrdiff_t e = 0;
+            auto decode = [&](gl::Ubyte code) {
+                gl::Uint escape = Meaning.escape[code], fresh = Meaning.fresh[code];
+                gl::Uint reached = last + (Meaning.step[code] | (escaped[e] & escape));
+                e -= static_cast<gl::Int>(escape);
+                gl::Uint index = (reached & Meaning.stepped[code]) | ((next & fresh) | corners[Meaning.corner[code]]);
+                next = max(next - fresh, reached + 1);
+                last = index;
+                return index;
+            };
+            // Blocks hold whole triangles, so only the last can end partway.
+            size_t whole = n / 3 * 3;
+            for (size_t i = 0; i < whole; i += 3) {
+                gl::Uint x = decode(codes[i]), y = decode(codes[i + 1]), z = decode(codes[i + 2]);
+                out[first + i] = static_cast<T>(x);
+                out[first + i + 1] = static_cast<T>(y);
+                out[first + i + 2] = static_cast<T>(z);
+                corners[1] = x;
+                corners[2] = y;
+                corners[3] = z;
+            }
+            for (size_t i = whole; i < n; ++i) { out[first + i] = static_cast<T>(decode(codes[i])); }
+        }
+        if (steps != limit) { throw invalid_argument{ "Encoded indices are corrupt" }; }
+    }
+
+    gl::Ubyte Zigzag(gl::Ubyte delta)
+    {
+        return static_cast<gl::Ubyte>(delta << 1 ^ (delta & 0x80 ? 0xFF : 0x00));
+    }
+
+    // The 16 deltas of one group, packed at width 0-3 as 0, 2, 4 or 8 bits.
+    __m128i Unpack(unsigned width, const gl::Ubyte*& data, const gl::Ubyte* end)
+    {
+        static const size_t bytes[4] = { 0, 4, 8, 16 };
+        if (static_cast<size_t>(end - data) < bytes[width]) { throw invalid_argument{ "Encoded vertices are truncated" }; }
+
+        __m128i packed;
+        switch (width) {
+        case 0:
+            return _mm_setzero_si128();
+        case 1: {
+            int32_t bits;
+            memcpy(&bits, data, sizeof(bits));
+            packed = _mm_cvtsi32_si128(bits);
+            const __m128i mask = _mm_set1_epi8(0x03);
+            __m128i v0 = _mm_and_si128(packed, mask);
+            __m128i v1 = _mm_and_si128(_mm_srli_epi16(packed, 2), mask);
+            __m128i v2 = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+            __m128i v3 = _mm_and_si128(_mm_srli_epi16(packed, 6), mask);
+            packed = _mm_unpacklo_epi16(_mm_unpacklo_epi8(v0, v1), _mm_unpacklo_epi8(v2, v3));
+            break;
+        }
+        case 2: {
+            packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+            const __m128i mask = _mm_set1_epi8(0x0F);
+            packed = _mm_unpacklo_epi8(_mm_and_si128(packed, mask), _mm_and_si128(_mm_srli_epi16(packed, 4), mask));
+            break;
+        }
+        default:
+            packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            break;
+        }
+        data += bytes[width];
+        return packed;
+    }
+
+    // Writes 16 rows of 16 bytes, source pitch apart, as 16 columns.
+    void Transpose(const gl::Ubyte* source, size_t pitch, gl::Ubyte* destination, size_t stride)
+    {
+        __m128i a[16], b[16];
+        for (size_t j = 0; j < 16; ++j) { a[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + j * pitch)); }
+        // Each pass interleaves twice as many rows at half as many columns.
+        for (size_t j = 0; j < 8; ++j) {
+            b[j] = _mm_unpacklo_epi8(a[2 * j], a[2 * j + 1]);
+            b[j + 8] = _mm_unpackhi_epi8(a[2 * j], a[2 * j + 1]);
+        }
+        for (size_t h = 0; h < 16; h += 8) {
+            for (size_t j = 0; j < 4; ++j) {
+                a[h + j] = _mm_unpacklo_epi16(b[h + 2 * j], b[h + 2 * j + 1]);
+                a[h + j + 4] = _mm_unpackhi_epi16(b[h + 2 * j], b[h + 2 * j + 1]);
+            }
+        }
+        for (size_t h = 0; h < 16; h += 4) {
+            for (size_t j = 0; j < 2; ++j) {
+                b[h + j] = _mm_unpacklo_epi32(a[h + 2 * j], a[h + 2 * j + 1]);
+                b[h + j + 2] = _mm_unpackhi_epi32(a[h + 2 * j], a[h + 2 * j + 1]);
+            }
+        }
+        for (size_t h = 0; h < 16; h += 2) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + h * stride), _mm_unpacklo_epi64(b[h], b[h + 1]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + (h + 1) * stride), _mm_unpackhi_epi64(b[h], b[h + 1]));
+        }
+    }
+}
+
+namespace gl {
+    vector<Ubyte> EncodeIndices(const vector<Uint>& indices)
+    {
+        vector<Ubyte> result, steps;
+        result.reserve(indices.size());
+        Uint last = 0, next = 0, previous[3] = {}, current[3] = {};
+        for (size_t i = 0, corner = 0; i < indices.size(); ++i) {
+            Uint index = indices[i];
+            Uint zigzag = Zigzag(index - last);
+            bool stepped = false;
+            if (index == next) { result.push_back(0); }
+            else if (index == previous[0]) { result.push_back(1); }
+            else if (index == previous[1]) { result.push_back(2); }
+            else if (index == previous[2]) { result.push_back(3); }
+            else if (zigzag < Escape - FirstStep) {
+                result.push_back(static_cast<Ubyte>(zigzag + FirstStep));
+                stepped = true;
+            }
+            else {
+                result.push_back(Escape);
+                WriteVarint(steps, zigzag);
+                stepped = true;
+            }
+            // Moves next exactly as Decode does. Short of indices at the
+            // very top of the range this is one past the highest so far.
+            next = max(next + (index == next), (stepped ? index : last) + 1);
+            last = index;
+            current[corner] = index;
+            if (++corner == 3) {
+                copy(begin(current), end(current), previous);
+                corner = 0;
+            }
+        }
+        result.insert(result.end(), steps.begin(), steps.end());
+        return result;
+    }
+
+    void DecodeIndices(const Ubyte* data, size_t size, void* indices, size_t count, TypeCode type)
+    {
+        switch (type) {
+        case TypeCode::Ubyte: Decode(data, data + size, static_cast<Ubyte*>(indices), count); break;
+        case TypeCode::Ushort: Decode(data, data + size, static_cast<Ushort*>(indices), count); break;
+        case TypeCode::Uint: Decode(data, data + size, static_cast<Uint*>(indices), count); break;
+        default: throw invalid_argument{ "Unsupported element type" };
+        }
+    }
+
+    vector<Ubyte> EncodeVertices(const void* vertices, size_t count, size_t stride)
+    {
+        auto in = static_cast<const Ubyte*>(vertices);
+        vector<Ubyte> result;
+        vector<Ubyte> last(stride, 0);
+        Ubyte plane[BlockVertices];
+        for (size_t first = 0; first < count; first += BlockVertices) {
+            size_t n = min(BlockVertices, count - first);
+            size_t groups = (n + GroupSize - 1) / GroupSize;
+            for (size_t k = 0; k < stride; ++k) {
+                // The padding after the last vertex is zero deltas.
+                Ubyte previous = last[k];
+                for (size_t v = 0; v < groups * GroupSize; ++v) {
+                    Ubyte value = v < n ? in[(first + v) * stride + k] : previous;
+                    plane[v] = Zigzag(static_cast<Ubyte>(value - previous));
+                    previous = value;
+                }
+                last[k] = previous;
+
+                size_t header = result.size();
+                result.resize(header + (groups + 3) / 4, 0);
+                for (size_t g = 0; g < groups; ++g) {
+                    const Ubyte* z = &plane[g * GroupSize];
+                    Ubyte top = *max_element(z, z + GroupSize);
+                    unsigned width = top == 0 ? 0 : top < 4 ? 1 : top < 16 ? 2 : 3;
+                    result[header + g / 4] |= static_cast<Ubyte>(width << (g % 4 * 2));
+                    switch (width) {
+                    case 1:
+                        for (size_t j = 0; j < 4; ++j) { result.push_back(static_cast<Ubyte>(z[j * 4] | z[j * 4 + 1] << 2 | z[j * 4 + 2] << 4 | z[j * 4 + 3] << 6)); }
+                        break;
+                    case 2:
+                        for (size_t j = 0; j < 8; ++j) { result.push_back(static_cast<Ubyte>(z[j * 2] | z[j * 2 + 1] << 4)); }
+                        break;
+                    case 3:
+                        result.insert(result.end(), z, z + GroupSize);
+                        break;
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    void DecodeVertices(const Ubyte* data, size_t size, void* vertices, size_t count, size_t stride)
+    {
+        const Ubyte* end = data + size;
+        auto out = static_cast<Ubyte*>(vertices);
+        vector<Ubyte> last(stride, 0);
+        vector<Ubyte> planes(stride * BlockVertices);
+        const __m128i one = _mm_set1_epi8(1), low = _mm_set1_epi8(0x7F);
+        for (size_t first = 0; first < count; first += BlockVertices) {
+            size_t n = min(BlockVertices, count - first);
+            size_t groups = (n + GroupSize - 1) / GroupSize;
+            for (size_t k = 0; k < stride; ++k) {
+                const Ubyte* header = data;
+                if (static_cast<size_t>(end - data) < (groups + 3) / 4) { throw invalid_argument{ "Encoded vertices are truncated" }; }
+                data += (groups + 3) / 4;
+
+                __m128i running = _mm_set1_epi8(static_cast<char>(last[k]));
+                for (size_t g = 0; g < groups; ++g) {
+                    __m128i z = Unpack(header[g / 4] >> (g % 4 * 2) & 3, data, end);
+                    __m128i delta = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(z, 1), low), _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(z, one)));
+                    // Prefix sum across the 16 lanes, then on from the last group.
+                    delta = _mm_add_epi8(delta, _mm_slli_si128(delta, 1));
+                    delta = _mm_add_epi8(delta, _mm_slli_si128(delta, 2));
+                    delta = _mm_add_epi8(delta, _mm_slli_si128(delta, 4));
+                    delta = _mm_add_epi8(delta, _mm_slli_si128(delta, 8));
+                    __m128i value = _mm_add_epi8(delta, running);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(&planes[k * BlockVertices + g * GroupSize]), value);
+                    // Broadcast lane 15.
+                    running = _mm_unpackhi_epi8(value, value);
+                    running = _mm_shufflehi_epi16(running, 0xFF);
+                    running = _mm_unpackhi_epi64(running, running);
+                }
+                last[k] = planes[k * BlockVertices + n - 1];
+            }
+
+            // Whole 16 x 16 tiles are transposed in registers, the edges a byte at a time.
+            size_t tiled = stride / GroupSize * GroupSize, rows = n / GroupSize * GroupSize;
+            for (size_t k = 0; k < tiled; k += GroupSize) {
+                for (size_t v = 0; v < rows; v += GroupSize) { Transpose(&planes[k * BlockVertices + v], BlockVertices, out + (first + v) * stride + k, stride); }
+            }
+            for (size_t k = 0; k < stride; ++k) {
+                for (size_t v = k < tiled ? rows : 0; v < n; ++v) { out[(first + v) * stride + k] = planes[k * BlockVertices + v]; }
+            }
+        }
+        if (data != end) { throw invalid_argument{ "Encoded vertices are corrupt" }; }
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_MESHCODEC
+#define OPENGL_WRAPPER_MESHCODEC
+
+#include <cstddef>
+#include <vector>
+
+#include "OpenGL.h"
+
+namespace gl {
+    // Lossless coding for index and vertex blobs. Both decoders check
+    // every read against size and throw if the data is corrupt.
+
+    // Each index gets a code byte: 0 for the next unused vertex, 1-3 for a
+    // corner of the previous triangle, as in strips and cache-ordered
+    // lists, otherwise 4 plus the zigzagged step from the last index.
+    // Steps too large for a byte follow the codes as varints.
+    std::vector<Ubyte> EncodeIndices(const std::vector<Uint>& indices);
+    // Writes count indices of the given type.
+    void DecodeIndices(const Ubyte* data, std::size_t size, void* indices, std::size_t count, TypeCode type);
+
+    // Splits vertices of stride bytes into one plane per byte, deltas each
+    // plane against the vertex before and packs the deltas of every 16
+    // vertices into 0, 2, 4 or 8 bits.
+    std::vector<Ubyte> EncodeVertices(const void* vertices, std::size_t count, std::size_t stride);
+    void DecodeVertices(const Ubyte* data, std::size_t size, void* vertices, std::size_t count, std::size_t stride);
+}
+
+#endif
@@ -0,0 +1,469 @@
+#include "MeshFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include "MeshCodec.h"
+#include "MeshOptimizer.h"
+#include "OBJmesh.h"
+using namespace std;
+
+namespace {
+    template <typename T>
+    void Narrow(const vector<gl::Uint>& source, vector<gl::Ubyte>& destination)
+    {
+        destination.resize(source.size() * sizeof(T));
+        T* out = reinterpret_cast<T*>(destination.data());
+        for (gl::Uint index : source) { *out++ = static_cast<T>(index); }
+    }
+
+    template <typename T>
+    gl::Uint Highest(const gl::Ubyte* data, size_t count)
+    {
+        const T* indices = reinterpret_cast<const T*>(data);
+        T highest = 0;
+        for (size_t i = 0; i < count; ++i) { highest = max(highest, indices[i]); }
+        return highest;
+    }
+
+    // The GL reads whatever vertex an index names, so every index a cooked
+    // file hands to it must name one of its vertices.
+    void CheckElements(const gl::Ubyte* data, gl::TypeCode type, size_t count, gl::Uint vertexCount)
+    {
+        using gl::TypeCode;
+        if (!count) { return; }
+        gl::Uint highest = type == TypeCode::Ubyte ? Highest<gl::Ubyte>(data, count)
+            : type == TypeCode::Ushort ? Highest<gl::Ushort>(data, count) : Highest<gl::Uint>(data, count);
+        if (highest >= vertexCount) { throw invalid_argument{ "Cooked mesh has an element past its vertices" }; }
+    }
+
+    size_t Align(size_t offset)
+    {
+        return (offset + gl::MeshFile::Alignment - 1) & ~(gl::MeshFile::Alignment - 1);
+    }
+
+    void ClusterBounds(gl::Mesh::Cluster& cluster, const vector<gl::Vertex>& vertices, const gl::Uint* indices)
+    {
+        using namespace gl;
+        Point3 lower = vertices[indices[0]].position, upper = lower;
+        for (Size i = 0; i < cluster.count; ++i) {
+            lower = glm::min(lower, vertices[indices[i]].position);
+            upper = glm::max(upper, vertices[indices[i]].position);
+        }
+        cluster.bounds.center = (lower + upper) * 0.5f;
+        cluster.bounds.radius = 0.0f;
+        for (Size i = 0; i < cluster.count; ++i) {
+            cluster.bounds.radius = glm::max(cluster.bounds.radius, glm::distance(cluster.bounds.center, vertices[indices[i]].position));
+        }
+
+        // The cone axis averages the face normals; its spread is set by the
+        // normal furthest from it.
+        vector<Vector3> normals;
+        Vector3 axis{ 0 };
+        for (Size t = 0; t < cluster.count; t += 3) {
+            const Point3& a = vertices[indices[t]].position;
+            Vector3 n = glm::cross(vertices[indices[t + 1]].position - a, vertices[indices[t + 2]].position - a);
+            Float length = glm::length(n);
+            if (length > 0.0f) {
+                normals.push_back(n / length);
+                axis += normals.back();
+            }
+        }
+        Float spread = 1.0f;
+        if (glm::length(axis) > 0.0f) {
+            axis = glm::normalize(axis);
+            for (const Vector3& n : normals) { spread = glm::min(spread, glm::dot(n, axis)); }
+        }
+        cluster.axis = axis;
+        // Past about 84 degrees the cone would reject too little to be worth testing.
+        cluster.cutoff = spread > 0.1f ? glm::sqrt(1.0f - spread * spread) : 1.0f;
+    }
+}
+
+namespace gl {
+    static_assert(is_standard_layout<MeshFile::Header>::value && sizeof(MeshFile::Header) == 176, "cooked mesh header layout changed");
+    static_assert(is_standard_layout<PackedVertex>::value && sizeof(PackedVertex) == 16, "cooked vertex layout changed");
+    static_assert(is_standard_layout<Mesh::SubMesh>::value && sizeof(Mesh::SubMesh) == 16, "cooked surface layout changed");
+    static_assert(is_standard_layout<Mesh::Level>::value && sizeof(Mesh::Level) == 12, "cooked level layout changed");
+    static_assert(is_standard_layout<Mesh::Cluster>::value && sizeof(Mesh::Cluster) == 44, "cooked cluster layout changed");
+    static_assert(is_standard_layout<Mesh::Part>::value && sizeof(Mesh::Part) == 48, "cooked part layout changed");
+    static_assert(is_standard_layout<MeshFile::MaterialRecord>::value && sizeof(MeshFile::MaterialRecord) == 48, "cooked material layout changed");
+
+    TypeCode NarrowestElement(size_t vertexCount)
+    {
+        if (vertexCount <= size_t{ numeric_limits<Ubyte>::max() } + 1) { return TypeCode::Ubyte; }
+        if (vertexCount <= size_t{ numeric_limits<Ushort>::max() } + 1) { return TypeCode::Ushort; }
+        return TypeCode::Uint;
+    }
+
+    vector<Ubyte> NarrowElements(const vector<Uint>& source, TypeCode type)
+    {
+        vector<Ubyte> result;
+        switch (type) {
+        case TypeCode::Ubyte: Narrow<Ubyte>(source, result); break;
+        case TypeCode::Ushort: Narrow<Ushort>(source, result); break;
+        case TypeCode::Uint: Narrow<Uint>(source, result); break;
+        default: throw invalid_argument{ "Unsupported element type" };
+        }
+        return result;
+    }
+
+    Uint ReadElement(const Ubyte* data, TypeCode type, size_t i)
+    {
+        switch (type) {
+        case TypeCode::Ubyte: return data[i];
+        case TypeCode::Ushort: { Ushort value; memcpy(&value, data + i * sizeof(value), sizeof(value)); return value; }
+        default: { Uint value; memcpy(&value, data + i * sizeof(value), sizeof(value)); return value; }
+        }
+    }
+
+    vector<Mesh::SubMesh> FaceSurfaces(const vector<Ushort>& corners, const vector<Uint>& materials)
+    {
+        // Runs of triangles in one material share one draw; larger polygons are drawn as fans.
+        vector<Mesh::SubMesh> result;
+        Size start = 0;
+        for (size_t face = 0; face < corners.size(); ++face) {
+            auto count = corners[face];
+            Mesh::Assembly mode = count == 3 ? Mesh::Triangles : Mesh::TriangleFan;
+            Uint material = materials.empty() ? 0 : materials[face];
+            if (mode == Mesh::Triangles && !result.empty() && result.back().mode == Mesh::Triangles
+                && result.back().material == material && result.back().start + result.back().count == start) {
+                result.back().count += count;
+            }
+            else {
+                result.push_back(Mesh::SubMesh{ mode, start, static_cast<Size>(count), material });
+            }
+            start += count;
+        }
+        return result;
+    }
+
+    vector<Mesh::Level> BuildLevels(const vector<Vertex>& vertices, vector<Uint>& elements, vector<Mesh::SubMesh>& surfaces)
+    {
+        // Levels stop once they no longer halve reasonably or get this small,
+        // or there are maximumLevels of them, the full mesh included.
+        constexpr size_t maximumLevels = 8;
+        constexpr size_t minimumTriangles = 32;
+        constexpr float minimumReduction = 0.9f;
+
+        // Each triangle surface is simplified on its own, so the edges
+        // between materials act as borders and stay where they are. Other
+        // surfaces are drawn unchanged at every level.
+        vector<vector<Uint>> triangles(surfaces.size());
+        size_t total = 0;
+        for (size_t s = 0; s < surfaces.size(); ++s) {
+            if (surfaces[s].mode != Mesh::Triangles) { continue; }
+            auto first = elements.begin() + surfaces[s].start;
+            triangles[s].assign(first, first + surfaces[s].count);
+            total += triangles[s].size();
+        }
+
+        const Size count = static_cast<Size>(surfaces.size());
+        vector<Mesh::Level> result{ Mesh::Level{ 0, count, 0.0f } };
+        Float error = 0.0f;
+        while (result.size() < maximumLevels && total / 3 > minimumTriangles) {
+            size_t previous = total;
+            Float worst = 0.0f;
+            total = 0;
+            for (auto& list : triangles) {
+                if (list.size() / 3 > minimumTriangles) { worst = max(worst, optimize::Simplify(list, vertices, list.size() / 2)); }
+                total += list.size();
+            }
+            if (total > previous * minimumReduction) { break; }
+            // Each level simplifies the last, so their errors add up.
+            error += worst;
+
+            result.push_back(Mesh::Level{ static_cast<Size>(surfaces.size()), count, error });
+            for (Size s = 0; s < count; ++s) {
+                Mesh::SubMesh surface = surfaces[s];
+                if (surface.mode == Mesh::Triangles) {
+                    optimize::ReorderForVertexCache(triangles[s], vertices.size());
+                    surface.start = static_cast<Size>(elements.size());
+                    surface.count = static_cast<Size>(triangles[s].size());
+                    elements.insert(elements.end(), triangles[s].begin(), triangles[s].end());
+                }
+                surfaces.push_back(surface);
+            }
+        }
+        return result;
+    }
+
+    vector<Mesh::Cluster> BuildClusters(const vector<Vertex>& vertices, const vector<Uint>& elements, const vector<Mesh::SubMesh>& surfaces,
+        size_t maxVertices, size_t maxTriangles)
+    {
+        vector<Mesh::Cluster> result;
+        vector<Size> stamp(vertices.size(), 0);
+        Size serial = 0;
+        for (size_t s = 0; s < surfaces.size(); ++s) {
+            const Mesh::SubMesh& surface = surfaces[s];
+            if (surface.mode != Mesh::Triangles) { continue; }
+
+            // Vertices stamped with the current serial are already in the cluster.
+            size_t used = 0;
+            bool open = false;
+            for (Size t = surface.start; t + 2 < surface.start + surface.count; t += 3) {
+                const Uint* tri = &elements[t];
+                auto added = [&] {
+                    size_t count = 0;
+                    for (size_t k = 0; k < 3; ++k) { count += stamp[tri[k]] != serial; }
+                    return count;
+                };
+                if (!open || used + added() > maxVertices || result.back().count == static_cast<Size>(maxTriangles * 3)) {
+                    result.push_back(Mesh::Cluster{ static_cast<Size>(s), t, 0, Mesh::Sphere{}, Vector3{}, 1.0f });
+                    ++serial;
+                    used = 0;
+                    open = true;
+                }
+                used += added();
+                for (size_t k = 0; k < 3; ++k) { stamp[tri[k]] = serial; }
+                result.back().count += 3;
+            }
+        }
+        for (auto& cluster : result) { ClusterBounds(cluster, vertices, &elements[cluster.start]); }
+        return result;
+    }
+
+    PackingError PackParts(const vector<Vertex>& vertices, const vector<Uint>& elements, const vector<Mesh::SubMesh>& surfaces,
+        const Quantization& bounds, vector<PackedVertex>& packed, vector<Mesh::Part>& parts)
+    {
+        // The vertices each surface draws. Runs that overlap, such as the
+        // levels of one part, become one part.
+        vector<pair<Uint, Uint>> spans;
+        for (const Mesh::SubMesh& surface : surfaces) {
+            if (!surface.count) { continue; }
+            auto range = minmax_element(elements.begin() + surface.start, elements.begin() + surface.start + surface.count);
+            spans.emplace_back(*range.first, *range.second);
+        }
+        sort(spans.begin(), spans.end());
+
+        PackingError error{};
+        vector<Vertex> run;
+        vector<PackedVertex> out;
+        auto pack = [&](size_t first, size_t count, const Quantization* quantization) {
+            run.assign(vertices.begin() + first, vertices.begin() + first + count);
+            Quantization own = quantization ? *quantization : Quantize(run);
+            PackingError part = PackVertices(run, own, out);
+            copy(out.begin(), out.end(), packed.begin() + first);
+            error.position = max(error.position, part.position);
+            error.normal = max(error.normal, part.normal);
+            error.uv = max(error.uv, part.uv);
+            if (!quantization) {
+                parts.push_back(Mesh::Part{ static_cast<Size>(first), static_cast<Size>(count), own.lower, own.extent, own.uvLower, own.uvExtent });
+            }
+        };
+        parts.clear();
+        packed.resize(vertices.size());
+        size_t packedTo = 0;
+        for (size_t first = 0, last; first < spans.size(); first = last) {
+            Uint lower = spans[first].first, upper = spans[first].second;
+            for (last = first + 1; last < spans.size() && spans[last].first <= upper; ++last) { upper = max(upper, spans[last].second); }
+            if (lower > packedTo) { pack(packedTo, lower - packedTo, &bounds); }
+            pack(lower, size_t{ upper } - lower + 1, nullptr);
+            packedTo = size_t{ upper } + 1;
+        }
+        if (packedTo < vertices.size()) { pack(packedTo, vertices.size() - packedTo, &bounds); }
+        return error;
+    }
+
+    bool MeshFile::Identify(const io::MappedFile& source)
+    {
+        return source.size() >= sizeof(Uint) && *reinterpret_cast<const Uint*>(source.data()) == Signature;
+    }
+
+    MeshFile::MeshFile(const io::MappedFile& source)
+    :   _base{ source.data() }, _header{ reinterpret_cast<const Header*>(source.data()) }
+    {
+        if (source.size() < sizeof(Header) || _header->signature != Signature) { throw invalid_argument{ "Not a cooked mesh" }; }
+        if (_header->version != Version) { throw invalid_argument{ "Unsupported cooked mesh version " + to_string(_header->version) }; }
+        if (_header->vertexSize != sizeof(PackedVertex)) { throw invalid_argument{ "Cooked mesh vertex layout does not match" }; }
+        if (_header->elementType != TypeCode::Ubyte && _header->elementType != TypeCode::Ushort && _header->elementType != TypeCode::Uint) {
+            throw invalid_argument{ "Cooked mesh has an invalid element type" };
+        }
+
+        auto fits = [&](uint64_t offset, uint64_t bytes) {
+            return offset % Alignment == 0 && offset <= source.size() && bytes <= source.size() - offset;
+        };
+        if (!compressed() && (_header->vertexBytes != uint64_t{ _header->vertexCount } * sizeof(PackedVertex)
+            || _header->elementBytes != uint64_t{ _header->elementCount } * TypeAlloc[_header->elementType])) {
+            throw invalid_argument{ "Cooked mesh has invalid blob sizes" };
+        }
+        if (!fits(_header->vertexOffset, _header->vertexBytes)
+            || !fits(_header->elementOffset, _header->elementBytes)
+            || !fits(_header->surfaceOffset, uint64_t{ _header->surfaceCount } * sizeof(Mesh::SubMesh))
+            || !fits(_header->levelOffset, uint64_t{ _header->levelCount } * sizeof(Mesh::Level))
+            || !fits(_header->clusterOffset, uint64_t{ _header->clusterCount } * sizeof(Mesh::Cluster))
+            || !fits(_header->materialOffset, uint64_t{ _header->materialCount } * sizeof(MaterialRecord))
+            || !fits(_header->partOffset, uint64_t{ _header->partCount } * sizeof(Mesh::Part))
+            || !fits(_header->stringOffset, _header->stringSize)) {
+            throw invalid_argument{ "Cooked mesh is truncated" };
+        }
+
+        auto records = reinterpret_cast<const MaterialRecord*>(_base + _header->materialOffset);
+        for (Uint m = 0; m < _header->materialCount; ++m) {
+            if (uint64_t{ records[m].name } + records[m].nameLength > _header->stringSize
+                || uint64_t{ records[m].diffuseMap } + records[m].diffuseMapLength > _header->stringSize) {
+                throw invalid_argument{ "Cooked mesh has an invalid material name" };
+            }
+        }
+
+        // Draws index straight through these tables, so every range must
+        // lie inside what it refers to.
+        const Mesh::SubMesh* surfaces = this->surfaces();
+        for (Uint s = 0; s < _header->surfaceCount; ++s) {
+            if (surfaces[s].start < 0 || surfaces[s].count < 0 || int64_t{ surfaces[s].start } + surfaces[s].count > _header->elementCount) { throw invalid_argument{ "Cooked mesh has a surface outside its elements" }; }
+            if (_header->materialCount && surfaces[s].material >= _header->materialCount) { throw invalid_argument{ "Cooked mesh has a surface with an invalid material" }; }
+        }
+        const Mesh::Level* levels = this->levels();
+        for (Uint l = 0; l < _header->levelCount; ++l) {
+            if (levels[l].first < 0 || levels[l].count < 0 || int64_t{ levels[l].first } + levels[l].count > _header->surfaceCount) { throw invalid_argument{ "Cooked mesh has a level outside its surfaces" }; }
+        }
+        const Mesh::Cluster* clusters = this->clusters();
+        for (Uint c = 0; c < _header->clusterCount; ++c) {
+            const Mesh::Cluster& cluster = clusters[c];
+            if (cluster.surface < 0 || cluster.surface >= static_cast<int64_t>(_header->surfaceCount)) { throw invalid_argument{ "Cooked mesh has a cluster with an invalid surface" }; }
+            const Mesh::SubMesh& surface = surfaces[cluster.surface];
+            if (cluster.start < surface.start || cluster.count < 0 || int64_t{ cluster.start } + cluster.count > int64_t{ surface.start } + surface.count) {
+                throw invalid_argument{ "Cooked mesh has a cluster outside its surface" };
+            }
+        }
+        // Surfaces find their part by its first vertex, so parts must be
+        // in order and apart.
+        const Mesh::Part* parts = this->parts();
+        for (Uint p = 0; p < _header->partCount; ++p) {
+            int64_t after = p ? int64_t{ parts[p - 1].first } + parts[p - 1].count : 0;
+            if (parts[p].first < after || parts[p].count < 0 || int64_t{ parts[p].first } + parts[p].count > _header->vertexCount) {
+                throw invalid_argument{ "Cooked mesh has a part outside its vertices" };
+            }
+        }
+        // Compressed elements are checked as Decode unpacks them.
+        if (!compressed()) { CheckElements(static_cast<const Ubyte*>(elements()), _header->elementType, _header->elementCount, _header->vertexCount); }
+    }
+
+    vector<Material> MeshFile::materials() const
+    {
+        auto records = reinterpret_cast<const MaterialRecord*>(_base + _header->materialOffset);
+        const char* strings = _base + _header->stringOffset;
+        vector<Material> result;
+        result.reserve(_header->materialCount);
+        for (Uint m = 0; m < _header->materialCount; ++m) {
+            const MaterialRecord& record = records[m];
+            result.push_back(Material{ string(strings + record.name, record.nameLength), record.diffuse, record.specular, record.shininess,
+                string(strings + record.diffuseMap, record.diffuseMapLength) });
+        }
+        return result;
+    }
+
+    void MeshFile::Decode(vector<PackedVertex>& vertices, vector<Ubyte>& elements) const
+    {
+        vertices.resize(_header->vertexCount);
+        elements.resize(size_t{ _header->elementCount } * TypeAlloc[_header->elementType]);
+        if (!compressed()) {
+            copy_n(this->vertices(), vertices.size(), vertices.data());
+            copy_n(static_cast<const Ubyte*>(this->elements()), elements.size(), elements.data());
+            return;
+        }
+        DecodeVertices(reinterpret_cast<const Ubyte*>(_base + _header->vertexOffset), _header->vertexBytes, vertices.data(), vertices.size(), sizeof(PackedVertex));
+        DecodeIndices(reinterpret_cast<const Ubyte*>(_base + _header->elementOffset), _header->elementBytes, elements.data(), _header->elementCount, _header->elementType);
+        CheckElements(elements.data(), _header->elementType, _header->elementCount, _header->vertexCount);
+    }
+
+    PackingError MeshFile::Cook(const OBJmesh& source, const string& destination, bool compress)
+    {
+        const auto& vertices = source.vData();
+        Header header{};
+        header.signature = Signature;
+        header.version = Version;
+        header.vertexSize = sizeof(PackedVertex);
+        header.vertexCount = static_cast<Uint>(vertices.size());
+        header.elementType = NarrowestElement(vertices.size());
+
+        // Clusters cover the full mesh only, so they are built before the
+        // levels add their surfaces.
+        vector<Uint> indices = source.fData();
+        vector<Mesh::SubMesh> surfaces = FaceSurfaces(source.faceSegments(), source.faceMaterials());
+        vector<Mesh::Cluster> clusters = BuildClusters(vertices, indices, surfaces);
+        vector<Mesh::Level> levels = BuildLevels(vertices, indices, surfaces);
+        header.elementCount = static_cast<Uint>(indices.size());
+        header.surfaceCount = static_cast<Uint>(surfaces.size());
+        header.levelCount = static_cast<Uint>(levels.size());
+        header.clusterCount = static_cast<Uint>(clusters.size());
+        vector<Ubyte> elements = compress ? EncodeIndices(indices) : NarrowElements(indices, header.elementType);
+
+        vector<MaterialRecord> records;
+        string strings;
+        for (const Material& material : source.materials()) {
+            MaterialRecord record{ material.diffuse, material.specular, material.shininess,
+                static_cast<Uint>(strings.size()), static_cast<Uint>(material.name.size()), 0, 0 };
+            strings += material.name;
+            record.diffuseMap = static_cast<Uint>(strings.size());
+            record.diffuseMapLength = static_cast<Uint>(material.diffuseMap.size());
+            strings += material.diffuseMap;
+            records.push_back(record);
+        }
+        header.materialCount = static_cast<Uint>(records.size());
+        header.stringSize = strings.size();
+
+        Quantization bounds = Quantize(vertices);
+        vector<PackedVertex> packed;
+        vector<Mesh::Part> parts;
+        PackingError error = PackParts(vertices, indices, surfaces, bounds, packed, parts);
+        header.partCount = static_cast<Uint>(parts.size());
+        header.lower = bounds.lower;
+        header.upper = bounds.lower + bounds.extent;
+        header.uvLower = bounds.uvLower;
+        header.uvUpper = bounds.uvLower + bounds.uvExtent;
+
+        vector<Ubyte> vertexBlob = compress ? EncodeVertices(packed.data(), packed.size(), sizeof(PackedVertex))
+            : vector<Ubyte>(reinterpret_cast<const Ubyte*>(packed.data()), reinterpret_cast<const Ubyte*>(packed.data() + packed.size()));
+        header.vertexBytes = vertexBlob.size();
+        header.elementBytes = elements.size();
+        header.flags = compress ? Compressed : 0;
+
+        header.vertexOffset = Align(sizeof(Header));
+        header.elementOffset = Align(header.vertexOffset + vertexBlob.size());
+        header.surfaceOffset = Align(header.elementOffset + elements.size());
+        header.levelOffset = Align(header.surfaceOffset + surfaces.size() * sizeof(Mesh::SubMesh));
+        header.clusterOffset = Align(header.levelOffset + levels.size() * sizeof(Mesh::Level));
+        header.materialOffset = Align(header.clusterOffset + clusters.size() * sizeof(Mesh::Cluster));
+        header.partOffset = Align(header.materialOffset + records.size() * sizeof(MaterialRecord));
+        header.stringOffset = Align(header.partOffset + parts.size() * sizeof(Mesh::Part));
+
+        ofstream out{ destination, ios::binary | ios::trunc };
+        if (!out) { throw runtime_error{ "Failed to create file: " + destination }; }
+
+        auto pad = [&out](uint64_t offset) {
+            static const char zeros[Alignment] = {};
+            out.write(zeros, static_cast<streamsize>(offset - static_cast<uint64_t>(out.tellp())));
+        };
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        pad(header.vertexOffset);
+        out.write(reinterpret_cast<const char*>(vertexBlob.data()), vertexBlob.size());
+        pad(header.elementOffset);
+        out.write(reinterpret_cast<const char*>(elements.data()), elements.size());
+        pad(header.surfaceOffset);
+        out.write(reinterpret_cast<const char*>(surfaces.data()), surfaces.size() * sizeof(Mesh::SubMesh));
+        pad(header.levelOffset);
+        out.write(reinterpret_cast<const char*>(levels.data()), levels.size() * sizeof(Mesh::Level));
+        pad(header.clusterOffset);
+        out.write(reinterpret_cast<const char*>(clusters.data()), clusters.size() * sizeof(Mesh::Cluster));
+        pad(header.materialOffset);
+        out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(MaterialRecord));
+        pad(header.partOffset);
+        out.write(reinterpret_cast<const char*>(parts.data()), parts.size() * sizeof(Mesh::Part));
+        pad(header.stringOffset);
+        out.write(strings.data(), strings.size());
+        if (!out) { throw runtime_error{ "Failed to write file: " + destination }; }
+        return error;
+    }
+
+    PackingError MeshFile::Cook(const string& source, const string& destination, bool optimize, bool compress)
+    {
+        OBJmesh mesh{ source };
+        if (optimize) { mesh.Optimize(); }
+        return Cook(mesh, destination, compress);
+    }
+}
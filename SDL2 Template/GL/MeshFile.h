@@ -0,0 +1,140 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_MESHFILE
+#define OPENGL_WRAPPER_MESHFILE
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "OpenGL.h"
+#include "Vertex.h"
+#include "Mesh.h"
+#include "PackedVertex.h"
+#include "Material.h"
+#include "../IO/MappedFile.h"
+
+class OBJmesh;
+
+namespace gl {
+    // Cooked binary mesh. A Header is followed by the packed vertex blob, the index
+    // blob, the SubMesh, Level, Cluster, material and Part tables and the material
+    // name strings, each starting on a 16-byte boundary so the
+    // regions of a mapped file can be handed to the GL without copying.
+    // Compressed files store the vertex and index blobs coded with
+    // EncodeVertices and EncodeIndices instead, and must be decoded.
+    // Values are stored in the byte order of the machine that cooked them.
+    class MeshFile {
+    public:
+        static constexpr Uint Signature = 0x48534D47; // "GMSH"
+        static constexpr Uint Version = 8;
+        static constexpr Uint Compressed = 1;
+        static constexpr std::size_t Alignment = 16;
+
+        struct Header {
+            Uint signature;
+            Uint version;
+            Uint vertexSize;
+            Uint vertexCount;
+            TypeCode elementType;
+            Uint elementCount;
+            Uint surfaceCount;
+            Uint levelCount;
+            Vector3 lower;
+            Vector3 upper;
+            Vector2 uvLower;
+            Vector2 uvUpper;
+            Uint clusterCount;
+            Uint materialCount;
+            std::uint64_t vertexOffset;
+            std::uint64_t elementOffset;
+            std::uint64_t surfaceOffset;
+            std::uint64_t levelOffset;
+            std::uint64_t clusterOffset;
+            std::uint64_t materialOffset;
+            std::uint64_t stringOffset;
+            std::uint64_t stringSize;
+            // Stored sizes of the vertex and index blobs.
+            std::uint64_t vertexBytes;
+            std::uint64_t elementBytes;
+            Uint flags;
+            Uint partCount;
+            std::uint64_t partOffset;
+        };
+        // A Material with its strings given as ranges of the string blob.
+        struct MaterialRecord {
+            ColorAlpha diffuse;
+            Color specular;
+            Float shininess;
+            Uint name;
+            Uint nameLength;
+            Uint diffuseMap;
+            Uint diffuseMapLength;
+        };
+
+        // Views a mapped cooked mesh; throws if the contents are not one, or
+        // if its tables or uncompressed indices point outside what they index.
+        explicit MeshFile(const io::MappedFile& source);
+
+        static bool Identify(const io::MappedFile& source);
+
+        // Both return the error introduced by packing the vertices.
+        static PackingError Cook(const OBJmesh& source, const std::string& destination, bool compress = true);
+        // Parses an OBJ file and cooks it, running the mesh optimizer first
+        // unless asked not to.
+        static PackingError Cook(const std::string& source, const std::string& destination, bool optimize = true, bool compress = true);
+
+        const Header& header() const { return *_header; }
+        bool compressed() const { return (_header->flags & Compressed) != 0; }
+        // The stored blobs; only usable as they are if the file is not compressed.
+        const PackedVertex* vertices() const { return reinterpret_cast<const PackedVertex*>(_base + _header->vertexOffset); }
+        Quantization quantization() const { return Quantization{ _header->lower, _header->upper - _header->lower, _header->uvLower, _header->uvUpper - _header->uvLower }; }
+        const void* elements() const { return _base + _header->elementOffset; }
+        const Mesh::SubMesh* surfaces() const { return reinterpret_cast<const Mesh::SubMesh*>(_base + _header->surfaceOffset); }
+        const Mesh::Level* levels() const { return reinterpret_cast<const Mesh::Level*>(_base + _header->levelOffset); }
+        const Mesh::Cluster* clusters() const { return reinterpret_cast<const Mesh::Cluster*>(_base + _header->clusterOffset); }
+        const Mesh::Part* parts() const { return reinterpret_cast<const Mesh::Part*>(_base + _header->partOffset); }
+        std::vector<Material> materials() const;
+        // Decodes the vertex and index blobs of a compressed file. Throws if
+        // they are damaged or an index is past the vertices.
+        void Decode(std::vector<PackedVertex>& vertices, std::vector<Ubyte>& elements) const;
+    private:
+        const char* _base;
+        const Header* _header;
+    };
+
+    // Smallest index type able to address vertexCount vertices.
+    TypeCode NarrowestElement(std::size_t vertexCount);
+
+    // Index bytes of source stored as type.
+    std::vector<Ubyte> NarrowElements(const std::vector<Uint>& source, TypeCode type);
+
+    // The ith index of data stored as type.
+    Uint ReadElement(const Ubyte* data, TypeCode type, std::size_t i);
+
+    // Draw ranges for faces of the given corner counts, stored back to back.
+    // A new range starts wherever the face material changes; materials may be
+    // empty, putting every face in material 0.
+    std::vector<Mesh::SubMesh> FaceSurfaces(const std::vector<Ushort>& corners, const std::vector<Uint>& materials);
+
+    // Simplifies the triangle surfaces into successively halved levels,
+    // appending their indices to elements and their surfaces to surfaces.
+    // Level 0 covers the surfaces passed in.
+    std::vector<Mesh::Level> BuildLevels(const std::vector<Vertex>& vertices, std::vector<Uint>& elements, std::vector<Mesh::SubMesh>& surfaces);
+
+    // Splits each triangle surface into runs of triangles that stay within
+    // the vertex and triangle limits. Triangles keep their order, so a
+    // cache-optimized list yields compact clusters without moving indices.
+    std::vector<Mesh::Cluster> BuildClusters(const std::vector<Vertex>& vertices, const std::vector<Uint>& elements, const std::vector<Mesh::SubMesh>& surfaces,
+        std::size_t maxVertices = 64, std::size_t maxTriangles = 124);
+
+    // Packs vertices in parts, each the run of vertices some surfaces draw
+    // from, widened until no surface draws from two, and quantized against
+    // its own bounds. Vertices no surface draws are packed against bounds.
+    // Returns the largest error over all of them.
+    PackingError PackParts(const std::vector<Vertex>& vertices, const std::vector<Uint>& elements, const std::vector<Mesh::SubMesh>& surfaces,
+        const Quantization& bounds, std::vector<PackedVertex>& packed, std::vector<Mesh::Part>& parts);
+}
+
+#endif
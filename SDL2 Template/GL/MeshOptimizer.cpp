@@ -0,0 +1,440 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+using namespace std;
+
+namespace {
+    // Scoring constants from Forsyth's paper.
+    constexpr unsigned cacheSize = 32;
+    constexpr unsigned maximumValence = 32;
+    constexpr float lastTriangleScore = 0.75f;
+    constexpr float cacheDecayPower = 1.5f;
+    constexpr float valenceBoostScale = 2.0f;
+    constexpr float valenceBoostPower = 0.5f;
+
+    struct ScoreTable {
+        float cache[cacheSize];
+        float valence[maximumValence + 1];
+
+        ScoreTable()
+        {
+            for (unsigned i = 0; i < cacheSize; ++i) {
+                cache[i] = i < 3 ? lastTriangleScore : pow(1.0f - float(i - 3) / (cacheSize - 3), cacheDecayPower);
+            }
+            valence[0] = 0.0f;
+            for (unsigned i = 1; i <= maximumValence; ++i) {
+                valence[i] = valenceBoostScale * pow(float(i), -valenceBoostPower);
+            }
+        }
+
+        float operator() (int position, unsigned remaining) const
+        {
+            if (!remaining) { return -1.0f; }
+            return (position >= 0 ? cache[position] : 0.0f) + valence[min(remaining, maximumValence)];
+        }
+    };
+
+    // Area-weighted sum of squared distances to a set of planes.
+    struct Quadric {
+        double a00, a01, a02, a11, a12, a22;
+        double b0, b1, b2;
+        double c;
+        double weight;
+
+        static Quadric Plane(const gl::Vector3& n, double d, double weight)
+        {
+            return Quadric{
+                weight * n.x * n.x, weight * n.x * n.y, weight * n.x * n.z,
+                weight * n.y * n.y, weight * n.y * n.z, weight * n.z * n.z,
+                weight * n.x * d, weight * n.y * d, weight * n.z * d,
+                weight * d * d,
+                weight
+            };
+        }
+
+        Quadric& operator+= (const Quadric& q)
+        {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02;
+            a11 += q.a11; a12 += q.a12; a22 += q.a22;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2;
+            c += q.c;
+            weight += q.weight;
+            return *this;
+        }
+
+        double Evaluate(const gl::Point3& p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double result = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z
+                + a11 * y * y + 2 * a12 * y * z + a22 * z * z
+                + 2 * (b0 * x + b1 * y + b2 * z) + c;
+            return max(result, 0.0);
+        }
+    };
+
+    struct Collapse {
+        gl::Uint from;
+        gl::Uint to;
+        float cost;
+    };
+}
+
+namespace gl {
+    namespace optimize {
+        CacheStatistics AnalyzeVertexCache(const vector<Uint>& indices, size_t vertexCount, unsigned size)
+        {
+            vector<size_t> stamp(vertexCount, 0);
+            vector<bool> referenced(vertexCount, false);
+            size_t time = size + 1, misses = 0, unique = 0;
+            for (Uint index : indices) {
+                // A vertex is resident if it entered the FIFO within the last size misses.
+                if (time - stamp[index] > size) {
+                    stamp[index] = time++;
+                    ++misses;
+                }
+                if (!referenced[index]) {
+                    referenced[index] = true;
+                    ++unique;
+                }
+            }
+            size_t triangles = indices.size() / 3;
+            return CacheStatistics{
+                triangles ? float(misses) / triangles : 0.0f,
+                unique ? float(misses) / unique : 0.0f
+            };
+        }
+
+        void ReorderForVertexCache(vector<Uint>& indices, size_t vertexCount)
+        {
+            static const ScoreTable score;
+            size_t triangleCount = indices.size() / 3;
+            if (triangleCount < 2) { return; }
+
+            // Triangles using each vertex, stored as one flat adjacency list.
+            vector<Uint> remaining(vertexCount, 0);
+            for (Uint index : indices) { ++remaining[index]; }
+            vector<Uint> first(vertexCount + 1, 0);
+            partial_sum(remaining.begin(), remaining.end(), first.begin() + 1);
+            vector<Uint> adjacency(indices.size());
+            {
+                vector<Uint> fill(first.begin(), first.end() - 1);
+                for (size_t t = 0; t < triangleCount; ++t) {
+                    for (size_t k = 0; k < 3; ++k) { adjacency[fill[indices[t * 3 + k]]++] = static_cast<Uint>(t); }
+                }
+            }
+
+            vector<int> position(vertexCount, -1);
+            vector<float> vertexScore(vertexCount);
+            for (size_t v = 0; v < vertexCount; ++v) { vertexScore[v] = score(-1, remaining[v]); }
+
+            vector<float> triangleScore(triangleCount);
+            vector<bool> emitted(triangleCount, false);
+            size_t best = 0;
+            for (size_t t = 0; t < triangleCount; ++t) {
+                const Uint* tri = &indices[t * 3];
+                triangleScore[t] = vertexScore[tri[0]] + vertexScore[tri[1]] + vertexScore[tri[2]];
+                if (triangleScore[t] > triangleScore[best]) { best = t; }
+            }
+
+            vector<Uint> result;
+            result.reserve(indices.size());
+            vector<Uint> cache, next;
+            cache.reserve(cacheSize + 3);
+            next.reserve(cacheSize + 3);
+            size_t cursor = 0;
+
+            for (size_t count = 0; count < triangleCount; ++count) {
+                const Uint* tri = &indices[best * 3];
+                emitted[best] = true;
+                triangleScore[best] = -1.0f;
+
+                next.assign(tri, tri + 3);
+                for (size_t k = 0; k < 3; ++k) {
+                    Uint v = tri[k];
+                    result.push_back(v);
+                    // Drop the emitted triangle from the vertex's adjacency.
+                    Uint* list = &adjacency[first[v]];
+                    Uint* end = list + remaining[v];
+                    *find(list, end, static_cast<Uint>(best)) = end[-1];
+                    --remaining[v];
+                }
+                for (Uint v : cache) {
+                    if (v != tri[0] && v != tri[1] && v != tri[2]) { next.push_back(v); }
+                }
+                for (size_t i = cacheSize; i < next.size(); ++i) { position[next[i]] = -1; }
+                if (next.size() > cacheSize) { next.resize(cacheSize); }
+                cache.swap(next);
+
+                // Rescore the vertices in cache and the triangles that use them.
+                for (size_t i = 0; i < cache.size(); ++i) {
+                    position[cache[i]] = static_cast<int>(i);
+                    vertexScore[cache[i]] = score(static_cast<int>(i), remaining[cache[i]]);
+                }
+                for (Uint v : next) {
+                    if (position[v] < 0) { vertexScore[v] = score(-1, remaining[v]); }
+                }
+
+                float bestScore = -1.0f;
+                for (Uint v : cache) {
+                    for (Uint i = first[v], e = first[v] + remaining[v]; i < e; ++i) {
+                        Uint t = adjacency[i];
+                        const Uint* other = &indices[t * 3];
+                        triangleScore[t] = vertexScore[other[0]] + vertexScore[other[1]] + vertexScore[other[2]];
+                        if (triangleScore[t] > bestScore) {
+                            bestScore = triangleScore[t];
+                            best = t;
+                        }
+                    }
+                }
+
+                // Nothing adjacent to the cache is left; restart elsewhere.
+                if (bestScore < 0.0f) {
+                    while (cursor < triangleCount && emitted[cursor]) { ++cursor; }
+                    best = cursor;
+                }
+            }
+
+            indices.swap(result);
+        }
+
+        void ReorderForOverdraw(vector<Uint>& indices, const vector<Vertex>& vertices, float threshold)
+        {
+            size_t triangleCount = indices.size() / 3;
+            if (triangleCount < 2) { return; }
+
+            // Hard cluster boundaries fall where all three vertices miss the cache.
+            vector<size_t> clusters{ 0 };
+            {
+                const unsigned size = 16;
+                vector<size_t> stamp(vertices.size(), 0);
+                size_t time = size + 1;
+                for (size_t t = 0; t < triangleCount; ++t) {
+                    unsigned misses = 0;
+                    for (size_t k = 0; k < 3; ++k) {
+                        Uint v = indices[t * 3 + k];
+                        if (time - stamp[v] > size) {
+                            stamp[v] = time++;
+                            ++misses;
+                        }
+                    }
+                    if (misses == 3 && t != clusters.back()) { clusters.push_back(t); }
+                }
+            }
+            clusters.push_back(triangleCount);
+            size_t clusterCount = clusters.size() - 1;
+            if (clusterCount < 2) { return; }
+
+            Vector3 center{ 0.0f };
+            float area = 0.0f;
+            vector<float> sortKey(clusterCount);
+            vector<Vector3> clusterCenter(clusterCount), clusterNormal(clusterCount);
+            for (size_t c = 0; c < clusterCount; ++c) {
+                Vector3 weighted{ 0.0f }, normal{ 0.0f };
+                float clusterArea = 0.0f;
+                for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+                    const Point3& a = vertices[indices[t * 3]].position;
+                    const Point3& b = vertices[indices[t * 3 + 1]].position;
+                    const Point3& d = vertices[indices[t * 3 + 2]].position;
+                    Vector3 n = glm::cross(b - a, d - a);
+                    float triangleArea = glm::length(n);
+                    weighted += (a + b + d) * (triangleArea / 3.0f);
+                    normal += n;
+                    clusterArea += triangleArea;
+                }
+                clusterCenter[c] = clusterArea > 0.0f ? weighted / clusterArea : vertices[indices[clusters[c] * 3]].position;
+                float length = glm::length(normal);
+                clusterNormal[c] = length > 0.0f ? normal / length : Vector3{ 0.0f };
+                center += weighted;
+                area += clusterArea;
+            }
+            if (area > 0.0f) { center /= area; }
+
+            // Clusters facing away from the mesh centre are likely to occlude the rest.
+            for (size_t c = 0; c < clusterCount; ++c) { sortKey[c] = glm::dot(clusterCenter[c] - center, clusterNormal[c]); }
+            vector<size_t> order(clusterCount);
+            iota(order.begin(), order.end(), size_t{ 0 });
+            stable_sort(order.begin(), order.end(), [&sortKey](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+            vector<Uint> result;
+            result.reserve(indices.size());
+            for (size_t c : order) {
+                result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+            }
+
+            float before = AnalyzeVertexCache(indices, vertices.size()).acmr;
+            float after = AnalyzeVertexCache(result, vertices.size()).acmr;
+            if (after <= before * threshold) { indices.swap(result); }
+        }
+
+        void ReorderForVertexFetch(vector<Vertex>& vertices, vector<Uint>& indices)
+        {
+            const Uint unused = ~Uint{ 0 };
+            vector<Uint> remap(vertices.size(), unused);
+            vector<Vertex> result;
+            result.reserve(vertices.size());
+            for (Uint& index : indices) {
+                if (remap[index] == unused) {
+                    remap[index] = static_cast<Uint>(result.size());
+                    result.push_back(vertices[index]);
+                }
+                index = remap[index];
+            }
+            vertices.swap(result);
+        }
+
+        Float Simplify(vector<Uint>& indices, const vector<Vertex>& vertices, size_t targetIndexCount)
+        {
+            size_t vertexCount = vertices.size();
+
+            // Vertices sharing a position are split only by uv or normal;
+            // topology and error are tracked per position.
+            vector<Uint> position(vertexCount);
+            vector<bool> locked(vertexCount, false);
+            {
+                vector<Uint> order(vertexCount);
+                iota(order.begin(), order.end(), Uint{ 0 });
+                auto less = [&vertices](Uint a, Uint b) {
+                    const Point3& p = vertices[a].position;
+                    const Point3& q = vertices[b].position;
+                    return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
+                };
+                sort(order.begin(), order.end(), less);
+                for (size_t i = 0; i < vertexCount; ) {
+                    size_t j = i + 1;
+                    while (j < vertexCount && vertices[order[j]].position == vertices[order[i]].position) { ++j; }
+                    for (size_t k = i; k < j; ++k) {
+                        position[order[k]] = order[i];
+                        locked[order[k]] = j - i > 1;
+                    }
+                    i = j;
+                }
+            }
+
+            // Edges used by a single triangle lie on a border.
+            {
+                vector<uint64_t> edges;
+                edges.reserve(indices.size());
+                for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+                    for (size_t k = 0; k < 3; ++k) {
+                        uint64_t a = position[indices[t + k]], b = position[indices[t + (k + 1) % 3]];
+                        edges.push_back(a < b ? a << 32 | b : b << 32 | a);
+                    }
+                }
+                sort(edges.begin(), edges.end());
+                vector<bool> border(vertexCount, false);
+                for (size_t i = 0; i < edges.size(); ) {
+                    size_t j = i + 1;
+                    while (j < edges.size() && edges[j] == edges[i]) { ++j; }
+                    if (j - i == 1) { border[edges[i] >> 32] = border[edges[i] & 0xFFFFFFFF] = true; }
+                    i = j;
+                }
+                for (size_t v = 0; v < vertexCount; ++v) {
+                    if (border[position[v]]) { locked[v] = true; }
+                }
+            }
+
+            vector<Quadric> quadric(vertexCount, Quadric{});
+            for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+                const Point3& a = vertices[indices[t]].position;
+                Vector3 n = glm::cross(vertices[indices[t + 1]].position - a, vertices[indices[t + 2]].position - a);
+                float area = glm::length(n);
+                if (area <= 0.0f) { continue; }
+                n /= area;
+                Quadric plane = Quadric::Plane(n, -glm::dot(n, a), area * 0.5);
+                for (size_t k = 0; k < 3; ++k) { quadric[position[indices[t + k]]] += plane; }
+            }
+
+            double worst = 0.0;
+            vector<Collapse> candidates;
+            vector<Uint> first(vertexCount + 1), adjacency, remap(vertexCount);
+            vector<bool> touched(vertexCount);
+            while (indices.size() > targetIndexCount) {
+                size_t triangleCount = indices.size() / 3;
+
+                // Triangles around each position, for the flip test.
+                fill(first.begin(), first.end(), 0);
+                for (Uint index : indices) { ++first[position[index] + 1]; }
+                partial_sum(first.begin(), first.end(), first.begin());
+                adjacency.resize(indices.size());
+                {
+                    vector<Uint> fillAt(first.begin(), first.end() - 1);
+                    for (size_t i = 0; i < indices.size(); ++i) { adjacency[fillAt[position[indices[i]]]++] = static_cast<Uint>(i / 3); }
+                }
+
+                candidates.clear();
+                for (size_t t = 0; t < triangleCount; ++t) {
+                    for (size_t k = 0; k < 3; ++k) {
+                        Uint from = indices[t * 3 + k], to = indices[t * 3 + (k + 1) % 3];
+                        for (int direction = 0; direction < 2; ++direction, swap(from, to)) {
+                            if (locked[from]) { continue; }
+                            Quadric q = quadric[position[from]];
+                            q += quadric[position[to]];
+                            float cost = q.weight > 0.0 ? static_cast<float>(q.Evaluate(vertices[to].position) / q.weight) : 0.0f;
+                            candidates.push_back(Collapse{ from, to, cost });
+                        }
+                    }
+                }
+                sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+                // Each collapse removes about two triangles; stop once enough are gone.
+                size_t goal = (indices.size() - targetIndexCount) / 3;
+                size_t removed = 0;
+                iota(remap.begin(), remap.end(), Uint{ 0 });
+                fill(touched.begin(), touched.end(), false);
+                for (const Collapse& collapse : candidates) {
+                    if (removed >= goal) { break; }
+                    Uint u = position[collapse.from], v = position[collapse.to];
+                    if (touched[u] || touched[v]) { continue; }
+
+                    // Reject collapses that would fold a surrounding triangle over.
+                    bool flips = false;
+                    const Point3& target = vertices[collapse.to].position;
+                    for (Uint i = first[u]; i < first[u + 1] && !flips; ++i) {
+                        const Uint* tri = &indices[adjacency[i] * 3];
+                        Point3 corner[3];
+                        bool shared = false;
+                        for (size_t k = 0; k < 3; ++k) {
+                            corner[k] = vertices[tri[k]].position;
+                            shared |= position[tri[k]] == v;
+                        }
+                        if (shared) { continue; }
+                        Vector3 before = glm::cross(corner[1] - corner[0], corner[2] - corner[0]);
+                        for (size_t k = 0; k < 3; ++k) {
+                            if (position[tri[k]] == u) { corner[k] = target; }
+                        }
+                        Vector3 after = glm::cross(corner[1] - corner[0], corner[2] - corner[0]);
+                        flips = glm::dot(before, after) <= 0.0f;
+                    }
+                    if (flips) { continue; }
+
+                    // Every corner of every triangle the flip test passed is
+                    // pinned, so no later collapse this pass moves one.
+                    touched[u] = touched[v] = true;
+                    for (Uint i = first[u]; i < first[u + 1]; ++i) {
+                        for (size_t k = 0; k < 3; ++k) { touched[position[indices[adjacency[i] * 3 + k]]] = true; }
+                    }
+                    remap[collapse.from] = collapse.to;
+                    quadric[v] += quadric[u];
+                    worst = max(worst, static_cast<double>(collapse.cost));
+                    removed += 2;
+                }
+                if (!removed) { break; }
+
+                size_t kept = 0;
+                for (size_t t = 0; t < triangleCount; ++t) {
+                    Uint a = remap[indices[t * 3]], b = remap[indices[t * 3 + 1]], c = remap[indices[t * 3 + 2]];
+                    if (position[a] == position[b] || position[b] == position[c] || position[a] == position[c]) { continue; }
+                    indices[kept++] = a;
+                    indices[kept++] = b;
+                    indices[kept++] = c;
+                }
+                indices.resize(kept);
+            }
+
+            return static_cast<Float>(sqrt(worst));
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_MESHOPTIMIZER
+#define OPENGL_WRAPPER_MESHOPTIMIZER
+
+#include <cstddef>
+#include <vector>
+
+#include "OpenGL.h"
+#include "Vertex.h"
+
+namespace gl {
+    namespace optimize {
+        // Post-transform cache behaviour of a triangle list under a FIFO cache.
+        // acmr is cache misses per triangle, atvr is misses per referenced
+        // vertex; 0.5 and 1.0 are the respective ideals.
+        struct CacheStatistics {
+            float acmr;
+            float atvr;
+        };
+
+        struct Report {
+            CacheStatistics before;
+            CacheStatistics after;
+        };
+
+        CacheStatistics AnalyzeVertexCache(const std::vector<Uint>& indices, std::size_t vertexCount, unsigned cacheSize = 16);
+
+        // Reorders triangles to maximise post-transform cache hits using
+        // Forsyth's "linear-speed vertex cache optimisation".
+        void ReorderForVertexCache(std::vector<Uint>& indices, std::size_t vertexCount);
+
+        // Splits a cache-ordered list into clusters where the cache restarts
+        // and sorts the clusters so outward facing ones draw first. The old
+        // order is kept if the cache would degrade by more than threshold.
+        void ReorderForOverdraw(std::vector<Uint>& indices, const std::vector<Vertex>& vertices, float threshold = 1.05f);
+
+        // Renumbers vertices in order of first use and drops unreferenced ones.
+        void ReorderForVertexFetch(std::vector<Vertex>& vertices, std::vector<Uint>& indices);
+
+        // Collapses edges of a triangle list in order of quadric error until
+        // at most targetIndexCount indices remain or no legal collapse is
+        // left. Vertices only ever merge onto existing ones, so the result
+        // indexes the same vertex buffer; borders and uv/normal seams are
+        // kept in place. Returns the largest RMS distance introduced, in
+        // model units.
+        Float Simplify(std::vector<Uint>& indices, const std::vector<Vertex>& vertices, std::size_t targetIndexCount);
+    }
+}
+
+#endif
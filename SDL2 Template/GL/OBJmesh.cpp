@@ -0,0 +1,458 @@
+#include "OBJmesh.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#include "TangentSpace.h"
+using namespace std;
+
+namespace {
+	// Tokenizing helpers for text parsed in place out of a mapped file.
+	// Every helper takes the current position and the end of the line and
+	// returns the position just past whatever it consumed.
+	inline bool IsBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline const char* SkipBlanks(const char* at, const char* end)
+	{
+		while (at < end && IsBlank(*at)) { ++at; }
+		return at;
+	}
+
+	inline const char* SkipToken(const char* at, const char* end)
+	{
+		while (at < end && !IsBlank(*at)) { ++at; }
+		return at;
+	}
+
+	template <typename T>
+	const char* ParseNumber(const char* at, const char* end, T& value)
+	{
+		if (at < end && *at == '+') { ++at; }
+		auto result = from_chars(at, end, value);
+		if (result.ec != errc{}) { throw invalid_argument{ "Malformed number in OBJ data" }; }
+		return result.ptr;
+	}
+
+	template <typename V>
+	void ParseVector(const char* at, const char* end, V& value)
+	{
+		for (typename V::length_type i = 0; i < value.length(); ++i) {
+			at = ParseNumber(SkipBlanks(at, end), end, value[i]);
+		}
+	}
+
+	inline bool IsCommand(const char* begin, const char* end, const char* command, size_t length)
+	{
+		return static_cast<size_t>(end - begin) == length && memcmp(begin, command, length) == 0;
+	}
+
+	// The rest of the line with surrounding blanks removed, for names that
+	// may contain spaces.
+	inline string Remainder(const char* at, const char* end)
+	{
+		at = SkipBlanks(at, end);
+		while (end > at && IsBlank(end[-1])) { --end; }
+		return string(at, end);
+	}
+
+	// Twice the signed area of abc; positive when counter-clockwise.
+	inline float Turn(const gl::Vector2& a, const gl::Vector2& b, const gl::Vector2& c)
+	{
+		return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	}
+
+	// Appends triangles covering one polygon, keeping its winding. Convex
+	// polygons are fanned; others are ear clipped in the plane the polygon
+	// is most nearly parallel to.
+	void TriangulatePolygon(const vector<gl::Vertex>& vertices, const gl::Uint* face, size_t corners, vector<gl::Uint>& out)
+	{
+		// Newell's normal tolerates slightly non-planar faces.
+		gl::Vector3 normal{ 0.0f };
+		for (size_t i = 0; i < corners; ++i) {
+			const gl::Point3& a = vertices[face[i]].position;
+			const gl::Point3& b = vertices[face[(i + 1) % corners]].position;
+			normal += gl::Vector3{ (a.y - b.y) * (a.z + b.z), (a.z - b.z) * (a.x + b.x), (a.x - b.x) * (a.y + b.y) };
+		}
+		gl::Vector3 size = glm::abs(normal);
+		int drop = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+		int u = (drop + 1) % 3, v = (drop + 2) % 3;
+		// Flip an axis if needed so the polygon runs counter-clockwise.
+		float flip = normal[drop] < 0.0f ? -1.0f : 1.0f;
+		vector<gl::Vector2> plane(corners);
+		for (size_t i = 0; i < corners; ++i) {
+			const gl::Point3& p = vertices[face[i]].position;
+			plane[i] = gl::Vector2{ p[u], p[v] * flip };
+		}
+
+		bool convex = true;
+		for (size_t i = 0; i < corners && convex; ++i) {
+			convex = Turn(plane[i], plane[(i + 1) % corners], plane[(i + 2) % corners]) >= 0.0f;
+		}
+		if (convex) {
+			for (size_t i = 2; i < corners; ++i) { out.insert(out.end(), { face[0], face[i - 1], face[i] }); }
+			return;
+		}
+
+		vector<size_t> ring(corners);
+		for (size_t i = 0; i < corners; ++i) { ring[i] = i; }
+		size_t at = 0;
+		for (size_t misses = 0; ring.size() > 3; ) {
+			size_t count = ring.size();
+			size_t a = ring[(at + count - 1) % count], b = ring[at], c = ring[(at + 1) % count];
+			bool ear = Turn(plane[a], plane[b], plane[c]) > 0.0f;
+			for (size_t k = 0; k < count && ear; ++k) {
+				size_t p = ring[k];
+				if (p == a || p == b || p == c) { continue; }
+				ear = !(Turn(plane[a], plane[b], plane[p]) >= 0.0f && Turn(plane[b], plane[c], plane[p]) >= 0.0f
+					&& Turn(plane[c], plane[a], plane[p]) >= 0.0f);
+			}
+			// A degenerate or self-intersecting polygon may have no ear left;
+			// clip anyway rather than loop forever.
+			if (ear || misses == count) {
+				out.insert(out.end(), { face[a], face[b], face[c] });
+				ring.erase(ring.begin() + at);
+				at %= ring.size();
+				misses = 0;
+			}
+			else {
+				at = (at + 1) % count;
+				++misses;
+			}
+		}
+		out.insert(out.end(), { face[ring[0]], face[ring[1]], face[ring[2]] });
+	}
+}
+
+OBJmesh::Corner::Corner(const char* encoding, const char* end, gl::Int pCount, gl::Int tCount, gl::Int nCount)
+	: relative{ 0 }
+{
+	bool rp, rt, rn;
+	encoding = Enter(encoding, end, pCount, p, rp);
+	encoding = Enter(encoding, end, tCount, t, rt);
+	Enter(encoding, end, nCount, n, rn);
+	relative = (rp ? RelativeP : 0) | (rt ? RelativeT : 0) | (rn ? RelativeN : 0);
+}
+
+const char* OBJmesh::Corner::Enter(const char* source, const char* end, gl::Int local, gl::Int& result, bool& relative)
+{
+	result = -1;
+	relative = false;
+	if (source < end && *source != '/') {
+		gl::Int value;
+		source = ParseNumber(source, end, value);
+		if (!value) { throw out_of_range{ "OBJ face refers to element 0" }; }
+		relative = value < 0;
+		result = relative ? local + value : value - 1;
+	}
+	if (source < end && *source == '/') { ++source; }
+	return source;
+}
+
+void OBJmesh::Chunk::Parse(const char* begin, const char* end)
+{
+	for (const char* line = begin; line < end; ) {
+		auto eol = static_cast<const char*>(memchr(line, '\n', end - line));
+		if (!eol) { eol = end; }
+
+		const char* command = SkipBlanks(line, eol);
+		const char* input = SkipToken(command, eol);
+		if (IsCommand(command, input, "v", 1)) {
+			gl::Point3 v;
+			ParseVector(input, eol, v);
+			vList.push_back(v);
+		}
+		else if (IsCommand(command, input, "vt", 2)) {
+			gl::Vector2 t;
+			ParseVector(input, eol, t);
+			vtList.push_back(t);
+		}
+		else if (IsCommand(command, input, "vn", 2)) {
+			gl::Vector3 n;
+			ParseVector(input, eol, n);
+			vnList.push_back(n);
+		}
+		else if (IsCommand(command, input, "f", 1)) {
+			count_type count = 0;
+			for (const char* corner = SkipBlanks(input, eol); corner < eol; corner = SkipBlanks(input, eol)) {
+				input = SkipToken(corner, eol);
+				corners.emplace_back(corner, input, static_cast<gl::Int>(vList.size()), static_cast<gl::Int>(vtList.size()), static_cast<gl::Int>(vnList.size()));
+				count++;
+			}
+			ranges.push_back(count);
+		}
+		else if (IsCommand(command, input, "usemtl", 6)) {
+			uses.emplace_back(ranges.size(), Remainder(input, eol));
+		}
+		else if (IsCommand(command, input, "mtllib", 6)) {
+			libraries.push_back(Remainder(input, eol));
+		}
+
+		line = eol + 1;
+	}
+}
+
+void OBJmesh::Merge(vector<Chunk>& chunks, vector<gl::Uint>& positions)
+{
+	size_t pTotal = 0, tTotal = 0, nTotal = 0, cornerTotal = 0, faceTotal = 0;
+	for (auto& chunk : chunks) {
+		pTotal += chunk.vList.size();
+		tTotal += chunk.vtList.size();
+		nTotal += chunk.vnList.size();
+		cornerTotal += chunk.corners.size();
+		faceTotal += chunk.ranges.size();
+	}
+
+	vector<gl::Point3> vList;
+	vector<gl::Vector3> vnList;
+	vector<gl::Vector2> vtList;
+	vList.reserve(pTotal);
+	vtList.reserve(tTotal);
+	vnList.reserve(nTotal);
+	for (auto& chunk : chunks) {
+		vList.insert(vList.end(), chunk.vList.begin(), chunk.vList.end());
+		vtList.insert(vtList.end(), chunk.vtList.begin(), chunk.vtList.end());
+		vnList.insert(vnList.end(), chunk.vnList.begin(), chunk.vnList.end());
+	}
+
+	auto rebase = [](gl::Int& index, bool relative, size_t base, size_t limit) {
+		if (index < 0 && !relative) { return; }
+		ptrdiff_t resolved = relative ? static_cast<ptrdiff_t>(base) + index : index;
+		if (resolved < 0 || resolved >= static_cast<ptrdiff_t>(limit)) { throw out_of_range{ "OBJ face refers to missing element" }; }
+		index = static_cast<gl::Int>(resolved);
+	};
+
+	// Most meshes have about one vertex per position, so start from that
+	// and let the table grow if uvs or normals split many of them.
+	// Faces take the most recent usemtl, which may come from an earlier chunk.
+	bool usesMaterials = any_of(chunks.begin(), chunks.end(), [](const Chunk& chunk) { return !chunk.uses.empty(); });
+	unordered_map<string, gl::Uint> named;
+	auto lookup = [&](const string& name) {
+		auto found = named.emplace(name, static_cast<gl::Uint>(library.size()));
+		if (found.second) {
+			library.emplace_back();
+			library.back().name = name;
+		}
+		return found.first->second;
+	};
+	if (usesMaterials) { materialOf.reserve(faceTotal); }
+	bool current = false;
+	gl::Uint material = 0;
+
+	gl::obj::VertexTable verts{ min(cornerTotal, max({ pTotal, tTotal, nTotal })) };
+	vertices.reserve(min(cornerTotal, max({ pTotal, tTotal, nTotal })));
+	positions.reserve(vertices.capacity());
+	faces.reserve(cornerTotal);
+	ranges.reserve(faceTotal);
+	size_t pBase = 0, tBase = 0, nBase = 0;
+	for (auto& chunk : chunks) {
+		for (Corner& corner : chunk.corners) {
+			Index id = corner;
+			rebase(id.p, (corner.relative & Corner::RelativeP) != 0, pBase, pTotal);
+			rebase(id.t, (corner.relative & Corner::RelativeT) != 0, tBase, tTotal);
+			rebase(id.n, (corner.relative & Corner::RelativeN) != 0, nBase, nTotal);
+
+			auto found = verts.Insert(id, static_cast<gl::Uint>(vertices.size()));
+			if (found.second) {
+				gl::Vertex v{};
+				if (id.p >= 0) v.position = vList[id.p];
+				if (id.t >= 0) v.uv = vtList[id.t];
+				if (id.n >= 0) v.normal = vnList[id.n];
+				vertices.push_back(v);
+				// Corners with no position share one past the last.
+				positions.push_back(static_cast<gl::Uint>(id.p >= 0 ? id.p : pTotal));
+			}
+			faces.push_back(found.first);
+		}
+		ranges.insert(ranges.end(), chunk.ranges.begin(), chunk.ranges.end());
+		libraries.insert(libraries.end(), chunk.libraries.begin(), chunk.libraries.end());
+		if (usesMaterials) {
+			auto use = chunk.uses.begin();
+			for (size_t face = 0; face < chunk.ranges.size(); ++face) {
+				for (; use != chunk.uses.end() && use->first == face; ++use) {
+					material = lookup(use->second);
+					current = true;
+				}
+				if (!current) {
+					material = lookup("");
+					current = true;
+				}
+				materialOf.push_back(material);
+			}
+			for (; use != chunk.uses.end(); ++use) {
+				material = lookup(use->second);
+				current = true;
+			}
+		}
+
+		pBase += chunk.vList.size();
+		tBase += chunk.vtList.size();
+		nBase += chunk.vnList.size();
+		chunk = Chunk{};
+	}
+}
+
+OBJmesh::OBJmesh(const string& filename, unsigned threads)
+	: OBJmesh{ io::MappedFile{ filename }, threads }
+{
+	LoadMaterials(filesystem::path{ filename }.parent_path().string());
+}
+
+OBJmesh::OBJmesh(const io::MappedFile& source, unsigned threads)
+{
+	// Below this many bytes per worker, thread start-up costs more than it saves.
+	constexpr size_t minimumChunk = 1 << 20;
+
+	if (!threads) { threads = max(thread::hardware_concurrency(), 1u); }
+	size_t count = min<size_t>(threads, max<size_t>(source.size() / minimumChunk, 1));
+
+	vector<const char*> bounds{ source.begin() };
+	for (size_t i = 1; i < count; ++i) {
+		const char* split = max(source.begin() + source.size() * i / count, bounds.back());
+		auto eol = static_cast<const char*>(memchr(split, '\n', source.end() - split));
+		bounds.push_back(eol ? eol + 1 : source.end());
+	}
+	bounds.push_back(source.end());
+
+	vector<Chunk> chunks(count);
+	vector<future<void>> workers;
+	for (size_t i = 1; i < count; ++i) {
+		workers.push_back(async(launch::async, &Chunk::Parse, &chunks[i], bounds[i], bounds[i + 1]));
+	}
+	chunks[0].Parse(bounds[0], bounds[1]);
+	for (auto& worker : workers) { worker.get(); }
+
+	vector<gl::Uint> positions;
+	Merge(chunks, positions);
+	Triangulate();
+	if (any_of(vertices.begin(), vertices.end(), [](const gl::Vertex& v) { return v.normal == gl::Vector3{ 0.0f }; })) {
+		gl::GenerateNormals(vertices, faces, positions, threads);
+	}
+	gl::GenerateTangents(vertices, faces, threads);
+	GroupByMaterial();
+}
+
+void OBJmesh::LoadMaterials(const string& directory)
+{
+	unordered_map<string, gl::Material*> named;
+	for (auto& material : library) { named.emplace(material.name, &material); }
+
+	for (const auto& name : libraries) {
+		unique_ptr<io::MappedFile> file;
+		try {
+			file.reset(new io::MappedFile{ (filesystem::path{ directory } / name).string() });
+		}
+		catch (const runtime_error&) {
+			continue;
+		}
+
+		// Only the first definition of a name in any library counts.
+		gl::Material* target = nullptr;
+		for (const char* line = file->begin(); line < file->end(); ) {
+			auto eol = static_cast<const char*>(memchr(line, '\n', file->end() - line));
+			if (!eol) { eol = file->end(); }
+
+			const char* command = SkipBlanks(line, eol);
+			const char* input = SkipToken(command, eol);
+			if (IsCommand(command, input, "newmtl", 6)) {
+				auto found = named.find(Remainder(input, eol));
+				target = found != named.end() ? found->second : nullptr;
+				if (target) { named.erase(found); }
+			}
+			else if (!target) {}
+			else if (IsCommand(command, input, "Kd", 2)) {
+				gl::Color diffuse;
+				ParseVector(input, eol, diffuse);
+				target->diffuse = gl::ColorAlpha{ diffuse, target->diffuse.a };
+			}
+			else if (IsCommand(command, input, "Ks", 2)) { ParseVector(input, eol, target->specular); }
+			else if (IsCommand(command, input, "Ns", 2)) { ParseNumber(SkipBlanks(input, eol), eol, target->shininess); }
+			else if (IsCommand(command, input, "d", 1)) { ParseNumber(SkipBlanks(input, eol), eol, target->diffuse.a); }
+			else if (IsCommand(command, input, "Tr", 2)) {
+				gl::Float transparency;
+				ParseNumber(SkipBlanks(input, eol), eol, transparency);
+				target->diffuse.a = 1.0f - transparency;
+			}
+			else if (IsCommand(command, input, "map_Kd", 6)) {
+				// Options such as -s come first; the file name is the last token.
+				string path = Remainder(input, eol);
+				auto space = path.find_last_of(" \t");
+				target->diffuseMap = space == string::npos ? path : path.substr(space + 1);
+			}
+
+			line = eol + 1;
+		}
+	}
+}
+
+void OBJmesh::Triangulate()
+{
+	if (all_of(ranges.begin(), ranges.end(), [](count_type corners) { return corners == 3; })) { return; }
+
+	vector<index_type> triangles;
+	vector<gl::Uint> triangleMaterials;
+	triangles.reserve(faces.size() * 3);
+	auto face = faces.data();
+	for (size_t f = 0; f < ranges.size(); ++f) {
+		count_type corners = ranges[f];
+		// Points and lines written as faces have nothing to fill.
+		if (corners == 3) { triangles.insert(triangles.end(), face, face + 3); }
+		else if (corners > 3) { TriangulatePolygon(vertices, face, corners, triangles); }
+		if (!materialOf.empty()) { triangleMaterials.resize(triangles.size() / 3, materialOf[f]); }
+		face += corners;
+	}
+	faces.swap(triangles);
+	materialOf.swap(triangleMaterials);
+	ranges.assign(faces.size() / 3, 3);
+}
+
+void OBJmesh::GroupByMaterial()
+{
+	if (is_sorted(materialOf.begin(), materialOf.end())) { return; }
+
+	// A stable sort keeps each material's faces in file order.
+	vector<size_t> order(materialOf.size());
+	iota(order.begin(), order.end(), size_t{ 0 });
+	stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return materialOf[a] < materialOf[b]; });
+
+	vector<index_type> sorted(faces.size());
+	vector<gl::Uint> sortedMaterials(materialOf.size());
+	for (size_t t = 0; t < order.size(); ++t) {
+		copy_n(&faces[order[t] * 3], 3, &sorted[t * 3]);
+		sortedMaterials[t] = materialOf[order[t]];
+	}
+	faces.swap(sorted);
+	materialOf.swap(sortedMaterials);
+}
+
+gl::optimize::Report OBJmesh::Optimize()
+{
+	using namespace gl::optimize;
+
+	Report report;
+	report.before = AnalyzeVertexCache(faces, vertices.size());
+	// Triangles may only move within their material's group.
+	size_t triangles = faces.size() / 3;
+	auto sameGroup = [this](size_t a, size_t b) { return materialOf.empty() || materialOf[a] == materialOf[b]; };
+	vector<index_type> group;
+	for (size_t first = 0, last; first < triangles; first = last) {
+		for (last = first + 1; last < triangles && sameGroup(first, last); ++last) {}
+
+		group.assign(faces.begin() + first * 3, faces.begin() + last * 3);
+		ReorderForVertexCache(group, vertices.size());
+		ReorderForOverdraw(group, vertices);
+		copy(group.begin(), group.end(), faces.begin() + first * 3);
+	}
+	ReorderForVertexFetch(vertices, faces);
+	report.after = AnalyzeVertexCache(faces, vertices.size());
+	return report;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_OBJMESH
+#define OPENGL_WRAPPER_OBJMESH
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "OpenGL.h"
+#include "Vertex.h"
+#include "Material.h"
+#include "MeshOptimizer.h"
+#include "VertexTable.h"
+#include "../IO/MappedFile.h"
+
+class OBJmesh {
+public:
+	using vertex_type = gl::Vertex;
+	using index_type = gl::Uint;
+	using count_type = gl::Ushort;
+
+	// threads == 0 uses one worker per hardware thread; small files are
+	// always parsed on the calling thread. Polygons are triangulated as
+	// they load, so fData() is always a plain triangle list, and faces are
+	// grouped by material in order of first use. Corners without a normal
+	// get a smooth one, and every vertex gets a tangent.
+	OBJmesh(const std::string& filename, unsigned threads = 0);
+	// A mapped file has no directory to find its mtllib files in; call
+	// LoadMaterials to fill in the material settings.
+	OBJmesh(const io::MappedFile& source, unsigned threads = 0);
+	const std::vector<vertex_type>& vData() const { return vertices; }
+	const std::vector<index_type>& fData() const { return faces; }
+	const std::vector<count_type>& faceSegments() const { return ranges; }
+	// One material per usemtl name. Faces before the first usemtl get an
+	// unnamed default material.
+	const std::vector<gl::Material>& materials() const { return library; }
+	// Material of each face, non-decreasing; empty if the file has no usemtl.
+	const std::vector<gl::Uint>& faceMaterials() const { return materialOf; }
+	// The mtllib names as written in the file, for tracking what a cooked
+	// mesh depends on.
+	const std::vector<std::string>& materialLibraries() const { return libraries; }
+
+	// Reads the mtllib files, resolved against directory, into materials().
+	// Missing libraries leave their materials at the defaults.
+	void LoadMaterials(const std::string& directory);
+
+	// Reorders the faces of each material for the vertex cache and overdraw
+	// and the vertices for fetch locality.
+	gl::optimize::Report Optimize();
+private:
+	std::vector<vertex_type> vertices;
+	std::vector<index_type> faces;
+	std::vector<count_type> ranges;
+	std::vector<gl::Material> library;
+	std::vector<gl::Uint> materialOf;
+	std::vector<std::string> libraries;
+
+	using Index = gl::obj::Index;
+
+	// A face corner as written in one chunk of the file. Negative OBJ
+	// indices are stored relative to the start of that chunk's element
+	// lists and flagged, so the merge can rebase them once the element
+	// counts of all earlier chunks are known.
+	struct Corner : Index {
+		enum : gl::Ubyte { RelativeP = 1, RelativeT = 2, RelativeN = 4 };
+		gl::Ubyte relative;
+
+		Corner(const char* encoding, const char* end, gl::Int pCount, gl::Int tCount, gl::Int nCount);
+	private:
+		static const char* Enter(const char* source, const char* end, gl::Int local, gl::Int& result, bool& relative);
+	};
+
+	struct Chunk {
+		std::vector<gl::Point3> vList;
+		std::vector<gl::Vector3> vnList;
+		std::vector<gl::Vector2> vtList;
+		std::vector<Corner> corners;
+		std::vector<count_type> ranges;
+		// usemtl names with the number of faces of this chunk before them.
+		std::vector<std::pair<std::size_t, std::string>> uses;
+		std::vector<std::string> libraries;
+
+		void Parse(const char* begin, const char* end);
+	};
+
+	// positions receives the v element each vertex was built from.
+	void Merge(std::vector<Chunk>& chunks, std::vector<gl::Uint>& positions);
+	void Triangulate();
+	void GroupByMaterial();
+};
+
+#endif
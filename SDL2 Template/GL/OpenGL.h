@@ -20,6 +20,7 @@
 #include <string>
 #include <stdexcept>
 #include <unordered_map>
+#include <utility>
 
 #include "glm/glm.hpp"
 
@@ -42,6 +43,8 @@ namespace gl {
 		using value_type = Uint;
 
         explicit operator bool() const { return _name != 0; }
+        // Exchanges the GL objects named by this and other.
+        void swap(Name<T>& other) noexcept { std::swap(_name, other._name); }
 	protected:
         Name();
         ~Name();
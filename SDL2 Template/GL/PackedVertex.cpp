@@ -0,0 +1,145 @@
+#include "PackedVertex.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "glm/gtc/constants.hpp"
+using namespace std;
+
+namespace {
+    gl::Ushort Unorm16(gl::Float value, gl::Float lower, gl::Float extent)
+    {
+        if (extent <= 0.0f) { return 0; }
+        return static_cast<gl::Ushort>(lround(clamp((value - lower) / extent, 0.0f, 1.0f) * 65535.0f));
+    }
+
+    gl::Short Snorm16(gl::Float value)
+    {
+        return static_cast<gl::Short>(lround(clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    gl::Vector2 OctEncode(gl::Vector3 n)
+    {
+        n /= abs(n.x) + abs(n.y) + abs(n.z);
+        gl::Vector2 result{ n.x, n.y };
+        if (n.z < 0.0f) {
+            result.x = (1.0f - abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+            result.y = (1.0f - abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+        }
+        return result;
+    }
+
+    gl::Vector3 OctDecode(gl::Vector2 e)
+    {
+        gl::Vector3 n{ e.x, e.y, 1.0f - abs(e.x) - abs(e.y) };
+        float t = max(-n.z, 0.0f);
+        n.x += n.x >= 0.0f ? -t : t;
+        n.y += n.y >= 0.0f ? -t : t;
+        return glm::normalize(n);
+    }
+
+    // A unit vector at right angles to n, and n x that (Duff et al. 2017).
+    void Basis(const gl::Vector3& n, gl::Vector3& b1, gl::Vector3& b2)
+    {
+        float sign = n.z >= 0.0f ? 1.0f : -1.0f;
+        float a = -1.0f / (sign + n.z);
+        float b = n.x * n.y * a;
+        b1 = gl::Vector3{ 1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x };
+        b2 = gl::Vector3{ b, sign + n.y * n.y * a, -n.y };
+    }
+
+    gl::Ushort TangentEncode(const gl::Vector3& normal, const gl::Vector4& tangent)
+    {
+        gl::Vector3 b1, b2;
+        Basis(normal, b1, b2);
+        float angle = atan2(glm::dot(gl::Vector3{ tangent }, b2), glm::dot(gl::Vector3{ tangent }, b1));
+        auto q = static_cast<gl::Ushort>(lround((angle / glm::pi<float>() * 0.5f + 0.5f) * 32767.0f));
+        return static_cast<gl::Ushort>(q << 1 | (tangent.w < 0.0f ? 1 : 0));
+    }
+
+    gl::Vector4 TangentDecode(const gl::Vector3& normal, gl::Ushort encoded)
+    {
+        gl::Vector3 b1, b2;
+        Basis(normal, b1, b2);
+        float angle = ((encoded >> 1) / 32767.0f * 2.0f - 1.0f) * glm::pi<float>();
+        return gl::Vector4{ b1 * cos(angle) + b2 * sin(angle), encoded & 1 ? -1.0f : 1.0f };
+    }
+}
+
+namespace gl {
+    Quantization Quantize(const vector<Vertex>& vertices)
+    {
+        Quantization result{};
+        if (vertices.empty()) { return result; }
+
+        Point3 lower = vertices.front().position, upper = lower;
+        Vector2 uvLower = vertices.front().uv, uvUpper = uvLower;
+        for (const Vertex& v : vertices) {
+            lower = glm::min(lower, v.position);
+            upper = glm::max(upper, v.position);
+            uvLower = glm::min(uvLower, v.uv);
+            uvUpper = glm::max(uvUpper, v.uv);
+        }
+        result.lower = lower;
+        result.extent = upper - lower;
+        result.uvLower = uvLower;
+        result.uvExtent = uvUpper - uvLower;
+        return result;
+    }
+
+    PackingError PackVertices(const vector<Vertex>& vertices, const Quantization& bounds, vector<PackedVertex>& packed)
+    {
+        PackingError error{};
+        Float cosine = 1.0f;
+        packed.resize(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            const Vertex& v = vertices[i];
+            PackedVertex& p = packed[i];
+            for (int k = 0; k < 3; ++k) { p.position[k] = Unorm16(v.position[k], bounds.lower[k], bounds.extent[k]); }
+            for (int k = 0; k < 2; ++k) { p.uv[k] = Unorm16(v.uv[k], bounds.uvLower[k], bounds.uvExtent[k]); }
+
+            // Of the four snorm neighbours of the encoding, keep the one that
+            // decodes closest to the original normal.
+            Float length = glm::length(v.normal);
+            if (length > 0.0f) {
+                Vector3 normal = v.normal / length;
+                Vector2 e = OctEncode(normal);
+                Float best = -2.0f;
+                for (int corner = 0; corner < 4; ++corner) {
+                    Short candidate[2];
+                    for (int k = 0; k < 2; ++k) {
+                        Float scaled = clamp(e[k], -1.0f, 1.0f) * 32767.0f;
+                        candidate[k] = static_cast<Short>(corner >> k & 1 ? ceil(scaled) : floor(scaled));
+                    }
+                    Float match = glm::dot(normal, OctDecode(Vector2{ candidate[0], candidate[1] } / 32767.0f));
+                    if (match > best) {
+                        best = match;
+                        copy(begin(candidate), end(candidate), p.normal);
+                    }
+                }
+                cosine = min(cosine, best);
+            }
+            else {
+                p.normal[0] = p.normal[1] = Snorm16(0.0f);
+            }
+            // Against the normal as decoded, so the angle survives rounding.
+            p.position[3] = TangentEncode(OctDecode(glm::max(Vector2{ p.normal[0], p.normal[1] } / 32767.0f, Vector2{ -1.0f })), v.tangent);
+
+            Vertex decoded = UnpackVertex(p, bounds);
+            error.position = max(error.position, glm::distance(decoded.position, v.position));
+            error.uv = max(error.uv, glm::distance(decoded.uv, v.uv));
+        }
+        error.normal = glm::degrees(acos(clamp(cosine, -1.0f, 1.0f)));
+        return error;
+    }
+
+    Vertex UnpackVertex(const PackedVertex& packed, const Quantization& bounds)
+    {
+        Vertex result;
+        for (int k = 0; k < 3; ++k) { result.position[k] = bounds.lower[k] + packed.position[k] / 65535.0f * bounds.extent[k]; }
+        for (int k = 0; k < 2; ++k) { result.uv[k] = bounds.uvLower[k] + packed.uv[k] / 65535.0f * bounds.uvExtent[k]; }
+        result.normal = OctDecode(glm::max(Vector2{ packed.normal[0], packed.normal[1] } / 32767.0f, Vector2{ -1.0f }));
+        result.tangent = TangentDecode(result.normal, packed.position[3]);
+        return result;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_PACKEDVERTEX
+#define OPENGL_WRAPPER_PACKEDVERTEX
+
+#include <vector>
+
+#include "OpenGL.h"
+#include "Vertex.h"
+
+namespace gl {
+    // Half-size vertex for the GL. Positions are unorm16 fractions of the
+    // mesh bounds, normals are octahedral snorm16 pairs and uvs are unorm16
+    // fractions of the uv bounds; the vertex shader undoes all three.
+    // The tangent rides in position w as its angle about the decoded normal,
+    // in the top 15 bits, and the bitangent sign, set for -1, in bit 0.
+    struct PackedVertex {
+        Ushort position[4];
+        Short normal[2];
+        Ushort uv[2];
+    };
+
+    // What the shader needs to decode a PackedVertex: value = lower + q * extent.
+    struct Quantization {
+        Point3 lower;
+        Vector3 extent;
+        Vector2 uvLower;
+        Vector2 uvExtent;
+        // Clear when normals arrive as plain vectors rather than pairs.
+        Bool octahedral = GL_TRUE;
+    };
+
+    // Largest error packing introduced: distance in model units, normal
+    // angle in degrees and uv distance.
+    struct PackingError {
+        Float position;
+        Float normal;
+        Float uv;
+    };
+
+    Quantization Quantize(const std::vector<Vertex>& vertices);
+
+    PackingError PackVertices(const std::vector<Vertex>& vertices, const Quantization& bounds, std::vector<PackedVertex>& packed);
+
+    Vertex UnpackVertex(const PackedVertex& packed, const Quantization& bounds);
+}
+
+#endif
@@ -3,8 +3,10 @@
 
 #include "Shader.h"
 
+#include <algorithm>
 #include <string>
 #include <memory>
+#include <unordered_map>
 using namespace std;
 
 using glm::vec4; using glm::mat4;
@@ -20,6 +22,68 @@ namespace {
         glGet__InfoLog(object, log_length, NULL, buffer.get());
         return string{buffer.get()};
     }
+
+    struct active_uniform {
+        GLenum type;
+        GLint size;
+    };
+
+    // Active uniforms of program by name; arrays are listed without the
+    // "[0]" that GL reports on their first element.
+    unordered_map<string, active_uniform> list_uniforms(GLuint program)
+    {
+        GLint count = 0, longest = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &longest);
+        unique_ptr<char[]> name{new char[longest + 1]};
+        unordered_map<string, active_uniform> uniforms;
+        for (GLint index = 0; index < count; ++index) {
+            GLsizei length = 0;
+            active_uniform uniform;
+            glGetActiveUniform(program, index, longest + 1, &length, &uniform.size, &uniform.type, name.get());
+            string key{name.get(), static_cast<size_t>(length)};
+            if (uniform.size > 1 && key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0) { key.resize(key.size() - 3); }
+            uniforms.emplace(move(key), uniform);
+        }
+        return uniforms;
+    }
+
+    // Types without a case here, such as doubles, are left alone.
+    void copy_uniform(GLuint from, GLint source, GLuint to, GLint target, GLenum type)
+    {
+        GLfloat f[16];
+        GLint i[4];
+        GLuint u[4];
+        switch (type) {
+        case GL_FLOAT:      glGetUniformfv(from, source, f); glProgramUniform1fv(to, target, 1, f); break;
+        case GL_FLOAT_VEC2: glGetUniformfv(from, source, f); glProgramUniform2fv(to, target, 1, f); break;
+        case GL_FLOAT_VEC3: glGetUniformfv(from, source, f); glProgramUniform3fv(to, target, 1, f); break;
+        case GL_FLOAT_VEC4: glGetUniformfv(from, source, f); glProgramUniform4fv(to, target, 1, f); break;
+        case GL_FLOAT_MAT2: glGetUniformfv(from, source, f); glProgramUniformMatrix2fv(to, target, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT3: glGetUniformfv(from, source, f); glProgramUniformMatrix3fv(to, target, 1, GL_FALSE, f); break;
+        case GL_FLOAT_MAT4: glGetUniformfv(from, source, f); glProgramUniformMatrix4fv(to, target, 1, GL_FALSE, f); break;
+        case GL_INT:
+        case GL_BOOL:
+        case GL_SAMPLER_1D:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_2D_ARRAY:
+                            glGetUniformiv(from, source, i); glProgramUniform1iv(to, target, 1, i); break;
+        case GL_INT_VEC2:
+        case GL_BOOL_VEC2:  glGetUniformiv(from, source, i); glProgramUniform2iv(to, target, 1, i); break;
+        case GL_INT_VEC3:
+        case GL_BOOL_VEC3:  glGetUniformiv(from, source, i); glProgramUniform3iv(to, target, 1, i); break;
+        case GL_INT_VEC4:
+        case GL_BOOL_VEC4:  glGetUniformiv(from, source, i); glProgramUniform4iv(to, target, 1, i); break;
+        case GL_UNSIGNED_INT:      glGetUniformuiv(from, source, u); glProgramUniform1uiv(to, target, 1, u); break;
+        case GL_UNSIGNED_INT_VEC2: glGetUniformuiv(from, source, u); glProgramUniform2uiv(to, target, 1, u); break;
+        case GL_UNSIGNED_INT_VEC3: glGetUniformuiv(from, source, u); glProgramUniform3uiv(to, target, 1, u); break;
+        case GL_UNSIGNED_INT_VEC4: glGetUniformuiv(from, source, u); glProgramUniform4uiv(to, target, 1, u); break;
+        default: break;
+        }
+    }
 }
 
 namespace gl {
@@ -76,6 +140,41 @@ namespace gl {
         glUseProgram(0);
     }
 
+    void Program::swap(Program& other) noexcept
+    {
+        Name<Program>::swap(other);
+        attributes = AttributesProxy{ *this };
+        other.attributes = AttributesProxy{ other };
+    }
+
+    void Program::Adopt(const Program& previous)
+    {
+        auto uniforms = list_uniforms(_name);
+        for (auto& uniform : list_uniforms(previous._name)) {
+            auto match = uniforms.find(uniform.first);
+            if (match == uniforms.end() || match->second.type != uniform.second.type) { continue; }
+            GLint count = min(uniform.second.size, match->second.size);
+            for (GLint element = 0; element < count; ++element) {
+                string name = uniform.second.size > 1 ? uniform.first + "[" + to_string(element) + "]" : uniform.first;
+                GLint source = glGetUniformLocation(previous._name, name.c_str());
+                GLint target = glGetUniformLocation(_name, name.c_str());
+                // Members of uniform blocks have no location.
+                if (source != -1 && target != -1) { copy_uniform(previous._name, source, _name, target, uniform.second.type); }
+            }
+        }
+
+        GLint blocks = 0, longest = 0;
+        glGetProgramiv(previous._name, GL_ACTIVE_UNIFORM_BLOCKS, &blocks);
+        glGetProgramiv(previous._name, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &longest);
+        unique_ptr<char[]> name{new char[longest + 1]};
+        for (GLint block = 0; block < blocks; ++block) {
+            glGetActiveUniformBlockName(previous._name, block, longest + 1, NULL, name.get());
+            if (glGetUniformBlockIndex(_name, name.get()) == GL_INVALID_INDEX) { continue; }
+            UniformBuffer::BindingPoint binding = previous[name.get()];
+            (*this)[name.get()] = binding;
+        }
+    }
+
     Program::UniformBinding& Program::UniformBinding::operator=(UniformBuffer::BindingPoint value)
     {
         glUniformBlockBinding(program._name, index, value);
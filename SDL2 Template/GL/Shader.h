@@ -47,6 +47,14 @@ namespace gl {
         void Activate( ) const;
         static void Deactivate();
 
+        // Exchanges linked programs with other, so references to either
+        // draw with the other's shaders from then on.
+        void swap(Program& other) noexcept;
+        // Copies the uniform values and uniform block bindings of previous
+        // that this program shares by name and type, so a relinked program
+        // carries on where the old one left off.
+        void Adopt(const Program& previous);
+
         class AttributeBinding : private std::string {
         public:
             using value_type = gl::Int;
@@ -0,0 +1,242 @@
+#include "TangentSpace.h"
+
+#include <algorithm>
+#include <future>
+#include <thread>
+
+#include <emmintrin.h>
+using namespace std;
+
+namespace {
+    // Triangles per batch, one in each SSE lane.
+    constexpr size_t Lanes = 4;
+
+    struct Lane3 {
+        __m128 x, y, z;
+    };
+
+    Lane3 operator- (const Lane3& a, const Lane3& b) { return Lane3{ _mm_sub_ps(a.x, b.x), _mm_sub_ps(a.y, b.y), _mm_sub_ps(a.z, b.z) }; }
+    Lane3 operator* (const Lane3& a, __m128 s) { return Lane3{ _mm_mul_ps(a.x, s), _mm_mul_ps(a.y, s), _mm_mul_ps(a.z, s) }; }
+
+    __m128 Dot(const Lane3& a, const Lane3& b)
+    {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+    }
+
+    Lane3 Cross(const Lane3& a, const Lane3& b)
+    {
+        return Lane3{
+            _mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(a.z, b.y)),
+            _mm_sub_ps(_mm_mul_ps(a.z, b.x), _mm_mul_ps(a.x, b.z)),
+            _mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(a.y, b.x))
+        };
+    }
+
+    // Never zero, so degenerate edges divide to zero instead of NaN.
+    __m128 Length(const Lane3& a)
+    {
+        return _mm_sqrt_ps(_mm_max_ps(Dot(a, a), _mm_set1_ps(1e-30f)));
+    }
+
+    __m128 Select(__m128 mask, __m128 yes, __m128 no)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, yes), _mm_andnot_ps(mask, no));
+    }
+
+    // Within 7e-5 radians (Abramowitz and Stegun 4.4.45); x is clamped to [-1, 1].
+    __m128 Acos(__m128 x)
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        __m128 a = _mm_min_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), x), one);
+        __m128 poly = _mm_set1_ps(-0.0187293f);
+        poly = _mm_add_ps(_mm_mul_ps(poly, a), _mm_set1_ps(0.0742610f));
+        poly = _mm_add_ps(_mm_mul_ps(poly, a), _mm_set1_ps(-0.2121144f));
+        poly = _mm_add_ps(_mm_mul_ps(poly, a), _mm_set1_ps(1.5707288f));
+        __m128 result = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(one, a)), poly);
+        return Select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(3.14159265f), result), result);
+    }
+
+    // Loads one corner of count triangles, repeating the last to fill the batch.
+    Lane3 Gather(const vector<gl::Vertex>& vertices, const gl::Uint* triangles, size_t count, size_t corner, gl::Vector3 gl::Vertex::* field)
+    {
+        alignas(16) float x[Lanes], y[Lanes], z[Lanes];
+        for (size_t lane = 0; lane < Lanes; ++lane) {
+            const gl::Vector3& v = vertices[triangles[min(lane, count - 1) * 3 + corner]].*field;
+            x[lane] = v.x;
+            y[lane] = v.y;
+            z[lane] = v.z;
+        }
+        return Lane3{ _mm_load_ps(x), _mm_load_ps(y), _mm_load_ps(z) };
+    }
+
+    void GatherUV(const vector<gl::Vertex>& vertices, const gl::Uint* triangles, size_t count, size_t corner, __m128& u, __m128& v)
+    {
+        alignas(16) float s[Lanes], t[Lanes];
+        for (size_t lane = 0; lane < Lanes; ++lane) {
+            const gl::Vector2& uv = vertices[triangles[min(lane, count - 1) * 3 + corner]].uv;
+            s[lane] = uv.x;
+            t[lane] = uv.y;
+        }
+        u = _mm_load_ps(s);
+        v = _mm_load_ps(t);
+    }
+
+    // Writes lane values to out[lane * 3], the same corner of consecutive triangles.
+    void Scatter(const Lane3& value, __m128 w, size_t count, gl::Vector4* out)
+    {
+        alignas(16) float x[Lanes], y[Lanes], z[Lanes], q[Lanes];
+        _mm_store_ps(x, value.x);
+        _mm_store_ps(y, value.y);
+        _mm_store_ps(z, value.z);
+        _mm_store_ps(q, w);
+        for (size_t lane = 0; lane < count; ++lane) { out[lane * 3] = gl::Vector4{ x[lane], y[lane], z[lane], q[lane] }; }
+    }
+
+    // The interior angle at each corner of the batch's triangles.
+    void CornerAngles(const Lane3 (&p)[3], __m128 (&angles)[3])
+    {
+        Lane3 edge[3] = { p[1] - p[0], p[2] - p[1], p[0] - p[2] };
+        __m128 length[3] = { Length(edge[0]), Length(edge[1]), Length(edge[2]) };
+        for (size_t c = 0; c < 3; ++c) {
+            size_t in = (c + 2) % 3;
+            __m128 cosine = _mm_div_ps(Dot(edge[c], edge[in]), _mm_mul_ps(length[c], length[in]));
+            angles[c] = Acos(_mm_sub_ps(_mm_setzero_ps(), cosine));
+        }
+    }
+
+    template <typename Work>
+    void Parallel(size_t count, unsigned threads, const Work& work)
+    {
+        // Below this many items per worker, thread start-up costs more than it saves.
+        constexpr size_t minimumPart = 1 << 14;
+
+        if (!threads) { threads = max(thread::hardware_concurrency(), 1u); }
+        size_t parts = min<size_t>(threads, max<size_t>(count / minimumPart, 1));
+        vector<future<void>> workers;
+        for (size_t i = 1; i < parts; ++i) {
+            workers.push_back(async(launch::async, [&work, i, parts, count] { work(count * i / parts, count * (i + 1) / parts); }));
+        }
+        work(0, count / parts);
+        for (auto& worker : workers) { worker.get(); }
+    }
+
+    // Corners sorted by key, so the corners of each key are summed by one
+    // thread without locking.
+    struct Adjacency {
+        vector<gl::Uint> offsets;
+        vector<gl::Uint> corners;
+
+        template <typename Key>
+        Adjacency(size_t cornerCount, size_t keyCount, const Key& key)
+        :   offsets(keyCount + 1, 0), corners(cornerCount)
+        {
+            for (size_t c = 0; c < cornerCount; ++c) { ++offsets[key(c) + 1]; }
+            for (size_t k = 0; k < keyCount; ++k) { offsets[k + 1] += offsets[k]; }
+            vector<gl::Uint> next(offsets.begin(), offsets.end() - 1);
+            for (size_t c = 0; c < cornerCount; ++c) { corners[next[key(c)]++] = static_cast<gl::Uint>(c); }
+        }
+    };
+
+    // Any unit vector at right angles to n (Duff et al. 2017).
+    gl::Vector3 Perpendicular(const gl::Vector3& n)
+    {
+        float sign = n.z >= 0.0f ? 1.0f : -1.0f;
+        float a = -1.0f / (sign + n.z);
+        return gl::Vector3{ 1.0f + sign * n.x * n.x * a, sign * n.x * n.y * a, -sign * n.x };
+    }
+}
+
+namespace gl {
+    void GenerateNormals(vector<Vertex>& vertices, const vector<Uint>& triangles, const vector<Uint>& positions, unsigned threads)
+    {
+        size_t count = triangles.size() / 3;
+        vector<Vector4> corners(count * 3);
+        Parallel(count, threads, [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; t += Lanes) {
+                size_t lanes = min(Lanes, end - t);
+                const Uint* tri = &triangles[t * 3];
+                Lane3 p[3];
+                for (size_t c = 0; c < 3; ++c) { p[c] = Gather(vertices, tri, lanes, c, &Vertex::position); }
+                __m128 angles[3];
+                CornerAngles(p, angles);
+                // The cross product's length is twice the face area.
+                Lane3 face = Cross(p[1] - p[0], p[2] - p[0]);
+                for (size_t c = 0; c < 3; ++c) { Scatter(face * angles[c], _mm_setzero_ps(), lanes, &corners[t * 3 + c]); }
+            }
+        });
+
+        auto key = [&](size_t vertex) { return positions.empty() ? static_cast<Uint>(vertex) : positions[vertex]; };
+        size_t keyCount = positions.empty() ? vertices.size() : *max_element(positions.begin(), positions.end()) + size_t{ 1 };
+        Adjacency around{ corners.size(), keyCount, [&](size_t corner) { return key(triangles[corner]); } };
+
+        Parallel(vertices.size(), threads, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) {
+                if (vertices[v].normal != Vector3{ 0.0f }) { continue; }
+                Uint k = key(v);
+                Vector3 sum{ 0.0f };
+                for (Uint at = around.offsets[k]; at < around.offsets[k + 1]; ++at) { sum += Vector3{ corners[around.corners[at]] }; }
+                Float length = glm::length(sum);
+                if (length > 0.0f) { vertices[v].normal = sum / length; }
+            }
+        });
+    }
+
+    void GenerateTangents(vector<Vertex>& vertices, const vector<Uint>& triangles, unsigned threads)
+    {
+        size_t count = triangles.size() / 3;
+        vector<Vector4> corners(count * 3);
+        Parallel(count, threads, [&](size_t begin, size_t end) {
+            const __m128 zero = _mm_setzero_ps();
+            for (size_t t = begin; t < end; t += Lanes) {
+                size_t lanes = min(Lanes, end - t);
+                const Uint* tri = &triangles[t * 3];
+                Lane3 p[3], n[3];
+                __m128 u[3], v[3];
+                for (size_t c = 0; c < 3; ++c) {
+                    p[c] = Gather(vertices, tri, lanes, c, &Vertex::position);
+                    n[c] = Gather(vertices, tri, lanes, c, &Vertex::normal);
+                    GatherUV(vertices, tri, lanes, c, u[c], v[c]);
+                }
+                __m128 angles[3];
+                CornerAngles(p, angles);
+
+                Lane3 e1 = p[1] - p[0], e2 = p[2] - p[0];
+                __m128 du1 = _mm_sub_ps(u[1], u[0]), dv1 = _mm_sub_ps(v[1], v[0]);
+                __m128 du2 = _mm_sub_ps(u[2], u[0]), dv2 = _mm_sub_ps(v[2], v[0]);
+                // Twice the signed uv area: its sign is the face's uv
+                // orientation, and faces with none add nothing.
+                __m128 area = _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(du2, dv1));
+                __m128 orientation = _mm_sub_ps(_mm_and_ps(_mm_cmpgt_ps(area, zero), _mm_set1_ps(1.0f)), _mm_and_ps(_mm_cmplt_ps(area, zero), _mm_set1_ps(1.0f)));
+                Lane3 tangent = (e1 * dv2 - e2 * dv1) * orientation;
+
+                for (size_t c = 0; c < 3; ++c) {
+                    Lane3 projected = tangent - n[c] * Dot(n[c], tangent);
+                    __m128 length = Length(projected);
+                    __m128 weight = _mm_and_ps(_mm_cmpgt_ps(length, _mm_set1_ps(1e-20f)), _mm_div_ps(angles[c], length));
+                    Scatter(projected * weight, _mm_mul_ps(orientation, angles[c]), lanes, &corners[t * 3 + c]);
+                }
+            }
+        });
+
+        Adjacency around{ corners.size(), vertices.size(), [&](size_t corner) { return triangles[corner]; } };
+
+        Parallel(vertices.size(), threads, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) {
+                // Sums for faces of each orientation; w collects their weight.
+                Vector4 preserving{ 0.0f }, reversing{ 0.0f };
+                for (Uint at = around.offsets[v]; at < around.offsets[v + 1]; ++at) {
+                    const Vector4& corner = corners[around.corners[at]];
+                    if (corner.w > 0.0f) { preserving += corner; }
+                    else if (corner.w < 0.0f) { reversing += Vector4{ Vector3{ corner }, -corner.w }; }
+                }
+                Vertex& vertex = vertices[v];
+                bool reversed = reversing.w > preserving.w;
+                Vector3 sum{ reversed ? reversing : preserving };
+                Float length = glm::length(sum);
+                if (length > 0.0f) { vertex.tangent = Vector4{ sum / length, reversed ? -1.0f : 1.0f }; }
+                else if (vertex.normal != Vector3{ 0.0f }) { vertex.tangent = Vector4{ Perpendicular(vertex.normal), 1.0f }; }
+                else { vertex.tangent = Vector4{ 1.0f, 0.0f, 0.0f, 1.0f }; }
+            }
+        });
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_TANGENTSPACE
+#define OPENGL_WRAPPER_TANGENTSPACE
+
+#include <vector>
+
+#include "OpenGL.h"
+#include "Vertex.h"
+
+namespace gl {
+    // Both work on a triangle list, a batch of triangles per SSE step, and
+    // split the faces between threads; threads == 0 uses one per hardware
+    // thread.
+
+    // Gives every vertex whose normal is zero the average of the faces
+    // around it, weighted by face area and corner angle. Vertices with
+    // the same entry in positions are smoothed together, so uv seams do not
+    // show; if positions is empty, each vertex stands alone.
+    void GenerateNormals(std::vector<Vertex>& vertices, const std::vector<Uint>& triangles, const std::vector<Uint>& positions, unsigned threads = 0);
+
+    // Fills in tangents the way MikkTSpace does: each face's uv tangent is
+    // projected onto the vertex normal and weighted by corner angle, and
+    // tangent.w holds the bitangent sign, bitangent = w * cross(normal,
+    // tangent). Faces of the minority uv orientation around a vertex are
+    // left out rather than splitting it. Normals must already be set.
+    void GenerateTangents(std::vector<Vertex>& vertices, const std::vector<Uint>& triangles, unsigned threads = 0);
+}
+
+#endif
@@ -7,9 +7,74 @@
 //
 
 #include "Texture.h"
-#include "glm/gtc/type_ptr.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
 
 namespace gl {
+    namespace {
+        struct PixelFormat {
+            GLenum linear, srgb, external;
+        };
+
+        // By channel count. Core GL has no one or two channel sRGB formats,
+        // so those stay linear.
+        const PixelFormat formats[] = {
+            { GL_R8, GL_R8, GL_RED },
+            { GL_RG8, GL_RG8, GL_RG },
+            { GL_RGB8, GL_SRGB8, GL_RGB },
+            { GL_RGBA8, GL_SRGB8_ALPHA8, GL_RGBA },
+        };
+
+        // Immutable storage arrived in GL 4.2; before that every level is
+        // specified alike, which leaves the texture just as complete.
+        bool ImmutableStorage()
+        {
+#ifdef __APPLE__
+            return false;
+#else
+            return GLEW_VERSION_4_2 || GLEW_ARB_texture_storage;
+#endif
+        }
+
+        // How GL is to step through an image's rows.
+        struct Layout {
+            Int alignment, rowLength;
+        };
+
+        // GL pads rows to the unpack alignment, 4 bytes by default, which
+        // packed RGB rows of odd width do not follow. Use the largest one
+        // the pitch allows, and give a pitch it cannot express in texels.
+        Layout Arrange(const Texture::Image& image)
+        {
+            if (image.channels < 1 || image.channels > 4) { throw invalid_argument{ "Textures take 1 to 4 channels" }; }
+            size_t rowBytes = static_cast<size_t>(image.width) * image.channels;
+            size_t pitch = image.pitch ? image.pitch : rowBytes;
+            if (pitch < rowBytes) { throw invalid_argument{ "Texture rows overlap" }; }
+
+            Layout layout{ 8, 0 };
+            while (pitch % layout.alignment) { layout.alignment >>= 1; }
+            if (pitch != (rowBytes + layout.alignment - 1) / layout.alignment * layout.alignment) {
+                if (pitch % image.channels) { throw invalid_argument{ "Texture rows must be a whole number of texels apart" }; }
+                layout.rowLength = static_cast<Int>(pitch / image.channels);
+            }
+            return layout;
+        }
+
+        // Sends image to the bound texture.
+        void Unpack(const Texture::Image& image, Layout layout, Int x, Int y, Int level)
+        {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, layout.alignment);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, layout.rowLength);
+            glTexSubImage2D(GL_TEXTURE_2D, level, x, y, image.width, image.height, formats[image.channels - 1].external, GL_UNSIGNED_BYTE, image.pixels);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        }
+    }
+
     template<>
     Name<Texture>::Name() 
 	{
@@ -21,7 +86,80 @@ namespace gl {
 	{
         if (_name) { glDeleteTextures(1, &_name); }
     }
-    
+
+    Texture& Texture::Load(const Image& image, Encoding encoding, bool mipmaps)
+    {
+        if (image.width <= 0 || image.height <= 0 || !image.pixels) { throw invalid_argument{ "Texture image is empty" }; }
+        Layout layout = Arrange(image);
+
+        Size levels = mipmaps ? Levels(image.width, image.height) : 1;
+        Allocate(image.width, image.height, image.channels, encoding, levels);
+        Unpack(image, layout, 0, 0, 0);
+
+        if (levels > 1) { glGenerateMipmap(GL_TEXTURE_2D); }
+        return *this;
+    }
+
+    Texture& Texture::Load(const vector<Image>& levels, Encoding encoding)
+    {
+        if (levels.empty() || levels[0].width <= 0 || levels[0].height <= 0) { throw invalid_argument{ "Texture image is empty" }; }
+        const Image& base = levels[0];
+        if (levels.size() > static_cast<size_t>(Levels(base.width, base.height))) { throw invalid_argument{ "Texture has more levels than its size allows" }; }
+
+        vector<Layout> layouts;
+        for (size_t level = 0; level < levels.size(); ++level) {
+            const Image& image = levels[level];
+            if (image.width != max(base.width >> level, 1) || image.height != max(base.height >> level, 1) || image.channels != base.channels || !image.pixels) {
+                throw invalid_argument{ "Texture level " + to_string(level) + " does not match the level above" };
+            }
+            layouts.push_back(Arrange(image));
+        }
+
+        Allocate(base.width, base.height, base.channels, encoding, static_cast<Size>(levels.size()));
+        for (size_t level = 0; level < levels.size(); ++level) {
+            Unpack(levels[level], layouts[level], 0, 0, static_cast<Int>(level));
+        }
+        return *this;
+    }
+
+    void Texture::Allocate(Size width, Size height, Int channels, Encoding encoding, Size levels)
+    {
+        const PixelFormat& format = formats[channels - 1];
+        GLenum internal = encoding == Encoding::Srgb ? format.srgb : format.linear;
+
+        Activate();
+        if (ImmutableStorage()) {
+            // Storage is fixed once allocated, so reloading takes a new name.
+            Int immutable = GL_FALSE;
+            glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_IMMUTABLE_FORMAT, &immutable);
+            if (immutable) {
+                Texture fresh;
+                swap(fresh);
+                Activate();
+            }
+            glTexStorage2D(GL_TEXTURE_2D, levels, internal, width, height);
+        }
+        else {
+            for (Size level = 0; level < levels; ++level) {
+                glTexImage2D(GL_TEXTURE_2D, level, internal, max(width >> level, 1), max(height >> level, 1), 0, format.external, GL_UNSIGNED_BYTE, nullptr);
+            }
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+        // Pixel pointers are client memory, not offsets into a bound buffer.
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    Texture& Texture::Update(const Image& image, Int x, Int y, Int level)
+    {
+        Layout layout = Arrange(image);
+        if (image.width <= 0 || image.height <= 0) { return *this; }
+        Activate();
+        Unpack(image, layout, x, y, level);
+        return *this;
+    }
+
     GLint Texture::Activate(GLint index) const 
 	{
         glActiveTexture(index + GL_TEXTURE0);
@@ -38,7 +176,8 @@ namespace gl {
 
 	void Texture::init()
 	{
+		const Ubyte white[] = { 255, 255, 255, 255 };
 		glBindTexture(GL_TEXTURE_2D, 0);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_FLOAT, glm::value_ptr(glm::vec4{ 1.0f }));
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
 	}
 }
@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include <cstddef>
+#include <vector>
+
 #include "OpenGL.h"
 
 namespace gl {
@@ -19,18 +22,61 @@ namespace gl {
             using Index = Int;
         };
 
+        // How texel values are read: as stored, or as sRGB color that
+        // sampling converts to linear.
+        enum struct Encoding { Linear, Srgb };
+
+        // Rows of 8 bit texels with 1 to 4 channels, bottom row first.
+        struct Image {
+            Size width, height;
+            Int channels;
+            const Ubyte* pixels;
+            // Bytes from the start of one row to the next; 0 when packed.
+            std::size_t pitch;
+        };
+
         Texture() = default;
         
         template<typename T>
-        Texture(const T& source) : Texture{} { Load(source); }
+        Texture(const T& source, Encoding encoding = Encoding::Linear) : Texture{} { Load(source, encoding); }
         
+        // Allocates sized storage for the whole mip chain, uploads image
+        // to the first level and generates the rest. Replaces whatever the
+        // texture held before.
+        Texture& Load(const Image& image, Encoding encoding = Encoding::Linear, bool mipmaps = true);
+        // Allocates just as many levels as given and uploads each as is,
+        // such as a chain the cooker filtered. Each level is half the size
+        // of the one above, rounded down.
+        Texture& Load(const std::vector<Image>& levels, Encoding encoding = Encoding::Linear);
+
+        // Overwrites the region of level at (x, y) that image covers. With
+        // a pixel unpack buffer bound, pixels is an offset into it.
+        Texture& Update(const Image& image, Int x, Int y, Int level = 0);
+
+        // Any bitmap with width, height, BitsPerPixel and pixels members,
+        // such as lynda::Bitmap.
         template <typename T>
-        Texture& Load(const T& source);
-        
+        Texture& Load(const T& source, Encoding encoding = Encoding::Linear)
+        {
+            return Load(Image{ source.width, source.height, source.BitsPerPixel / 8, source.pixels.data(), 0 }, encoding);
+        }
+
+        // Mip levels down to 1x1 for an image of this size. Inline, so the
+        // cooker's file formats can check against it without GL.
+        static Size Levels(Size width, Size height)
+        {
+            Size levels = 1;
+            for (Size extent = width > height ? width : height; extent > 1; extent >>= 1) { ++levels; }
+            return levels;
+        }
+
         Unit::Index Activate(Unit::Index index = 0) const;
         
         static Unit::Index Deactivate(Unit::Index index = 0);
 
 		static void init();
+    private:
+        // Sized storage for levels levels, bound and ready for Unpack.
+        void Allocate(Size width, Size height, Int channels, Encoding encoding, Size levels);
     };
 }
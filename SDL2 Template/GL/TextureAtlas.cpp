@@ -0,0 +1,71 @@
+#include "TextureAtlas.h"
+
+#include <filesystem>
+#include <stdexcept>
+
+#include "../IO/MappedFile.h"
+using namespace std;
+
+namespace gl {
+    namespace {
+        // Names and map_Kd paths are compared as written, less any ./ or
+        // doubled separators.
+        string Key(const string& name)
+        {
+            return filesystem::u8path(name).lexically_normal().generic_u8string();
+        }
+    }
+
+    TextureAtlas::TextureAtlas(const vector<string>& names, const vector<Texture::Image>& images, const AtlasSettings& settings, Texture::Encoding encoding)
+    :   _layout{ PackAtlas(images, settings) }
+    {
+        if (names.size() != images.size()) { throw invalid_argument{ "Every atlas image needs a name" }; }
+        vector<Ubyte> pixels = ComposeAtlas(images, _layout);
+        // Box filtered, as the cooker does, since a wider filter would
+        // reach across the gutters.
+        vector<lynda::MipLevel> chain = lynda::mipChain(pixels.data(), _layout.width, _layout.height, _layout.channels,
+            encoding == Texture::Encoding::Srgb, lynda::MipFilter::Box, _layout.levels);
+        vector<Texture::Image> levels{ Texture::Image{ _layout.width, _layout.height, _layout.channels, pixels.data(), 0 } };
+        for (const lynda::MipLevel& level : chain) {
+            levels.push_back(Texture::Image{ level.width, level.height, _layout.channels, level.texels.data(), 0 });
+        }
+        Upload(levels, names, encoding);
+    }
+
+    TextureAtlas::TextureAtlas(const string& filename)
+    {
+        io::MappedFile file{ filename };
+        AtlasFile cooked{ file };
+        _layout = cooked.layout();
+        Upload(cooked.levels(), cooked.names(), cooked.encoding());
+    }
+
+    void TextureAtlas::Upload(const vector<Texture::Image>& levels, const vector<string>& names, Texture::Encoding encoding)
+    {
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (!_names.emplace(Key(names[i]), i).second) { throw invalid_argument{ "Atlas has two images named " + names[i] }; }
+        }
+        // Only the levels the gutters cover are allocated, so none past
+        // them can blend neighbours.
+        _texture.Load(levels, encoding);
+    }
+
+    const AtlasRegion* TextureAtlas::Find(const string& name) const
+    {
+        auto found = _names.find(Key(name));
+        return found == _names.end() ? nullptr : &_layout.regions[found->second];
+    }
+
+    size_t TextureAtlas::Remap(vector<Material>& materials) const
+    {
+        size_t count = 0;
+        for (Material& material : materials) {
+            if (material.diffuseMap.empty()) { continue; }
+            if (const AtlasRegion* region = Find(material.diffuseMap)) {
+                material.diffuseRegion = region->bounds();
+                ++count;
+            }
+        }
+        return count;
+    }
+}
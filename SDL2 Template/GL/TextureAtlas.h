@@ -0,0 +1,50 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_TEXTUREATLAS
+#define OPENGL_WRAPPER_TEXTUREATLAS
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "OpenGL.h"
+#include "Atlas.h"
+#include "Material.h"
+#include "Texture.h"
+
+namespace gl {
+    // Many small images in one texture, so the surfaces and sprites drawing
+    // them share one bind and can share one draw. Each image is found by
+    // name and drawn through its region's uv area.
+    class TextureAtlas {
+    public:
+        // Packs and uploads images now, such as ones made at run time.
+        TextureAtlas(const std::vector<std::string>& names, const std::vector<Texture::Image>& images,
+            const AtlasSettings& settings = {}, Texture::Encoding encoding = Texture::Encoding::Linear);
+        // Loads an atlas the cooker built, with the encoding and mip levels
+        // it was cooked with.
+        explicit TextureAtlas(const std::string& filename);
+
+        // Null when no image has that name.
+        const AtlasRegion* Find(const std::string& name) const;
+        // Gives every material whose diffuse map is in the atlas that map's
+        // region, so it draws from the atlas once bound. Meshes take this
+        // through their Source's materials before they are built. Returns
+        // how many matched.
+        std::size_t Remap(std::vector<Material>& materials) const;
+
+        Texture::Unit::Index Activate(Texture::Unit::Index index = 0) const { return _texture.Activate(index); }
+
+        const Texture& texture() const { return _texture; }
+        const AtlasLayout& layout() const { return _layout; }
+    private:
+        Texture _texture;
+        AtlasLayout _layout;
+        std::unordered_map<std::string, std::size_t> _names;
+
+        void Upload(const std::vector<Texture::Image>& levels, const std::vector<std::string>& names, Texture::Encoding encoding);
+    };
+}
+
+#endif
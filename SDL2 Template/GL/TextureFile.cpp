@@ -0,0 +1,111 @@
+#include "TextureFile.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+using namespace std;
+
+namespace {
+    size_t Align(size_t offset)
+    {
+        return (offset + gl::TextureFile::Alignment - 1) & ~(gl::TextureFile::Alignment - 1);
+    }
+}
+
+namespace gl {
+    static_assert(is_standard_layout<TextureFile::Header>::value && sizeof(TextureFile::Header) == 40, "cooked texture header layout changed");
+    static_assert(is_standard_layout<TextureFile::Level>::value && sizeof(TextureFile::Level) == 16, "cooked texture level layout changed");
+
+    bool TextureFile::Identify(const io::MappedFile& source)
+    {
+        return source.size() >= sizeof(Uint) && *reinterpret_cast<const Uint*>(source.data()) == Signature;
+    }
+
+    TextureFile::TextureFile(const io::MappedFile& source)
+    :   _base{ source.data() }, _header{ reinterpret_cast<const Header*>(source.data()) }
+    {
+        if (source.size() < sizeof(Header) || _header->signature != Signature) { throw invalid_argument{ "Not a cooked texture" }; }
+        if (_header->version != Version) { throw invalid_argument{ "Unsupported cooked texture version " + to_string(_header->version) }; }
+        if (_header->width <= 0 || _header->height <= 0 || _header->channels < 1 || _header->channels > 4
+            || _header->encoding > static_cast<Uint>(Texture::Encoding::Srgb)
+            || _header->levelCount < 1 || _header->levelCount > static_cast<Uint>(Texture::Levels(_header->width, _header->height))) {
+            throw invalid_argument{ "Cooked texture has an invalid size" };
+        }
+
+        auto fits = [&](uint64_t offset, uint64_t bytes) {
+            return offset % Alignment == 0 && offset <= source.size() && bytes <= source.size() - offset;
+        };
+        if (!fits(_header->levelOffset, uint64_t{ _header->levelCount } * sizeof(Level))) { throw invalid_argument{ "Cooked texture is truncated" }; }
+        auto records = reinterpret_cast<const Level*>(_base + _header->levelOffset);
+        for (Uint l = 0; l < _header->levelCount; ++l) {
+            const Level& record = records[l];
+            if (record.width != max(_header->width >> l, 1) || record.height != max(_header->height >> l, 1)) {
+                throw invalid_argument{ "Cooked texture level " + to_string(l) + " has the wrong size" };
+            }
+            if (!fits(record.offset, uint64_t{ static_cast<Uint>(record.width) } * static_cast<Uint>(record.height) * static_cast<Uint>(_header->channels))) {
+                throw invalid_argument{ "Cooked texture is truncated" };
+            }
+        }
+    }
+
+    vector<Texture::Image> TextureFile::levels() const
+    {
+        auto records = reinterpret_cast<const Level*>(_base + _header->levelOffset);
+        vector<Texture::Image> result;
+        result.reserve(_header->levelCount);
+        for (Uint l = 0; l < _header->levelCount; ++l) {
+            result.push_back(Texture::Image{ records[l].width, records[l].height, _header->channels, reinterpret_cast<const Ubyte*>(_base + records[l].offset), 0 });
+        }
+        return result;
+    }
+
+    void TextureFile::Cook(const Texture::Image& image, Texture::Encoding encoding, lynda::MipFilter filter, const string& destination, unsigned threads)
+    {
+        if (image.width <= 0 || image.height <= 0 || !image.pixels) { throw invalid_argument{ "Texture image is empty" }; }
+        vector<lynda::MipLevel> chain = lynda::mipChain(image.pixels, image.width, image.height, image.channels,
+            encoding == Texture::Encoding::Srgb, filter, 0, image.pitch, threads);
+
+        Header header{};
+        header.signature = Signature;
+        header.version = Version;
+        header.width = image.width;
+        header.height = image.height;
+        header.channels = image.channels;
+        header.encoding = static_cast<Uint>(encoding);
+        header.filter = static_cast<Uint>(filter);
+        header.levelCount = static_cast<Uint>(chain.size() + 1);
+        header.levelOffset = Align(sizeof(Header));
+
+        vector<Level> records;
+        uint64_t offset = Align(header.levelOffset + header.levelCount * sizeof(Level));
+        records.push_back(Level{ image.width, image.height, offset });
+        offset = Align(offset + static_cast<size_t>(image.width) * image.height * image.channels);
+        for (const lynda::MipLevel& level : chain) {
+            records.push_back(Level{ level.width, level.height, offset });
+            offset = Align(offset + level.texels.size());
+        }
+
+        ofstream out{ destination, ios::binary | ios::trunc };
+        if (!out) { throw runtime_error{ "Failed to create file: " + destination }; }
+
+        auto pad = [&out](uint64_t offset) {
+            static const char zeros[Alignment] = {};
+            out.write(zeros, static_cast<streamsize>(offset - static_cast<uint64_t>(out.tellp())));
+        };
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        pad(header.levelOffset);
+        out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Level));
+        // The first level is the image, repacked if its rows were padded.
+        pad(records[0].offset);
+        size_t rowBytes = static_cast<size_t>(image.width) * image.channels;
+        for (Size row = 0; row < image.height; ++row) {
+            out.write(reinterpret_cast<const char*>(image.pixels + row * (image.pitch ? image.pitch : rowBytes)), rowBytes);
+        }
+        for (size_t l = 0; l < chain.size(); ++l) {
+            pad(records[l + 1].offset);
+            out.write(reinterpret_cast<const char*>(chain[l].texels.data()), chain[l].texels.size());
+        }
+        if (!out) { throw runtime_error{ "Failed to write file: " + destination }; }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_TEXTUREFILE
+#define OPENGL_WRAPPER_TEXTUREFILE
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "OpenGL.h"
+#include "Texture.h"
+#include "../IO/MappedFile.h"
+#include "../../Math/include/gl_mipmap.hpp"
+
+namespace gl {
+    // Cooked texture: an image with its whole mip chain filtered ahead of
+    // time, so loading one is only an upload:
+    //     texture.Load(cooked.levels(), cooked.encoding());
+    // A Header is followed by the Level table and each level's packed
+    // texels, each starting on a 16-byte boundary. Values are stored in the
+    // byte order of the machine that cooked them.
+    class TextureFile {
+    public:
+        static constexpr Uint Signature = 0x58455447; // "GTEX"
+        static constexpr Uint Version = 1;
+        static constexpr std::size_t Alignment = 16;
+
+        struct Header {
+            Uint signature;
+            Uint version;
+            Size width;
+            Size height;
+            Int channels;
+            // A Texture::Encoding.
+            Uint encoding;
+            // The lynda::MipFilter the levels below the first were made with.
+            Uint filter;
+            Uint levelCount;
+            std::uint64_t levelOffset;
+        };
+        struct Level {
+            Size width, height;
+            std::uint64_t offset;
+        };
+
+        // Views a mapped cooked texture; throws if the contents are not one.
+        explicit TextureFile(const io::MappedFile& source);
+
+        static bool Identify(const io::MappedFile& source);
+
+        // Filters image's mip chain with lynda::mipChain, in linear light
+        // when encoding is Srgb, and writes it. threads is as mipChain
+        // takes it.
+        static void Cook(const Texture::Image& image, Texture::Encoding encoding, lynda::MipFilter filter, const std::string& destination, unsigned threads = 0);
+
+        const Header& header() const { return *_header; }
+        Texture::Encoding encoding() const { return static_cast<Texture::Encoding>(_header->encoding); }
+        // Full size first; the pixels point into the mapping.
+        std::vector<Texture::Image> levels() const;
+    private:
+        const char* _base;
+        const Header* _header;
+    };
+}
+
+#endif
@@ -0,0 +1,107 @@
+#include "TextureStream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+using namespace std;
+
+namespace gl {
+    TextureStream::TextureStream(size_t slotBytes, size_t slots)
+    :   _slotBytes{ slotBytes }, _slots(max<size_t>(slots, 1)), _next{ 0 }
+    {
+        for (Slot& slot : _slots) { slot.buffer.Reserve(PixelUnpackBuffer::StreamDraw, _slotBytes); }
+        PixelUnpackBuffer::Deactivate();
+    }
+
+    TextureStream::~TextureStream()
+    {
+        for (Slot& slot : _slots) {
+            if (slot.fence) { glDeleteSync(slot.fence); }
+        }
+    }
+
+    size_t TextureStream::Pitch(Size width, Int channels)
+    {
+        return (static_cast<size_t>(width) * channels + 3) / 4 * 4;
+    }
+
+    TextureStream::Staging TextureStream::Map(Size width, Size height, Int channels)
+    {
+        if (channels < 1 || channels > 4) { throw invalid_argument{ "Textures take 1 to 4 channels" }; }
+        size_t pitch = Pitch(width, channels);
+        if (pitch * height > _slotBytes) { throw length_error{ "Texture region is larger than a stream slot" }; }
+
+        // Slots are reused in order, so only the oldest needs checking.
+        Slot& slot = _slots[_next];
+        if (slot.mapped) { return Staging{}; }
+        if (slot.fence) {
+            switch (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0)) {
+            case GL_TIMEOUT_EXPIRED: return Staging{};
+            case GL_WAIT_FAILED: throw runtime_error{ "Failed to check a texture stream fence" };
+            }
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+
+        // The fence has passed, so the driver need not synchronize again;
+        // invalidating lets it drop the old contents.
+        slot.buffer.Activate();
+        void* data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, _slotBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        PixelUnpackBuffer::Deactivate();
+        if (!data) { throw runtime_error{ "Failed to map a texture stream slot" }; }
+
+        Staging staging;
+        staging.data = static_cast<Ubyte*>(data);
+        staging.pitch = pitch;
+        staging.width = width;
+        staging.height = height;
+        staging.channels = channels;
+        staging._slot = _next;
+        slot.mapped = true;
+        _next = (_next + 1) % _slots.size();
+        return staging;
+    }
+
+    void TextureStream::Submit(Staging& staging, Texture& texture, Int x, Int y, Int level)
+    {
+        if (!staging) { throw invalid_argument{ "Submitted an empty texture staging" }; }
+        Slot& slot = _slots[staging._slot];
+        slot.buffer.Activate();
+        bool intact = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+        slot.mapped = false;
+        staging.data = nullptr;
+        if (intact) {
+            // With the buffer bound, the image's pixels are an offset into it.
+            texture.Update(Texture::Image{ staging.width, staging.height, staging.channels, nullptr, staging.pitch }, x, y, level);
+            slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        PixelUnpackBuffer::Deactivate();
+        // Rare, as when the display mode changes while mapped.
+        if (!intact) { throw runtime_error{ "Texture stream slot was lost while mapped" }; }
+    }
+
+    Size TextureStream::Upload(Texture& texture, const Texture::Image& image, Int x, Int y, Int level, Size row)
+    {
+        size_t rowBytes = static_cast<size_t>(image.width) * image.channels;
+        size_t pitch = image.pitch ? image.pitch : rowBytes;
+        size_t band = _slotBytes / max<size_t>(Pitch(image.width, image.channels), 1);
+        if (!band) { throw length_error{ "Texture rows are wider than a stream slot" }; }
+
+        while (row < image.height) {
+            Size rows = static_cast<Size>(min<size_t>(band, image.height - row));
+            Staging staging = Map(image.width, rows, image.channels);
+            if (!staging) { break; }
+            for (Size r = 0; r < rows; ++r) {
+                memcpy(staging.data + r * staging.pitch, image.pixels + (row + r) * pitch, rowBytes);
+            }
+            Submit(staging, texture, x, y + row, level);
+            row += rows;
+        }
+        return row;
+    }
+
+    size_t TextureStream::busy() const
+    {
+        return count_if(_slots.begin(), _slots.end(), [](const Slot& slot) { return slot.mapped || slot.fence; });
+    }
+}
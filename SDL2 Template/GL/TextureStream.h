@@ -0,0 +1,75 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_TEXTURESTREAM
+#define OPENGL_WRAPPER_TEXTURESTREAM
+
+#include <cstddef>
+#include <vector>
+
+#include "Buffer.h"
+#include "Texture.h"
+
+namespace gl {
+    // Texture uploads that never wait on the GL. Texels are written into
+    // one of a ring of pixel unpack buffers and the texture is updated
+    // from there, so the driver neither copies client memory nor stalls
+    // the render thread on the transfer. A fence per slot keeps a slot
+    // from being rewritten until the GPU has read it; when the next slot
+    // is still in flight the stream says so rather than blocking, and the
+    // caller tries again next frame. Use from the GL thread, except for
+    // writing into a mapped slot, which may happen anywhere.
+    class TextureStream {
+    public:
+        // A mapped slot awaiting height rows of width texels, pitch bytes
+        // apart. Empty when no slot was free.
+        class Staging {
+        public:
+            Staging() : data{ nullptr }, pitch{ 0 }, width{ 0 }, height{ 0 }, channels{ 0 }, _slot{ 0 } {}
+            explicit operator bool() const { return data != nullptr; }
+
+            Ubyte* data;
+            std::size_t pitch;
+            Size width, height;
+            Int channels;
+        private:
+            friend class TextureStream;
+            std::size_t _slot;
+        };
+
+        explicit TextureStream(std::size_t slotBytes = 4 << 20, std::size_t slots = 3);
+        ~TextureStream();
+
+        TextureStream(const TextureStream&) = delete;
+        TextureStream& operator= (const TextureStream&) = delete;
+
+        // Maps the next slot for a width x height region, which must fit in
+        // one. Several slots may be mapped at once.
+        Staging Map(Size width, Size height, Int channels);
+        // Unmaps staging and updates level of texture at (x, y) from it.
+        // The slot rejoins the ring once the GPU has read it.
+        void Submit(Staging& staging, Texture& texture, Int x, Int y, Int level = 0);
+
+        // Copies image into texture at (x, y) in bands of rows, one per
+        // slot, starting at row and stopping when no slot is free. Returns
+        // the row to resume from, which is image.height once all is sent.
+        Size Upload(Texture& texture, const Texture::Image& image, Int x, Int y, Int level = 0, Size row = 0);
+
+        // Slots mapped or not yet known to be read by the GPU.
+        std::size_t busy() const;
+        std::size_t slotBytes() const { return _slotBytes; }
+    private:
+        struct Slot {
+            PixelUnpackBuffer buffer;
+            GLsync fence = nullptr;
+            bool mapped = false;
+        };
+
+        std::size_t _slotBytes;
+        std::vector<Slot> _slots;
+        std::size_t _next;
+
+        static std::size_t Pitch(Size width, Int channels);
+    };
+}
+
+#endif
@@ -18,6 +18,12 @@
 
 namespace gl {
     struct Vertex {
+        Point3 position;
+        Vector3 normal;
+        Vector2 uv;
+        // xyz along +u, w the bitangent sign: bitangent = w * cross(normal, tangent).
+        Vector4 tangent;
+
         class Array: public Name<Vertex::Array> {
         public:
             Array() = default;
@@ -64,7 +70,7 @@ namespace gl {
                     contents, 
                     channel, 
                     std::is_array<Element>::value ? std::extent<Element, 0>::value : 1,
-                    TypeSignal<std::remove_extent<Element>::type>,
+                    TypeSignal<typename std::remove_extent<Element>::type>,
                     normalized,
                     sizeof(Container), 
                     inset 
@@ -74,6 +80,14 @@ namespace gl {
                 ArrayAttribute(channel, contents, GL_FALSE, inset)
             {}
         };
+
+        // An attribute whose element type is only known at run time, such
+        // as one read from a glTF accessor.
+        struct Attribute : public BufferAttribute {
+            Attribute(Int channel, ArrayBuffer& contents, Uint count, TypeCode type, Bool normalized, Size stride, Size inset = 0) :
+                BufferAttribute{ contents, channel, count, type, normalized, stride, inset }
+            {}
+        };
         
     };
 
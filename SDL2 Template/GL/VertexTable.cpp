@@ -0,0 +1,60 @@
+#include "VertexTable.h"
+
+#include <cstdint>
+using namespace std;
+
+namespace gl {
+    namespace obj {
+        VertexTable::VertexTable(size_t expected)
+            : mask{ 0 }, used{ 0 }
+        {
+            Reserve(expected);
+        }
+
+        size_t VertexTable::Hash(const Index& id)
+        {
+            // Pack the triple into 64 bits and finish with the murmur3 mixer.
+            uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(id.p)) << 32 | static_cast<uint32_t>(id.t))
+                ^ static_cast<uint64_t>(static_cast<uint32_t>(id.n)) * 0x9E3779B97F4A7C15ull;
+            key ^= key >> 33;
+            key *= 0xFF51AFD7ED558CCDull;
+            key ^= key >> 33;
+            key *= 0xC4CEB9FE1A85EC53ull;
+            key ^= key >> 33;
+            return static_cast<size_t>(key);
+        }
+
+        void VertexTable::Reserve(size_t count)
+        {
+            // Keep the load factor at or below one half.
+            size_t capacity = 16;
+            while (capacity < count * 2) { capacity <<= 1; }
+            if (capacity <= slots.size()) { return; }
+
+            vector<Slot> previous(capacity, Slot{ Index{ -1, -1, -1 }, empty });
+            previous.swap(slots);
+            mask = capacity - 1;
+            for (const Slot& slot : previous) {
+                if (slot.value == empty) { continue; }
+                size_t at = Hash(slot.key) & mask;
+                while (slots[at].value != empty) { at = (at + 1) & mask; }
+                slots[at] = slot;
+            }
+        }
+
+        pair<Uint, bool> VertexTable::Insert(const Index& id, Uint next)
+        {
+            if ((used + 1) * 2 > slots.size()) { Reserve(used + 1); }
+
+            for (size_t at = Hash(id) & mask; ; at = (at + 1) & mask) {
+                Slot& slot = slots[at];
+                if (slot.value == empty) {
+                    slot = Slot{ id, next };
+                    ++used;
+                    return { next, true };
+                }
+                if (slot.key == id) { return { slot.value, false }; }
+            }
+        }
+    }
+}
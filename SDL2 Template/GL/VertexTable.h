@@ -0,0 +1,49 @@
+#pragma once
+
+#ifndef OPENGL_WRAPPER_VERTEXTABLE
+#define OPENGL_WRAPPER_VERTEXTABLE
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "OpenGL.h"
+
+namespace gl {
+    namespace obj {
+        // The v, vt and vn elements one OBJ face corner refers to, negative
+        // where the corner has none.
+        struct Index {
+            Int p, t, n;
+
+            bool operator==(const Index& other) const
+            {
+                return p == other.p && t == other.t && n == other.n;
+            }
+        };
+
+        // Maps a corner's (p, t, n) triple to the vertex built for it. Slots
+        // are stored flat and probed linearly, so a lookup never allocates.
+        class VertexTable {
+        public:
+            explicit VertexTable(std::size_t expected);
+            // Returns the vertex already recorded for id, or records next.
+            std::pair<Uint, bool> Insert(const Index& id, Uint next);
+        private:
+            struct Slot {
+                Index key;
+                Uint value;
+            };
+            static constexpr Uint empty = ~Uint{ 0 };
+
+            std::vector<Slot> slots;
+            std::size_t mask;
+            std::size_t used;
+
+            static std::size_t Hash(const Index& id);
+            void Reserve(std::size_t count);
+        };
+    }
+}
+
+#endif
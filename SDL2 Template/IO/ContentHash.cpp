@@ -0,0 +1,78 @@
+#include "ContentHash.h"
+
+#include <cstring>
+
+namespace {
+    constexpr std::uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+    constexpr std::uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr std::uint64_t Prime3 = 0x165667B19E3779F9ull;
+    constexpr std::uint64_t Prime4 = 0x85EBCA77C2B2AE63ull;
+    constexpr std::uint64_t Prime5 = 0x27D4EB2F165667C5ull;
+
+    inline std::uint64_t Rotate(std::uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    // Unaligned little-endian reads; every supported target is little-endian.
+    inline std::uint64_t Read64(const unsigned char* at)
+    {
+        std::uint64_t value;
+        std::memcpy(&value, at, sizeof(value));
+        return value;
+    }
+
+    inline std::uint32_t Read32(const unsigned char* at)
+    {
+        std::uint32_t value;
+        std::memcpy(&value, at, sizeof(value));
+        return value;
+    }
+
+    inline std::uint64_t Round(std::uint64_t accumulator, std::uint64_t input)
+    {
+        return Rotate(accumulator + input * Prime2, 31) * Prime1;
+    }
+
+    inline std::uint64_t MergeRound(std::uint64_t accumulator, std::uint64_t lane)
+    {
+        return (accumulator ^ Round(0, lane)) * Prime1 + Prime4;
+    }
+}
+
+namespace io {
+    std::uint64_t ContentHash(const void* data, std::size_t size, std::uint64_t seed)
+    {
+        const auto* at = static_cast<const unsigned char*>(data);
+        const auto* end = at + size;
+        std::uint64_t hash;
+
+        if (size >= 32) {
+            // Four independent lanes keep the multipliers busy.
+            std::uint64_t lane[4] = { seed + Prime1 + Prime2, seed + Prime2, seed, seed - Prime1 };
+            for (; end - at >= 32; at += 32) {
+                for (int i = 0; i < 4; ++i) { lane[i] = Round(lane[i], Read64(at + i * 8)); }
+            }
+            hash = Rotate(lane[0], 1) + Rotate(lane[1], 7) + Rotate(lane[2], 12) + Rotate(lane[3], 18);
+            for (int i = 0; i < 4; ++i) { hash = MergeRound(hash, lane[i]); }
+        }
+        else {
+            hash = seed + Prime5;
+        }
+        hash += size;
+
+        for (; end - at >= 8; at += 8) { hash = Rotate(hash ^ Round(0, Read64(at)), 27) * Prime1 + Prime4; }
+        if (end - at >= 4) {
+            hash = Rotate(hash ^ (Read32(at) * Prime1), 23) * Prime2 + Prime3;
+            at += 4;
+        }
+        for (; at < end; ++at) { hash = Rotate(hash ^ (*at * Prime5), 11) * Prime1; }
+
+        hash ^= hash >> 33;
+        hash *= Prime2;
+        hash ^= hash >> 29;
+        hash *= Prime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#ifndef IO_CONTENT_HASH
+#define IO_CONTENT_HASH
+
+#include <cstddef>
+#include <cstdint>
+
+namespace io {
+    // 64-bit XXH64 digest of a byte range, for recognising identical file
+    // contents. Not cryptographic.
+    std::uint64_t ContentHash(const void* data, std::size_t size, std::uint64_t seed = 0);
+}
+
+#endif
@@ -0,0 +1,305 @@
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <thread>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    std::string Normalize(const std::string& filename)
+    {
+        return fs::absolute(filename).lexically_normal().string();
+    }
+
+    void Add(std::vector<std::string>& changed, const std::string& filename)
+    {
+        if (std::find(changed.begin(), changed.end(), filename) == changed.end()) { changed.push_back(filename); }
+    }
+
+    Clock::time_point Deadline(io::FileWatcher::Timeout timeout)
+    {
+        Clock::time_point now = Clock::now();
+        return timeout >= std::chrono::duration_cast<io::FileWatcher::Timeout>(Clock::time_point::max() - now) ? Clock::time_point::max() : now + timeout;
+    }
+
+    // Milliseconds left until deadline, rounded up so a wait never ends early.
+    long long Remaining(Clock::time_point deadline)
+    {
+        if (deadline == Clock::time_point::max()) { return -1; }
+        auto left = deadline - Clock::now();
+        if (left <= Clock::duration::zero()) { return 0; }
+        return std::chrono::ceil<std::chrono::milliseconds>(left).count();
+    }
+}
+
+namespace io {
+#if defined(_WIN32)
+    struct FileWatcher::Directory {
+        std::string path;
+        HANDLE handle = INVALID_HANDLE_VALUE;
+        OVERLAPPED overlapped{};
+        bool armed = false;
+        DWORD buffer[4096];
+
+        ~Directory()
+        {
+            if (armed) {
+                DWORD bytes;
+                CancelIoEx(handle, &overlapped);
+                GetOverlappedResult(handle, &overlapped, &bytes, TRUE);
+            }
+            if (overlapped.hEvent) { CloseHandle(overlapped.hEvent); }
+            if (handle != INVALID_HANDLE_VALUE) { CloseHandle(handle); }
+        }
+
+        // Starts the next read of changes, which signals overlapped.hEvent.
+        bool Arm()
+        {
+            armed = ReadDirectoryChangesW(
+                handle, buffer, sizeof(buffer), FALSE,
+                FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+                nullptr, &overlapped, nullptr
+            ) != FALSE;
+            return armed;
+        }
+    };
+
+    FileWatcher::FileWatcher()
+    :   _cancelled{ false }, _wake{ CreateEventA(nullptr, FALSE, FALSE, nullptr) }
+    {
+        if (!_wake) { throw std::runtime_error{ "Failed to create file watcher" }; }
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        _directories.clear();
+        CloseHandle(_wake);
+    }
+
+    void FileWatcher::Watch(const std::string& filename)
+    {
+        std::string path = Normalize(filename);
+        std::string directory = fs::path{ path }.parent_path().string();
+
+        std::lock_guard<std::mutex> hold{ _lock };
+        _files[path] = filename;
+        for (auto& watched : _directories) {
+            if (watched->path == directory) { return; }
+        }
+        // One wait handle is the wake event.
+        if (_directories.size() + 1 >= MAXIMUM_WAIT_OBJECTS) { throw std::runtime_error{ "Too many directories to watch: " + directory }; }
+
+        std::unique_ptr<Directory> watched{ new Directory{} };
+        watched->path = directory;
+        watched->handle = CreateFileA(
+            directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr
+        );
+        watched->overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        if (watched->handle == INVALID_HANDLE_VALUE || !watched->overlapped.hEvent || !watched->Arm()) {
+            throw std::runtime_error{ "Failed to watch directory: " + directory };
+        }
+        _directories.push_back(std::move(watched));
+        // A Wait in progress starts over with the new directory.
+        SetEvent(_wake);
+    }
+
+    std::vector<std::string> FileWatcher::Wait(Timeout timeout)
+    {
+        Clock::time_point deadline = Deadline(timeout);
+        std::vector<std::string> changed;
+        while (changed.empty() && !_cancelled) {
+            std::vector<HANDLE> events{ _wake };
+            std::vector<Directory*> directories;
+            {
+                std::lock_guard<std::mutex> hold{ _lock };
+                for (auto& watched : _directories) {
+                    events.push_back(watched->overlapped.hEvent);
+                    directories.push_back(watched.get());
+                }
+            }
+
+            long long remaining = Remaining(deadline);
+            DWORD wait = remaining < 0 ? INFINITE : static_cast<DWORD>(std::min<long long>(remaining, INFINITE - 1));
+            DWORD result = WaitForMultipleObjects(static_cast<DWORD>(events.size()), events.data(), FALSE, wait);
+            if (result == WAIT_TIMEOUT) { break; }
+            if (result == WAIT_OBJECT_0) { continue; }
+            if (result >= WAIT_OBJECT_0 + events.size()) { throw std::runtime_error{ "Failed to wait for file changes" }; }
+
+            Directory& watched = *directories[result - WAIT_OBJECT_0 - 1];
+            DWORD bytes = 0;
+            BOOL read = GetOverlappedResult(watched.handle, &watched.overlapped, &bytes, FALSE);
+
+            std::lock_guard<std::mutex> hold{ _lock };
+            if (!read || !bytes) {
+                // The buffer overflowed, so any file there may have changed.
+                for (auto& file : _files) {
+                    if (fs::path{ file.first }.parent_path().string() == watched.path) { Add(changed, file.second); }
+                }
+            }
+            else {
+                auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(watched.buffer);
+                for (;;) {
+                    if (info->Action != FILE_ACTION_REMOVED && info->Action != FILE_ACTION_RENAMED_OLD_NAME) {
+                        std::wstring name{ info->FileName, info->FileNameLength / sizeof(WCHAR) };
+                        auto found = _files.find((fs::path{ watched.path } / name).lexically_normal().string());
+                        if (found != _files.end()) { Add(changed, found->second); }
+                    }
+                    if (!info->NextEntryOffset) { break; }
+                    info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(reinterpret_cast<const char*>(info) + info->NextEntryOffset);
+                }
+            }
+            if (!watched.Arm()) { throw std::runtime_error{ "Failed to watch directory: " + watched.path }; }
+        }
+        return changed;
+    }
+
+    void FileWatcher::Cancel()
+    {
+        _cancelled = true;
+        SetEvent(_wake);
+    }
+#elif defined(__linux__)
+    FileWatcher::FileWatcher()
+    :   _cancelled{ false }, _queue{ inotify_init1(IN_NONBLOCK | IN_CLOEXEC) }, _wake{ -1, -1 }
+    {
+        if (_queue < 0) { throw std::runtime_error{ "Failed to create file watcher" }; }
+        if (pipe2(_wake, O_NONBLOCK | O_CLOEXEC) < 0) {
+            close(_queue);
+            throw std::runtime_error{ "Failed to create file watcher" };
+        }
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        close(_queue);
+        close(_wake[0]);
+        close(_wake[1]);
+    }
+
+    void FileWatcher::Watch(const std::string& filename)
+    {
+        std::string path = Normalize(filename);
+        std::string directory = fs::path{ path }.parent_path().string();
+
+        std::lock_guard<std::mutex> hold{ _lock };
+        // Watching a directory again returns the descriptor it already has.
+        int watch = inotify_add_watch(_queue, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (watch < 0) { throw std::runtime_error{ "Failed to watch directory: " + directory }; }
+        _directories[watch] = directory;
+        _files[path] = filename;
+    }
+
+    std::vector<std::string> FileWatcher::Wait(Timeout timeout)
+    {
+        Clock::time_point deadline = Deadline(timeout);
+        std::vector<std::string> changed;
+        while (changed.empty() && !_cancelled) {
+            long long remaining = Remaining(deadline);
+            pollfd ready[2] = { { _queue, POLLIN, 0 }, { _wake[0], POLLIN, 0 } };
+            int count = poll(ready, 2, static_cast<int>(std::min<long long>(remaining, INT_MAX)));
+            if (count < 0 && errno != EINTR) { throw std::runtime_error{ "Failed to wait for file changes" }; }
+            if (count == 0) { break; }
+            if (count < 0) { continue; }
+
+            char drain[64];
+            while (read(_wake[0], drain, sizeof(drain)) > 0) {}
+
+            alignas(inotify_event) char buffer[4096];
+            ssize_t size;
+            while ((size = read(_queue, buffer, sizeof(buffer))) > 0) {
+                std::lock_guard<std::mutex> hold{ _lock };
+                for (char* at = buffer; at < buffer + size; ) {
+                    auto event = reinterpret_cast<const inotify_event*>(at);
+                    at += sizeof(inotify_event) + event->len;
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        // Events were lost, so any file may have changed.
+                        for (auto& file : _files) { Add(changed, file.second); }
+                        continue;
+                    }
+                    auto directory = _directories.find(event->wd);
+                    if (!event->len || directory == _directories.end()) { continue; }
+                    auto found = _files.find((fs::path{ directory->second } / event->name).string());
+                    if (found != _files.end()) { Add(changed, found->second); }
+                }
+            }
+        }
+        return changed;
+    }
+
+    void FileWatcher::Cancel()
+    {
+        _cancelled = true;
+        char wake = 0;
+        (void)write(_wake[1], &wake, 1);
+    }
+#else
+    namespace {
+        std::int64_t Stamp(const std::string& path)
+        {
+            std::error_code missing;
+            auto time = fs::last_write_time(path, missing);
+            return missing ? -1 : static_cast<std::int64_t>(time.time_since_epoch().count());
+        }
+    }
+
+    FileWatcher::FileWatcher()
+    :   _cancelled{ false }
+    {}
+
+    FileWatcher::~FileWatcher() = default;
+
+    void FileWatcher::Watch(const std::string& filename)
+    {
+        std::string path = Normalize(filename);
+        std::lock_guard<std::mutex> hold{ _lock };
+        _files[path] = filename;
+        _stamps[path] = Stamp(path);
+    }
+
+    std::vector<std::string> FileWatcher::Wait(Timeout timeout)
+    {
+        constexpr long long interval = 100;
+
+        Clock::time_point deadline = Deadline(timeout);
+        std::vector<std::string> changed;
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> hold{ _lock };
+                for (auto& stamp : _stamps) {
+                    std::int64_t now = Stamp(stamp.first);
+                    if (now == stamp.second) { continue; }
+                    stamp.second = now;
+                    if (now >= 0) { Add(changed, _files[stamp.first]); }
+                }
+            }
+            long long remaining = Remaining(deadline);
+            if (!changed.empty() || _cancelled || !remaining) { return changed; }
+            std::this_thread::sleep_for(std::chrono::milliseconds{ remaining < 0 ? interval : std::min(remaining, interval) });
+        }
+    }
+
+    void FileWatcher::Cancel()
+    {
+        _cancelled = true;
+    }
+#endif
+}
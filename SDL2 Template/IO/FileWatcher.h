@@ -0,0 +1,61 @@
+#pragma once
+
+#ifndef IO_FILE_WATCHER
+#define IO_FILE_WATCHER
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace io {
+    // Reports when files are written. Each file's directory is watched
+    // rather than the file itself, so editors that save by writing a new
+    // file and renaming it over the old one are still seen.
+    class FileWatcher {
+    public:
+        using Timeout = std::chrono::milliseconds;
+
+        FileWatcher();
+        ~FileWatcher();
+
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator= (const FileWatcher&) = delete;
+
+        // Safe from any thread, including while another waits. The file
+        // need not exist yet, but its directory must.
+        void Watch(const std::string& filename);
+
+        // Blocks until a watched file changes, timeout passes or Cancel is
+        // called. Returns each changed file once, spelled as it was given
+        // to Watch; Timeout::max() waits without limit.
+        std::vector<std::string> Wait(Timeout timeout = Timeout::max());
+
+        // Wakes any Wait, and makes every later one return at once.
+        void Cancel();
+    private:
+        std::mutex _lock;
+        std::atomic<bool> _cancelled;
+        // Absolute, normalized path to the name it was watched under.
+        std::unordered_map<std::string, std::string> _files;
+#if defined(_WIN32)
+        struct Directory;
+        std::vector<std::unique_ptr<Directory>> _directories;
+        void* _wake;
+#elif defined(__linux__)
+        // inotify watch descriptor to directory path.
+        std::unordered_map<int, std::string> _directories;
+        int _queue;
+        int _wake[2];
+#else
+        // No change notification here, so the write times are polled.
+        std::unordered_map<std::string, std::int64_t> _stamps;
+#endif
+    };
+}
+
+#endif
@@ -0,0 +1,229 @@
+#include "Json.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace io {
+    namespace {
+        const Json none;
+    }
+
+    class JsonParser {
+    public:
+        JsonParser(const char* begin, const char* end) : _begin{ begin }, _at{ begin }, _end{ end } {}
+
+        Json Document()
+        {
+            Json result = Value(0);
+            Space();
+            if (_at != _end) { Fail("trailing characters"); }
+            return result;
+        }
+    private:
+        // Deep enough for any real header, shallow enough for the stack.
+        static constexpr int MaxDepth = 256;
+
+        const char* _begin;
+        const char* _at;
+        const char* _end;
+
+        [[noreturn]] void Fail(const char* reason) const
+        {
+            throw std::invalid_argument{ std::string{ "Malformed JSON at byte " } + std::to_string(_at - _begin) + ": " + reason };
+        }
+
+        void Space()
+        {
+            while (_at != _end && (*_at == ' ' || *_at == '\t' || *_at == '\n' || *_at == '\r')) { ++_at; }
+        }
+
+        void Expect(char c)
+        {
+            Space();
+            if (_at == _end || *_at != c) { Fail("unexpected character"); }
+            ++_at;
+        }
+
+        bool Literal(const char* word)
+        {
+            std::size_t length = std::strlen(word);
+            if (static_cast<std::size_t>(_end - _at) < length || std::memcmp(_at, word, length) != 0) { return false; }
+            _at += length;
+            return true;
+        }
+
+        Json Value(int depth)
+        {
+            if (depth > MaxDepth) { Fail("nested too deeply"); }
+            Space();
+            if (_at == _end) { Fail("unexpected end"); }
+
+            Json value;
+            switch (*_at) {
+            case '{':
+                value._kind = Json::Object;
+                ++_at;
+                Space();
+                if (_at != _end && *_at == '}') { ++_at; break; }
+                for (;;) {
+                    Space();
+                    if (_at == _end || *_at != '"') { Fail("expected a member name"); }
+                    std::string key = Text();
+                    Expect(':');
+                    value._members.emplace_back(std::move(key), Value(depth + 1));
+                    Space();
+                    if (_at != _end && *_at == ',') { ++_at; continue; }
+                    Expect('}');
+                    break;
+                }
+                break;
+            case '[':
+                value._kind = Json::Array;
+                ++_at;
+                Space();
+                if (_at != _end && *_at == ']') { ++_at; break; }
+                for (;;) {
+                    value._items.push_back(Value(depth + 1));
+                    Space();
+                    if (_at != _end && *_at == ',') { ++_at; continue; }
+                    Expect(']');
+                    break;
+                }
+                break;
+            case '"':
+                value._kind = Json::String;
+                value._text = Text();
+                break;
+            case 't':
+            case 'f':
+                value._kind = Json::Boolean;
+                if (Literal("true")) { value._number = 1; }
+                else if (!Literal("false")) { Fail("unknown literal"); }
+                break;
+            case 'n':
+                if (!Literal("null")) { Fail("unknown literal"); }
+                break;
+            default:
+                value._kind = Json::Number;
+                value._number = Number();
+                break;
+            }
+            return value;
+        }
+
+        double Number()
+        {
+            // strtod wants a terminated string, and the text is a view.
+            char token[64];
+            std::size_t length = 0;
+            while (_at + length != _end && std::strchr("+-0123456789.eE", _at[length]) && _at[length]) {
+                if (++length == sizeof(token)) { Fail("number too long"); }
+            }
+            if (!length) { Fail("unexpected character"); }
+            std::memcpy(token, _at, length);
+            token[length] = 0;
+            char* stop;
+            double number = std::strtod(token, &stop);
+            if (stop != token + length) { Fail("bad number"); }
+            _at += length;
+            return number;
+        }
+
+        unsigned Hex()
+        {
+            if (_end - _at < 4) { Fail("short escape"); }
+            unsigned code = 0;
+            for (int i = 0; i < 4; ++i, ++_at) {
+                char c = *_at;
+                unsigned digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : 16;
+                if (digit > 15) { Fail("bad escape"); }
+                code = code << 4 | digit;
+            }
+            return code;
+        }
+
+        void Encode(std::string& text, unsigned code)
+        {
+            if (code < 0x80) { text += static_cast<char>(code); }
+            else if (code < 0x800) {
+                text += static_cast<char>(0xC0 | code >> 6);
+                text += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else if (code < 0x10000) {
+                text += static_cast<char>(0xE0 | code >> 12);
+                text += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+                text += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else {
+                text += static_cast<char>(0xF0 | code >> 18);
+                text += static_cast<char>(0x80 | (code >> 12 & 0x3F));
+                text += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+                text += static_cast<char>(0x80 | (code & 0x3F));
+            }
+        }
+
+        // Reads a quoted string, the opening quote at _at.
+        std::string Text()
+        {
+            std::string text;
+            ++_at;
+            for (;;) {
+                const char* run = _at;
+                while (_at != _end && *_at != '"' && *_at != '\\') { ++_at; }
+                text.append(run, _at);
+                if (_at == _end) { Fail("unterminated string"); }
+                if (*_at++ == '"') { return text; }
+                if (_at == _end) { Fail("unterminated string"); }
+                switch (*_at++) {
+                case '"': text += '"'; break;
+                case '\\': text += '\\'; break;
+                case '/': text += '/'; break;
+                case 'b': text += '\b'; break;
+                case 'f': text += '\f'; break;
+                case 'n': text += '\n'; break;
+                case 'r': text += '\r'; break;
+                case 't': text += '\t'; break;
+                case 'u': {
+                    unsigned code = Hex();
+                    if (code >= 0xD800 && code < 0xDC00 && _end - _at >= 2 && _at[0] == '\\' && _at[1] == 'u') {
+                        _at += 2;
+                        unsigned low = Hex();
+                        if (low < 0xDC00 || low >= 0xE000) { Fail("bad surrogate pair"); }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    Encode(text, code);
+                    break;
+                }
+                default: Fail("bad escape");
+                }
+            }
+        }
+    };
+
+    Json Json::Parse(const char* begin, const char* end)
+    {
+        return JsonParser{ begin, end }.Document();
+    }
+
+    const Json& Json::operator[](std::size_t index) const
+    {
+        return _kind == Array && index < _items.size() ? _items[index] : none;
+    }
+
+    const Json& Json::operator[](const std::string& key) const
+    {
+        for (auto& member : _members) {
+            if (member.first == key) { return member.second; }
+        }
+        return none;
+    }
+
+    bool Json::has(const std::string& key) const
+    {
+        for (auto& member : _members) {
+            if (member.first == key) { return true; }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#ifndef IO_JSON
+#define IO_JSON
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace io {
+    // A parsed JSON document, enough to read file headers such as glTF's.
+    // Numbers are held as double. Lookups that miss, on the wrong kind of
+    // value or past the end, give a null value rather than throwing, so
+    // optional members read as json["a"]["b"].number(fallback).
+    class Json {
+    public:
+        enum Kind { Null, Boolean, Number, String, Array, Object };
+
+        Json() : _kind{ Null }, _number{ 0 } {}
+
+        // Throws invalid_argument, with the byte offset, on malformed text.
+        static Json Parse(const char* begin, const char* end);
+
+        Kind kind() const { return _kind; }
+        bool null() const { return _kind == Null; }
+
+        bool boolean(bool fallback = false) const { return _kind == Boolean ? _number != 0 : fallback; }
+        double number(double fallback = 0) const { return _kind == Number ? _number : fallback; }
+        const std::string& string() const { return _text; }
+
+        // Elements of an array or members of an object.
+        std::size_t size() const { return _kind == Array ? _items.size() : _kind == Object ? _members.size() : 0; }
+        const Json& operator[] (std::size_t index) const;
+        // Keeps json[0] from reading as a null const char*.
+        const Json& operator[] (int index) const { return (*this)[static_cast<std::size_t>(index)]; }
+        const Json& operator[] (const std::string& key) const;
+        const Json& operator[] (const char* key) const { return (*this)[std::string{ key }]; }
+        bool has(const std::string& key) const;
+
+        const std::vector<std::pair<std::string, Json>>& members() const { return _members; }
+    private:
+        Kind _kind;
+        double _number;
+        std::string _text;
+        std::vector<Json> _items;
+        std::vector<std::pair<std::string, Json>> _members;
+
+        friend class JsonParser;
+    };
+}
+
+#endif
@@ -0,0 +1,91 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace io {
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string& filename)
+    :   _data{ nullptr }, _size{ 0 }, _file{ INVALID_HANDLE_VALUE }, _mapping{ nullptr }
+    {
+        _file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (_file == INVALID_HANDLE_VALUE) { throw std::runtime_error{ "Failed to open file: " + filename }; }
+
+        LARGE_INTEGER length;
+        if (!GetFileSizeEx(_file, &length)) {
+            CloseHandle(_file);
+            throw std::runtime_error{ "Failed to read size of file: " + filename };
+        }
+        _size = static_cast<std::size_t>(length.QuadPart);
+        if (!_size) { return; }
+
+        _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (_mapping) { _data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0)); }
+        if (!_data) {
+            if (_mapping) { CloseHandle(_mapping); }
+            CloseHandle(_file);
+            throw std::runtime_error{ "Failed to map file: " + filename };
+        }
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (_data) { UnmapViewOfFile(_data); }
+        if (_mapping) { CloseHandle(_mapping); }
+        if (_file != INVALID_HANDLE_VALUE) { CloseHandle(_file); }
+    }
+
+    MappedFile::MappedFile(MappedFile&& source) noexcept
+    :   _data{ source._data }, _size{ source._size }, _file{ source._file }, _mapping{ source._mapping }
+    {
+        source._data = nullptr;
+        source._size = 0;
+        source._file = INVALID_HANDLE_VALUE;
+        source._mapping = nullptr;
+    }
+#else
+    MappedFile::MappedFile(const std::string& filename)
+    :   _data{ nullptr }, _size{ 0 }, _file{ open(filename.c_str(), O_RDONLY) }
+    {
+        if (_file < 0) { throw std::runtime_error{ "Failed to open file: " + filename }; }
+
+        struct stat info;
+        if (fstat(_file, &info) < 0) {
+            close(_file);
+            throw std::runtime_error{ "Failed to read size of file: " + filename };
+        }
+        _size = static_cast<std::size_t>(info.st_size);
+        if (!_size) { return; }
+
+        void* view = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _file, 0);
+        if (view == MAP_FAILED) {
+            close(_file);
+            throw std::runtime_error{ "Failed to map file: " + filename };
+        }
+        madvise(view, _size, MADV_SEQUENTIAL);
+        _data = static_cast<const char*>(view);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (_data) { munmap(const_cast<char*>(_data), _size); }
+        if (_file >= 0) { close(_file); }
+    }
+
+    MappedFile::MappedFile(MappedFile&& source) noexcept
+    :   _data{ source._data }, _size{ source._size }, _file{ source._file }
+    {
+        source._data = nullptr;
+        source._size = 0;
+        source._file = -1;
+    }
+#endif
+}
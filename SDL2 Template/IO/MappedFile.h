@@ -0,0 +1,41 @@
+#pragma once
+
+#ifndef IO_MAPPED_FILE
+#define IO_MAPPED_FILE
+
+#include <cstddef>
+#include <string>
+#include <stdexcept>
+
+namespace io {
+    // Read-only view of a whole file mapped into the address space.
+    // An empty file maps to an empty range rather than failing.
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string& filename);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator= (const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& source) noexcept;
+
+        const char* data() const { return _data; }
+        std::size_t size() const { return _size; }
+        bool empty() const { return _size == 0; }
+
+        const char* begin() const { return _data; }
+        const char* end() const { return _data + _size; }
+    private:
+        const char* _data;
+        std::size_t _size;
+#ifdef _WIN32
+        void* _file;
+        void* _mapping;
+#else
+        int _file;
+#endif
+    };
+}
+
+#endif
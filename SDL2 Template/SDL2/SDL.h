@@ -34,6 +34,7 @@ namespace sdl {
     public:
         enum Features : Uint32 {
             OpenGL = SDL_WINDOW_OPENGL,
+            Hidden = SDL_WINDOW_HIDDEN,
         };
         
         gl::Context CreateContext() & ;
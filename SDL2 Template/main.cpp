@@ -14,12 +14,19 @@
 //==============================================================================
 #include <GL/glew.h>
 #include <SDL2/SDL.h>
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
+#include <exception>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
+#include "GL/AssetStream.h"
+#include "GL/Camera.h"
 
 /*-----------------------------------------------------------------------------
  *  MACRO
@@ -206,6 +213,18 @@ private:
     //ID of Uniforms
     GLuint modelID, viewID, projectionID;
 
+    // Meshes named on the command line stream in while the cube renders,
+    // and are drawn beside it with the flat shader once they are ready
+    struct StreamedMesh {
+        std::string filename;
+        gl::AssetStream::MeshHandle handle;
+    };
+    std::unique_ptr<gl::AssetStream> assets;
+    std::vector<StreamedMesh> meshes;
+    std::unique_ptr<gl::Program> meshProgram;
+    std::unique_ptr<gl::Camera> meshCamera;
+    std::vector<gl::Object> objects;
+
 private:
     App();
 
@@ -221,6 +240,9 @@ private:
     // Render loop (draw)
     void Render();
 
+    // Draw the streamed meshes that are ready, reporting any that failed
+    void RenderMeshes();
+
     // Free up resources
     void Cleanup();
 
@@ -446,6 +468,8 @@ static float m_time = 0.0;
 void App::Render() {
     m_time += .01;
 
+    // The streamed meshes draw with their own program
+    shader->bind();
     BINDVERTEXARRAY(arrayID);
 
     using namespace glm;
@@ -474,6 +498,41 @@ void App::Render() {
     BINDVERTEXARRAY(0);
 }
 
+//------------------------------------------------------------------------------
+void App::RenderMeshes() {
+    for (auto streamed = meshes.begin(); streamed != meshes.end(); ) {
+        if (streamed->handle.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++streamed;
+            continue;
+        }
+        try {
+            std::shared_ptr<const gl::Mesh> mesh = streamed->handle.get();
+            objects.emplace_back(mesh, *meshProgram);
+
+            // Fit the mesh in a unit sphere, then line the meshes up on
+            // alternate sides of the cube
+            const gl::Mesh::Sphere& bounds = mesh->bounds();
+            int slot = (int)objects.size();
+            gl::Object& object = objects.back();
+            object.Translate(-bounds.center);
+            object.Scale(gl::Vector3(1.0f / std::max(bounds.radius, 1e-6f)));
+            object.Translate(gl::Vector3(2.5f * ((slot + 1) / 2) * (slot % 2 ? 1 : -1), 0, 0));
+        }
+        catch (const std::exception& e) {
+            printf("Failed to load %s: %s\n", streamed->filename.c_str(), e.what());
+        }
+        streamed = meshes.erase(streamed);
+    }
+    if (objects.empty()) return;
+
+    glEnable(GL_DEPTH_TEST);
+    *meshCamera << *meshProgram;
+    for (const gl::Object& object : objects) {
+        object.Render();
+    }
+    glDisable(GL_DEPTH_TEST);
+}
+
 //------------------------------------------------------------------------------
 void App::KeyboardKeyDown(SDL_KeyboardEvent kEvent)
 {
@@ -524,6 +583,17 @@ int App::Execute(int argc, char* argv[]) {
     getGLVersion();
     SetupVertex();
 
+    assets.reset(new gl::AssetStream{});
+    for (int i = 1; i < argc; ++i) {
+        meshes.push_back(StreamedMesh{ argv[i], assets->Load(argv[i]) });
+    }
+    if (!meshes.empty()) {
+        meshProgram.reset(new gl::Program{ gl::Shader{ gl::Shader::Vertex, ::shader::vFlat }, gl::Shader{ gl::Shader::Fragment, ::shader::fFlat } });
+        meshCamera.reset(new gl::Camera{
+            glm::perspective(3.14f / 3.f, (float)WindowWidth / WindowHeight, 0.1f, 100.f),
+            glm::lookAt(glm::vec3(0, 2, 5), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0)) });
+    }
+
     using namespace std;
 
     while (Running) {
@@ -550,8 +620,12 @@ int App::Execute(int argc, char* argv[]) {
         glViewport(0, 0, WindowWidth, WindowHeight);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        // Upload a bounded slice of any streamed assets before drawing
+        assets->Upload();
+
         Loop();
         Render();
+        RenderMeshes();
 
         // https://wiki.libsdl.org/SDL_GL_CreateContext
         SDL_GL_SwapWindow(Window);
@@ -559,6 +633,11 @@ int App::Execute(int argc, char* argv[]) {
         SDL_Delay(1); // Breath
     }
 
+    objects.clear();
+    meshes.clear();
+    assets.reset();
+    meshCamera.reset();
+    meshProgram.reset();
     Cleanup();
 
     return 1;
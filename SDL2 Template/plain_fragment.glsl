@@ -1,21 +1,31 @@
 #version 150
 
+in mat4 modelview;
+
 layout (std140)
 uniform
 view {
     mat4 camera, projection;
 };
 
-in vec3 frag_position;
-in vec4 vertex_color;
+in vec3 frag_position, frag_normal;
+in vec2 frag_uv;
 
-out vec4 fragColor;
+// Set by gl::Object from its own colour and highlight, or a part's material.
+uniform vec4 color = vec4(1.0);
+uniform vec3 specular_color = vec3(0.0);
+uniform float shininess = 0.0;
 
 const vec3 light_direction = vec3(0.408248, -0.816497, -0.408248);
 
+out vec4 fragColor;
+
 void main() {
-//    vec3 normal = normalize(frag_normal);
+    vec3 normal = normalize(frag_normal);
+    vec3 light = -normalize(light_direction);
 
-//    float shade = 0.5 * (-dot(normal, normalize(light_direction)) + 1.0);
-    fragColor = vertex_color; // vec4(color.rgb * shade, color.a);
-}
\ No newline at end of file
+    float shade = 0.5 * (dot(normal, light) + 1.0);
+    vec3 halfway = normalize(light + normalize(-frag_position));
+    float specular = shininess > 0.0 && dot(normal, light) > 0.0 ? pow(max(dot(normal, halfway), 0.0), shininess) : 0.0;
+    fragColor = vec4(color.rgb * shade + specular_color * specular, color.a);
+}
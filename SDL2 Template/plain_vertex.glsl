@@ -1,4 +1,4 @@
-#version 150
+#version 330
 
 uniform mat4 transform = mat4(1.0);
 
@@ -8,16 +8,35 @@ view {
     mat4 camera, projection;
 };
 
-in vec3 position;
-in vec4 color;
+// Packed attributes: unorm16 fractions of the position and uv bounds and
+// an octahedral snorm16 normal. Meshes that keep their file's layout,
+// such as glTF, use identity bounds and plain normals.
+uniform vec3 position_lower = vec3(0.0), position_extent = vec3(1.0);
+uniform vec4 uv_bounds = vec4(0.0, 0.0, 1.0, 1.0);
+uniform bool octahedral_normals = true;
 
-out vec3 frag_position;
-out vec4 vertex_color;
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 uv;
+
+out mat4 modelview;
+
+out vec3 frag_position, frag_normal;
+out vec2 frag_uv;
+
+vec3 oct_decode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+    return normalize(n);
+}
 
 void main() {
-    mat4 modelview = camera * transform;
-    vec4 eye_position = modelview * vec4(position, 1.0);
+    modelview = camera * transform;
+    vec4 eye_position = modelview * vec4(position_lower + position * position_extent, 1.0);
     gl_Position = projection * eye_position;
     frag_position = eye_position.xyz;
-    vertex_color = color;
-}
\ No newline at end of file
+    vec3 n = octahedral_normals ? oct_decode(normal.xy) : normalize(normal);
+    frag_normal   = (modelview * vec4(n, 0.0)).xyz;
+    frag_uv = uv_bounds.xy + uv * uv_bounds.zw;
+}
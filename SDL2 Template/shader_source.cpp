@@ -9,8 +9,10 @@
 #include "GL/OpenGL.h"
 #include "GL/Shader.h"
 
+// Built-in copies of plain_vertex.glsl and plain_fragment.glsl, which
+// gl::HotReload can watch to relink without a rebuild. Keep them in step.
 std::string shader::vFlat = R"GLSL(
-#version 150
+#version 330
 
 uniform mat4 transform = mat4(1.0);
 
@@ -20,21 +22,37 @@ view {
     mat4 camera, projection;
 };
 
-in vec3 position, normal;
-in vec2 uv;
+// Packed attributes: unorm16 fractions of the position and uv bounds and
+// an octahedral snorm16 normal. Meshes that keep their file's layout,
+// such as glTF, use identity bounds and plain normals.
+uniform vec3 position_lower = vec3(0.0), position_extent = vec3(1.0);
+uniform vec4 uv_bounds = vec4(0.0, 0.0, 1.0, 1.0);
+uniform bool octahedral_normals = true;
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 uv;
 
 out mat4 modelview;
 
 out vec3 frag_position, frag_normal;
 out vec2 frag_uv;
 
+vec3 oct_decode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+    return normalize(n);
+}
+
 void main() {
     modelview = camera * transform;
-    vec4 eye_position = modelview * vec4(position, 1.0);
+    vec4 eye_position = modelview * vec4(position_lower + position * position_extent, 1.0);
     gl_Position = projection * eye_position;
     frag_position = eye_position.xyz;
-    frag_normal   = (modelview * vec4(normal, 0.0)).xyz;
-    frag_uv = uv;
+    vec3 n = octahedral_normals ? oct_decode(normal.xy) : normalize(normal);
+    frag_normal   = (modelview * vec4(n, 0.0)).xyz;
+    frag_uv = uv_bounds.xy + uv * uv_bounds.zw;
 }
 )GLSL";
 
@@ -52,7 +70,10 @@ view {
 in vec3 frag_position, frag_normal;
 in vec2 frag_uv;
 
-const vec4 color = vec4(1, 1, 1, 1);
+// Set by gl::Object from its own colour and highlight, or a part's material.
+uniform vec4 color = vec4(1.0);
+uniform vec3 specular_color = vec3(0.0);
+uniform float shininess = 0.0;
 
 const vec3 light_direction = vec3(0.408248, -0.816497, -0.408248);
 
@@ -60,8 +81,11 @@ out vec4 fragColor;
 
 void main() {
     vec3 normal = normalize(frag_normal);
+    vec3 light = -normalize(light_direction);
 
-    float shade = 0.5 * (-dot(normal, normalize(light_direction)) + 1.0);
-    fragColor = color; // vec4(color.rgb * shade, color.a);
+    float shade = 0.5 * (dot(normal, light) + 1.0);
+    vec3 halfway = normalize(light + normalize(-frag_position));
+    float specular = shininess > 0.0 && dot(normal, light) > 0.0 ? pow(max(dot(normal, halfway), 0.0), shininess) : 0.0;
+    fragColor = vec4(color.rgb * shade + specular_color * specular, color.a);
 }
 )GLSL";
@@ -0,0 +1,155 @@
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../Math/include/gl_data.hpp"
+
+#include "Check.h"
+
+using namespace std;
+
+namespace {
+    void Put(string& file, size_t at, uint32_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; ++i) { file[at + i] = static_cast<char>(value >> (8 * i)); }
+    }
+
+    // A bitmap file of random pixels, with the RGBA8 rows Bitmap should
+    // give back for it in expected. position holds the byte of a pixel
+    // that red, green, blue and alpha are in, or -1 for an opaque file;
+    // anything but plain BGR(X) is written as bit fields in a V4 header.
+    string RandomBitmap(int width, int height, int bits, bool topDown, const int (&position)[4], mt19937& random, vector<unsigned char>& expected)
+    {
+        bool bitfields = position[0] != 2 || position[1] != 1 || position[2] != 0 || position[3] != -1;
+        uint32_t infoSize = bitfields ? 108 : 40, offset = 14 + infoSize;
+        size_t pitch = (size_t(width) * (bits / 8) + 3) & ~size_t(3);
+        string file(offset + pitch * height, '\0');
+        file[0] = 'B';
+        file[1] = 'M';
+        Put(file, 2, static_cast<uint32_t>(file.size()), 4);
+        Put(file, 10, offset, 4);
+        Put(file, 14, infoSize, 4);
+        Put(file, 18, static_cast<uint32_t>(width), 4);
+        Put(file, 22, static_cast<uint32_t>(topDown ? -height : height), 4);
+        Put(file, 26, 1, 2);
+        Put(file, 28, static_cast<uint32_t>(bits), 2);
+        if (bitfields) {
+            Put(file, 30, 3, 4);
+            for (int c = 0; c < 4; ++c) { Put(file, 54 + 4 * c, position[c] < 0 ? 0 : 0xFFu << (8 * position[c]), 4); }
+        }
+
+        expected.assign(size_t(width) * height * 4, 0);
+        for (int y = 0; y < height; ++y) {
+            char* row = &file[offset + pitch * (topDown ? height - 1 - y : y)];
+            for (int x = 0; x < width; ++x) {
+                char* pixel = row + x * (bits / 8);
+                for (int b = 0; b < bits / 8; ++b) { pixel[b] = static_cast<char>(random()); }
+                for (int c = 0; c < 4; ++c) {
+                    expected[(size_t(y) * width + x) * 4 + c] = position[c] < 0 ? 255 : static_cast<unsigned char>(pixel[position[c]]);
+                }
+            }
+        }
+        return file;
+    }
+
+    lynda::Bitmap Decoded(const string& file)
+    {
+        lynda::Bitmap bitmap;
+        bitmap.decode(reinterpret_cast<const uint8_t*>(file.data()), file.size());
+        return bitmap;
+    }
+}
+
+// Every width through a couple of vector steps, so each row kernel and
+// its scalar tail is used, in both orientations and several channel
+// orders, plus an image big enough to be split across threads. Each must
+// match converting the pixels one at a time.
+TEST(BitmapDecodeMatchesReference)
+{
+    const int plain[4] = { 2, 1, 0, -1 };
+    const int rgba[4] = { 0, 1, 2, 3 };
+    const int argb[4] = { 1, 2, 3, 0 };
+    const int xbgr[4] = { 3, 2, 1, -1 };
+    struct Layout { int bits; const int (&position)[4]; };
+    const Layout layouts[] = { { 24, plain }, { 32, plain }, { 32, rgba }, { 32, argb }, { 32, xbgr } };
+
+    mt19937 random{ 20 };
+    vector<unsigned char> expected;
+    for (const Layout& layout : layouts) {
+        for (bool topDown : { false, true }) {
+            for (int width = 1; width <= 40; ++width) {
+                string file = RandomBitmap(width, 3, layout.bits, topDown, layout.position, random, expected);
+                lynda::Bitmap bitmap = Decoded(file);
+                CHECK(bitmap.width == width && bitmap.height == 3 && bitmap.BitsPerPixel == 32);
+                CHECK(bitmap.pixels == expected);
+            }
+            string file = RandomBitmap(701, 400, layout.bits, topDown, layout.position, random, expected);
+            CHECK(Decoded(file).pixels == expected);
+        }
+    }
+}
+
+// Files cut short, and ones this loader does not read, throw instead of
+// reading past the end. The last row may leave out its padding.
+TEST(BitmapRejectsBadFiles)
+{
+    const int plain[4] = { 2, 1, 0, -1 };
+    mt19937 random{ 20 };
+    vector<unsigned char> expected;
+    string file = RandomBitmap(33, 5, 24, false, plain, random, expected);
+    auto throws = [](const string& bytes) {
+        try { Decoded(bytes); }
+        catch (const invalid_argument&) { return true; }
+        return false;
+    };
+    CHECK(!throws(file));
+    CHECK(!throws(file.substr(0, file.size() - 1)));
+    CHECK(throws(file.substr(0, file.size() - 2)));
+    CHECK(throws(file.substr(0, 40)));
+    string paletted = file;
+    Put(paletted, 28, 8, 2);
+    CHECK(throws(paletted));
+    string compressed = file;
+    Put(compressed, 30, 1, 4);
+    CHECK(throws(compressed));
+}
+
+// Decode speed in MB/s of file bytes, for 24 and 32 bit images stored
+// both ways up: decoding from memory into pixels already allocated, and
+// loading a new Bitmap from the file as a texture would. Uses
+// generated 4096 x 4096 images, or the bitmap given after the name:
+//
+//     Tests --bench BitmapDecodeThroughput texture.bmp
+BENCHMARK(BitmapDecodeThroughput)
+{
+    check::ScratchFile scratch{ "decode_throughput.bmp" };
+    auto measure = [&](const char* name, const string& file) {
+        scratch.Write(file);
+        lynda::Bitmap bitmap;
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(file.data());
+        double decode = check::Fastest([&] { bitmap.decode(data, file.size()); });
+        double load = check::Fastest([&] { lynda::Bitmap{ scratch.path().c_str() }; });
+        printf("    %-20s %d x %d, %.1f MB: decode %.0f MB/s, load %.0f MB/s\n",
+            name, bitmap.width, bitmap.height, file.size() / 1e6, file.size() / decode / 1e6, file.size() / load / 1e6);
+    };
+
+    if (!check::Arguments().empty()) {
+        FILE* in = fopen(check::Arguments()[0].c_str(), "rb");
+        if (!in) { throw runtime_error{ "Failed to open " + check::Arguments()[0] }; }
+        string file;
+        char buffer[1 << 16];
+        for (size_t read; (read = fread(buffer, 1, sizeof buffer, in)) > 0;) { file.append(buffer, read); }
+        fclose(in);
+        measure(check::Arguments()[0].c_str(), file);
+        return;
+    }
+    const int plain[4] = { 2, 1, 0, -1 };
+    mt19937 random{ 20 };
+    vector<unsigned char> expected;
+    measure("24 bit, bottom-up:", RandomBitmap(4096, 4096, 24, false, plain, random, expected));
+    measure("24 bit, top-down:", RandomBitmap(4096, 4096, 24, true, plain, random, expected));
+    measure("32 bit, bottom-up:", RandomBitmap(4096, 4096, 32, false, plain, random, expected));
+    measure("32 bit, top-down:", RandomBitmap(4096, 4096, 32, true, plain, random, expected));
+}
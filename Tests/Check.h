@@ -0,0 +1,92 @@
+#pragma once
+
+#ifndef TESTS_CHECK
+#define TESTS_CHECK
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace check {
+    // Thrown by CHECK when its condition does not hold.
+    struct Failure : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    // Tests run by default and must pass; benchmarks run only when asked
+    // for and print what they measure.
+    enum class Kind { Test, Benchmark };
+
+    struct Case {
+        const char* name;
+        Kind kind;
+        void (*body)();
+    };
+
+    std::vector<Case>& Cases();
+
+    // Adds a case before main runs; see TEST and BENCHMARK.
+    struct Register {
+        Register(const char* name, Kind kind, void (*body)()) { Cases().push_back(Case{ name, kind, body }); }
+    };
+
+    void That(bool condition, const char* expression, const char* file, int line);
+
+    // Whatever followed the case name on the command line, such as an
+    // asset to measure in place of the generated one.
+    const std::vector<std::string>& Arguments();
+
+    // A file in the temporary directory, removed when this goes.
+    class ScratchFile {
+    public:
+        explicit ScratchFile(const std::string& name);
+        ~ScratchFile();
+
+        ScratchFile(const ScratchFile&) = delete;
+        ScratchFile& operator= (const ScratchFile&) = delete;
+
+        void Write(const std::string& contents) const;
+        std::string path() const { return _path.string(); }
+    private:
+        std::filesystem::path _path;
+    };
+
+    // Asks the system to forget the cached pages of a file, so the next
+    // read of it comes from the disk. Best effort: files still open
+    // elsewhere may stay cached.
+    void DropCached(const std::string& filename);
+
+    // Seconds taken by the fastest run of work, repeated for about budget
+    // seconds, which leaves out the runs slowed by something else on the
+    // machine.
+    template <typename F>
+    double Fastest(F&& work, double budget = 1.0)
+    {
+        using Clock = std::chrono::steady_clock;
+        double best = std::numeric_limits<double>::max(), spent = 0.0;
+        for (int run = 0; run < 3 || spent < budget; ++run) {
+            auto start = Clock::now();
+            work();
+            double taken = std::chrono::duration<double>(Clock::now() - start).count();
+            best = std::min(best, taken);
+            spent += taken;
+        }
+        return best;
+    }
+}
+
+#define CHECK(condition) ::check::That((condition), #condition, __FILE__, __LINE__)
+
+#define CHECK_CASE(name, kind) \
+    static void name(); \
+    static const ::check::Register name##Case{ #name, kind, &name }; \
+    static void name()
+
+#define TEST(name) CHECK_CASE(name, ::check::Kind::Test)
+#define BENCHMARK(name) CHECK_CASE(name, ::check::Kind::Benchmark)
+
+#endif
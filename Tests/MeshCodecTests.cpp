@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "../SDL2 Template/GL/MeshCodec.h"
+#include "../SDL2 Template/GL/MeshOptimizer.h"
+#include "../SDL2 Template/GL/OBJmesh.h"
+#include "../SDL2 Template/GL/PackedVertex.h"
+
+#include "Check.h"
+
+using namespace std;
+using namespace gl;
+
+namespace {
+    // GB/s of decoded output the codec is meant to reach on one core.
+    constexpr double TargetRate = 1.0;
+
+    // A side x side grid of quads in the order a cooked mesh has them:
+    // triangles sorted for the vertex cache, vertices in order of use.
+    void CookedGrid(int side, vector<Vertex>& vertices, vector<Uint>& indices)
+    {
+        vertices.assign(size_t(side + 1) * (side + 1), Vertex{});
+        for (int y = 0; y <= side; ++y) {
+            for (int x = 0; x <= side; ++x) {
+                Vertex& v = vertices[size_t(y) * (side + 1) + x];
+                v.position = Point3{ x * 0.1f, y * 0.1f, ((x * 7 + y * 3) % 13) * 0.01f };
+                v.normal = Vector3{ 0.0f, 0.0f, 1.0f };
+                v.uv = Vector2{ x / float(side), y / float(side) };
+                v.tangent = Vector4{ 1.0f, 0.0f, 0.0f, 1.0f };
+            }
+        }
+        indices.clear();
+        for (int y = 0; y < side; ++y) {
+            for (int x = 0; x < side; ++x) {
+                Uint a = Uint(y * (side + 1) + x), b = a + 1, c = a + Uint(side + 1), d = c + 1;
+                indices.insert(indices.end(), { a, b, d, a, d, c });
+            }
+        }
+        optimize::ReorderForVertexCache(indices, vertices.size());
+        optimize::ReorderForVertexFetch(vertices, indices);
+    }
+
+    template <typename T>
+    vector<Uint> DecodedAs(const vector<Ubyte>& encoded, size_t count, TypeCode type)
+    {
+        vector<T> decoded(count);
+        DecodeIndices(encoded.data(), encoded.size(), decoded.data(), count, type);
+        return vector<Uint>(decoded.begin(), decoded.end());
+    }
+
+    bool Throws(void (*decode)(const vector<Ubyte>&), const vector<Ubyte>& encoded)
+    {
+        try { decode(encoded); }
+        catch (const invalid_argument&) { return true; }
+        return false;
+    }
+}
+
+// Index streams come back exactly at every element type, whether they
+// look like a cooked mesh or like noise that needs the varint escapes.
+TEST(MeshCodecIndicesRoundTrip)
+{
+    vector<Vertex> vertices;
+    vector<Uint> indices;
+    CookedGrid(40, vertices, indices);
+    vector<Ubyte> encoded = EncodeIndices(indices);
+    CHECK(encoded.size() < indices.size() * 2);
+    CHECK(DecodedAs<Uint>(encoded, indices.size(), TypeCode::Uint) == indices);
+    CHECK(DecodedAs<Ushort>(encoded, indices.size(), TypeCode::Ushort) == indices);
+
+    // The last kind mixes small indices with ones at the very top of the
+    // range, where one past the highest so far wraps to zero.
+    mt19937 random{ 15 };
+    for (int trial = 0; trial < 200; ++trial) {
+        vector<Uint> noise(random() % 1000);
+        Uint bound = trial % 4 == 0 ? 0x100u : trial % 4 == 1 ? 0x10000u : 0u;
+        for (Uint& index : noise) {
+            index = bound ? Uint(random()) % bound : Uint(random());
+            if (trial % 4 == 3) { index = index % 2 ? index / 2 % 8 : ~0u - index / 2 % 4; }
+        }
+        encoded = EncodeIndices(noise);
+        CHECK(DecodedAs<Uint>(encoded, noise.size(), TypeCode::Uint) == noise);
+        if (bound == 0x100u) { CHECK(DecodedAs<Ubyte>(encoded, noise.size(), TypeCode::Ubyte) == noise); }
+        if (bound == 0x10000u) { CHECK(DecodedAs<Ushort>(encoded, noise.size(), TypeCode::Ushort) == noise); }
+    }
+}
+
+// Vertex blobs come back exactly for strides that do and do not fill the
+// 16 byte tiles and counts that do and do not fill a group.
+TEST(MeshCodecVerticesRoundTrip)
+{
+    vector<Vertex> vertices;
+    vector<Uint> indices;
+    CookedGrid(40, vertices, indices);
+    vector<Ubyte> encoded = EncodeVertices(vertices.data(), vertices.size(), sizeof(Vertex));
+    vector<Vertex> decoded(vertices.size());
+    DecodeVertices(encoded.data(), encoded.size(), decoded.data(), decoded.size(), sizeof(Vertex));
+    CHECK(memcmp(decoded.data(), vertices.data(), vertices.size() * sizeof(Vertex)) == 0);
+
+    mt19937 random{ 15 };
+    for (size_t stride : { 1, 3, 12, 16, 20, 33, 48 }) {
+        for (size_t count : { 0, 1, 15, 16, 17, 255, 256, 257, 1000 }) {
+            vector<Ubyte> blob(stride * count);
+            for (size_t i = 0; i < blob.size(); ++i) {
+                blob[i] = static_cast<Ubyte>(stride % 2 ? random() : i / stride + random() % 3);
+            }
+            encoded = EncodeVertices(blob.data(), count, stride);
+            vector<Ubyte> back(blob.size());
+            DecodeVertices(encoded.data(), encoded.size(), back.data(), count, stride);
+            CHECK(back == blob);
+        }
+    }
+}
+
+// Cutting an encoding short or leaving bytes over throws rather than
+// reading past the end or handing back half a mesh.
+TEST(MeshCodecRejectsDamage)
+{
+    vector<Uint> noise(500);
+    mt19937 random{ 15 };
+    for (Uint& index : noise) { index = Uint(random()); }
+    vector<Ubyte> indices = EncodeIndices(noise);
+    auto decodeIndices = [](const vector<Ubyte>& encoded) {
+        vector<Uint> out(500);
+        DecodeIndices(encoded.data(), encoded.size(), out.data(), out.size(), TypeCode::Uint);
+    };
+    CHECK(Throws(decodeIndices, vector<Ubyte>(indices.begin(), indices.end() - 1)));
+    CHECK(Throws(decodeIndices, vector<Ubyte>(indices.begin(), indices.begin() + 400)));
+    indices.push_back(0);
+    CHECK(Throws(decodeIndices, indices));
+
+    vector<Ubyte> blob(20 * 300);
+    for (Ubyte& byte : blob) { byte = static_cast<Ubyte>(random()); }
+    vector<Ubyte> vertices = EncodeVertices(blob.data(), 300, 20);
+    auto decodeVertices = [](const vector<Ubyte>& encoded) {
+        vector<Ubyte> out(20 * 300);
+        DecodeVertices(encoded.data(), encoded.size(), out.data(), 300, 20);
+    };
+    CHECK(Throws(decodeVertices, vector<Ubyte>(vertices.begin(), vertices.end() - 1)));
+    vertices.push_back(0);
+    CHECK(Throws(decodeVertices, vertices));
+}
+
+// Decode speed in GB/s of what comes out, against a plain copy of the
+// same bytes, and whether each stream clears the 1 GB/s on one core that
+// makes decoding cheaper than reading the uncompressed bytes from disk.
+// Uses generated grids with 16 and 32 bit indices, or the OBJ given after
+// the name:
+//
+//     Tests --bench MeshCodecThroughput model.obj
+BENCHMARK(MeshCodecThroughput)
+{
+    auto measure = [](const char* name, const vector<Vertex>& unpacked, const vector<Uint>& indices) {
+        // Packed as a cooked mesh stores them.
+        vector<PackedVertex> vertices;
+        PackVertices(unpacked, Quantize(unpacked), vertices);
+        TypeCode type = vertices.size() <= 0x10000 ? TypeCode::Ushort : TypeCode::Uint;
+        size_t indexBytes = indices.size() * TypeAlloc[type], vertexBytes = vertices.size() * sizeof(PackedVertex);
+        vector<Ubyte> encodedIndices = EncodeIndices(indices);
+        vector<Ubyte> encodedVertices = EncodeVertices(vertices.data(), vertices.size(), sizeof(PackedVertex));
+        vector<Ubyte> raw(max(indexBytes, vertexBytes), 1), out(raw.size());
+
+        double indexTime = check::Fastest([&] { DecodeIndices(encodedIndices.data(), encodedIndices.size(), out.data(), indices.size(), type); });
+        double vertexTime = check::Fastest([&] { DecodeVertices(encodedVertices.data(), encodedVertices.size(), out.data(), vertices.size(), sizeof(PackedVertex)); });
+        double copyTime = check::Fastest([&] { memcpy(out.data(), raw.data(), raw.size()); });
+
+        auto verdict = [](double rate) { return rate >= TargetRate ? "meets" : "MISSES"; };
+        double indexRate = indexBytes / indexTime / 1e9, vertexRate = vertexBytes / vertexTime / 1e9;
+        printf("    %s\n", name);
+        printf("      indices:  %zu x %zu bytes, encoded to %.1f%%, decode %.3f GB/s, %s the %.0f GB/s target\n",
+            indices.size(), size_t(TypeAlloc[type]), 100.0 * encodedIndices.size() / indexBytes, indexRate, verdict(indexRate), TargetRate);
+        printf("      vertices: %zu x %zu bytes, encoded to %.1f%%, decode %.3f GB/s, %s the %.0f GB/s target\n",
+            vertices.size(), sizeof(PackedVertex), 100.0 * encodedVertices.size() / vertexBytes, vertexRate, verdict(vertexRate), TargetRate);
+        printf("      memcpy:   %.2f GB/s\n", raw.size() / copyTime / 1e9);
+    };
+
+    vector<Vertex> vertices;
+    vector<Uint> indices;
+    if (!check::Arguments().empty()) {
+        OBJmesh mesh{ check::Arguments()[0] };
+        mesh.Optimize();
+        measure(check::Arguments()[0].c_str(), mesh.vData(), mesh.fData());
+        return;
+    }
+    CookedGrid(250, vertices, indices);
+    measure("250 x 250 grid", vertices, indices);
+    CookedGrid(700, vertices, indices);
+    measure("700 x 700 grid", vertices, indices);
+}
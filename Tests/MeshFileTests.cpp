@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../SDL2 Template/GL/MeshFile.h"
+#include "../SDL2 Template/GL/MeshCodec.h"
+#include "../SDL2 Template/GL/OBJmesh.h"
+
+#include "Check.h"
+
+using namespace std;
+using namespace gl;
+
+namespace {
+    // A flat grid of quads, few enough vertices for byte indices.
+    string GridObj(int side)
+    {
+        string text;
+        for (int y = 0; y <= side; ++y) {
+            for (int x = 0; x <= side; ++x) {
+                text += "v " + to_string(x) + " " + to_string(y) + " 0\n";
+            }
+        }
+        for (int y = 0; y < side; ++y) {
+            for (int x = 0; x < side; ++x) {
+                int a = y * (side + 1) + x + 1, b = a + 1, c = a + side + 2, d = a + side + 1;
+                text += "f " + to_string(a) + " " + to_string(b) + " " + to_string(c) + " " + to_string(d) + "\n";
+            }
+        }
+        return text;
+    }
+
+    string ReadAll(const string& filename)
+    {
+        ifstream in{ filename, ios::binary };
+        return string{ istreambuf_iterator<char>{ in }, istreambuf_iterator<char>{} };
+    }
+
+    MeshFile::Header HeaderOf(const string& cooked)
+    {
+        MeshFile::Header header;
+        memcpy(&header, cooked.data(), sizeof header);
+        return header;
+    }
+
+    void StoreElement(string& cooked, const MeshFile::Header& header, size_t i, Uint value)
+    {
+        char* at = &cooked[header.elementOffset];
+        switch (header.elementType) {
+        case TypeCode::Ubyte: { Ubyte narrow = static_cast<Ubyte>(value); memcpy(at + i, &narrow, sizeof narrow); break; }
+        case TypeCode::Ushort: { Ushort narrow = static_cast<Ushort>(value); memcpy(at + i * sizeof narrow, &narrow, sizeof narrow); break; }
+        default: memcpy(at + i * sizeof value, &value, sizeof value); break;
+        }
+    }
+
+    template <typename F>
+    bool Throws(F&& work)
+    {
+        try { work(); }
+        catch (const invalid_argument&) { return true; }
+        return false;
+    }
+}
+
+// A cooked file that names a vertex it does not have is refused before any
+// of it reaches the GL: on mapping when its indices are stored as they are,
+// on decoding when they are compressed.
+TEST(MeshFileRejectsElementsPastVertices)
+{
+    check::ScratchFile obj{ "grid.obj" }, cooked{ "grid.gmsh" }, damaged{ "damaged.gmsh" };
+    obj.Write(GridObj(8));
+
+    MeshFile::Cook(obj.path(), cooked.path(), true, false);
+    string plain = ReadAll(cooked.path());
+    MeshFile::Header header = HeaderOf(plain);
+    CHECK(header.elementType == TypeCode::Ubyte);
+    {
+        io::MappedFile mapped{ cooked.path() };
+        CHECK(!Throws([&] { MeshFile{ mapped }; }));
+    }
+    StoreElement(plain, header, header.elementCount - 1, header.vertexCount);
+    damaged.Write(plain);
+    {
+        io::MappedFile mapped{ damaged.path() };
+        CHECK(Throws([&] { MeshFile{ mapped }; }));
+    }
+
+    MeshFile::Cook(obj.path(), cooked.path(), true, true);
+    string packed = ReadAll(cooked.path());
+    header = HeaderOf(packed);
+    vector<Uint> indices(header.elementCount);
+    {
+        io::MappedFile mapped{ cooked.path() };
+        MeshFile file{ mapped };
+        vector<PackedVertex> vertices;
+        vector<Ubyte> elements;
+        file.Decode(vertices, elements);
+        for (size_t i = 0; i < indices.size(); ++i) { indices[i] = ReadElement(elements.data(), header.elementType, i); }
+    }
+    indices.back() = header.vertexCount;
+    vector<Ubyte> encoded = EncodeIndices(indices);
+    CHECK(encoded.size() <= header.surfaceOffset - header.elementOffset);
+    memcpy(&packed[header.elementOffset], encoded.data(), encoded.size());
+    header.elementBytes = encoded.size();
+    memcpy(&packed[0], &header, sizeof header);
+    damaged.Write(packed);
+    {
+        io::MappedFile mapped{ damaged.path() };
+        MeshFile file{ mapped };
+        vector<PackedVertex> vertices;
+        vector<Ubyte> elements;
+        CHECK(Throws([&] { file.Decode(vertices, elements); }));
+    }
+}
+
+// Clusters stay inside their triangle surface and within both limits, and
+// between them cover each triangle of those surfaces exactly once; other
+// surfaces get none. Triangles drawing from scattered vertices fill the
+// vertex limit first, ones sharing a few vertices the triangle limit.
+TEST(MeshFileClustersCoverTrianglesWithinLimits)
+{
+    mt19937 random{ 8 };
+    vector<Vertex> vertices(3000);
+    for (Vertex& v : vertices) { v.position = Point3{ random() % 100 * 0.1f, random() % 100 * 0.1f, random() % 100 * 0.1f }; }
+
+    vector<Uint> elements;
+    vector<Mesh::SubMesh> surfaces;
+    auto surface = [&](Mesh::Assembly mode, auto&& index, Size count) {
+        surfaces.push_back(Mesh::SubMesh{ mode, static_cast<Size>(elements.size()), count, 0 });
+        for (Size i = 0; i < count; ++i) { elements.push_back(index(i)); }
+    };
+    surface(Mesh::Triangles, [&](Size) { return Uint(random() % vertices.size()); }, 3 * 700);
+    surface(Mesh::Lines, [&](Size i) { return Uint(i); }, 42);
+    surface(Mesh::Triangles, [&](Size i) { return Uint(i % 31); }, 3 * 900);
+
+    for (size_t maxVertices : { size_t{ 64 }, size_t{ 10 } }) {
+        const size_t maxTriangles = maxVertices == 64 ? 124 : 3;
+        vector<Mesh::Cluster> clusters = BuildClusters(vertices, elements, surfaces, maxVertices, maxTriangles);
+        vector<int> covered(elements.size() / 3, 0);
+        for (const Mesh::Cluster& cluster : clusters) {
+            const Mesh::SubMesh& owner = surfaces[cluster.surface];
+            CHECK(owner.mode == Mesh::Triangles);
+            CHECK(cluster.start >= owner.start && cluster.start + cluster.count <= owner.start + owner.count);
+            CHECK(cluster.count > 0 && cluster.count % 3 == 0 && size_t(cluster.count / 3) <= maxTriangles);
+
+            vector<Uint> used(elements.begin() + cluster.start, elements.begin() + cluster.start + cluster.count);
+            sort(used.begin(), used.end());
+            CHECK(size_t(unique(used.begin(), used.end()) - used.begin()) <= maxVertices);
+            for (Size t = cluster.start; t < cluster.start + cluster.count; t += 3) { ++covered[t / 3]; }
+        }
+        for (const Mesh::SubMesh& owner : surfaces) {
+            for (Size t = owner.start; t + 2 < owner.start + owner.count; t += 3) { CHECK(covered[t / 3] == (owner.mode == Mesh::Triangles ? 1 : 0)); }
+        }
+    }
+}
+
+// Milliseconds and MB/s to load a mesh through Mesh::Source from a cooked
+// file, plain and compressed, against parsing the OBJ it was cooked from
+// with OBJmesh. The cold load follows dropping the file from the page
+// cache; the warm one is the fastest of the repeats after it. The mesh is
+// a generated grid unless an OBJ is named after the case.
+//
+//     Tests --bench MeshFileLoad model.obj
+BENCHMARK(MeshFileLoad)
+{
+    check::ScratchFile generated{ "load.obj" }, plain{ "load.gmsh" }, packed{ "load_packed.gmsh" };
+    string source = check::Arguments().empty() ? generated.path() : check::Arguments()[0];
+    if (check::Arguments().empty()) { generated.Write(GridObj(700)); }
+    MeshFile::Cook(source, plain.path(), true, false);
+    MeshFile::Cook(source, packed.path(), true, true);
+
+    printf("    %-22s %8s %9s %10s %9s %10s\n", "", "MB", "cold ms", "cold MB/s", "warm ms", "warm MB/s");
+    auto measure = [](const char* name, const string& path, auto&& load) {
+        double megabytes = static_cast<double>(filesystem::file_size(path)) / 1e6;
+        check::DropCached(path);
+        auto start = chrono::steady_clock::now();
+        load();
+        double cold = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        double warm = check::Fastest(load, 0.0);
+        printf("    %-22s %8.1f %9.1f %10.0f %9.1f %10.0f\n", name, megabytes, 1e3 * cold, megabytes / cold, 1e3 * warm, megabytes / warm);
+    };
+    measure("OBJmesh, source OBJ", source, [&] { OBJmesh{ source }; });
+    measure("Mesh::Source, cooked", plain.path(), [&] { Mesh::Source{ plain.path() }; });
+    measure("Mesh::Source, packed", packed.path(), [&] { Mesh::Source{ packed.path() }; });
+}
@@ -0,0 +1,81 @@
+#include <vector>
+
+#include "../SDL2 Template/GL/MeshOptimizer.h"
+
+#include "Check.h"
+
+using namespace std;
+using namespace gl;
+
+namespace {
+    // A flat side x side grid of quads on z = 0 with a uv seam down the
+    // middle column, whose vertices are doubled: the left copies come
+    // first, the right ones follow the grid.
+    void SeamedGrid(int side, vector<Vertex>& vertices, vector<Uint>& indices)
+    {
+        const int stride = side + 1;
+        vertices.assign(size_t(stride) * stride, Vertex{});
+        for (int y = 0; y <= side; ++y) {
+            for (int x = 0; x <= side; ++x) {
+                Vertex& v = vertices[size_t(y) * stride + x];
+                v.position = Point3{ float(x), float(y), 0.0f };
+                v.normal = Vector3{ 0.0f, 0.0f, 1.0f };
+                v.uv = Vector2{ x / float(side), y / float(side) };
+            }
+        }
+        vector<Uint> right(stride);
+        for (int y = 0; y <= side; ++y) {
+            right[y] = static_cast<Uint>(vertices.size());
+            Vertex copy = vertices[size_t(y) * stride + side / 2];
+            copy.uv.x += 1.0f;
+            vertices.push_back(copy);
+        }
+
+        indices.clear();
+        for (int y = 0; y < side; ++y) {
+            for (int x = 0; x < side; ++x) {
+                Uint a = Uint(y * stride + x), b = a + 1, c = a + Uint(stride), d = c + 1;
+                if (x == side / 2) { a = right[y]; c = right[y + 1]; }
+                indices.insert(indices.end(), { a, b, d, a, d, c });
+            }
+        }
+    }
+}
+
+// Halving a flat grid leaves at most half its triangles, all still facing
+// up and covering the grid without gaps or overlaps, and collapses nothing
+// that must stay: the border with its corners, and both sides of the seam.
+TEST(SimplifyHalvesAndKeepsLockedVertices)
+{
+    const int side = 32, stride = side + 1;
+    vector<Vertex> vertices;
+    vector<Uint> indices;
+    SeamedGrid(side, vertices, indices);
+    const size_t triangles = indices.size() / 3;
+
+    optimize::Simplify(indices, vertices, indices.size() / 2);
+    CHECK(indices.size() % 3 == 0);
+    CHECK(indices.size() / 3 <= triangles / 2);
+    CHECK(indices.size() / 3 >= triangles / 4);
+
+    double area = 0.0;
+    for (size_t t = 0; t < indices.size(); t += 3) {
+        const Point3& a = vertices[indices[t]].position;
+        const Point3& b = vertices[indices[t + 1]].position;
+        const Point3& c = vertices[indices[t + 2]].position;
+        double facing = double(b.x - a.x) * (c.y - a.y) - double(b.y - a.y) * (c.x - a.x);
+        CHECK(facing > 0.0);
+        area += facing * 0.5;
+    }
+    CHECK(area == double(side) * side);
+
+    vector<bool> used(vertices.size(), false);
+    for (Uint index : indices) { used[index] = true; }
+    for (int y = 0; y <= side; ++y) {
+        for (int x = 0; x <= side; ++x) {
+            bool border = x == 0 || y == 0 || x == side || y == side;
+            if (border || x == side / 2) { CHECK(used[size_t(y) * stride + x]); }
+        }
+        CHECK(used[size_t(stride) * stride + y]);
+    }
+}
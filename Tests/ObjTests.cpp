@@ -0,0 +1,242 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../SDL2 Template/GL/OBJmesh.h"
+#include "../SDL2 Template/GL/VertexTable.h"
+
+#include "Check.h"
+
+using namespace std;
+
+namespace {
+    // A few MB of OBJ that covers what the parser handles: v/vt/vn in every
+    // face form, negative indices, quads to triangulate, comments, mtllib,
+    // faces before any usemtl and usemtl switching back to earlier
+    // materials. Strips of quads share their vertices, so the corner table
+    // sees repeats as well.
+    string GeneratedObj(size_t minimumBytes)
+    {
+        string text = "# generated for the parser tests\nmtllib first.mtl\n";
+        const char* materials[] = { "stone", "wood", "glass" };
+        const int columns = 24;
+        char line[160];
+        int positions = 0, uvs = 0, normals = 0;
+        for (int strip = 0; text.size() < minimumBytes; ++strip) {
+            if (strip == 40) { text += "mtllib second.mtl\n"; }
+            for (int column = 0; column <= columns; ++column) {
+                for (int row = 0; row < 2; ++row) {
+                    snprintf(line, sizeof line, "v %.6f %.6f %.6f\nvt %.5f %.5f\n",
+                        column * 0.25, (strip + row) * 0.5, ((column * 7 + strip * 3) % 11) * 0.01,
+                        column / double(columns), row * 1.0);
+                    text += line;
+                }
+                snprintf(line, sizeof line, "vn %.4f %.4f %.4f\n", (column % 3) * 0.1, 1.0, (strip % 5) * 0.1);
+                text += line;
+            }
+            positions += 2 * (columns + 1);
+            uvs += 2 * (columns + 1);
+            normals += columns + 1;
+            if (strip % 3 == 1) {
+                snprintf(line, sizeof line, "usemtl %s\n", materials[(strip / 3) % 3]);
+                text += line;
+            }
+            if (strip % 17 == 0) { text += "# strip comment, which a chunk may start inside\n"; }
+            int base = positions - 2 * (columns + 1) + 1;
+            int normalBase = normals - (columns + 1) + 1;
+            for (int column = 0; column < columns; ++column) {
+                int a = base + 2 * column, b = a + 1, c = a + 2, d = a + 3;
+                int n = normalBase + column;
+                switch ((strip + column) % 5) {
+                case 0:
+                    snprintf(line, sizeof line, "f %d %d %d %d\n", a, c, d, b);
+                    break;
+                case 1:
+                    snprintf(line, sizeof line, "f %d/%d %d/%d %d/%d\nf %d/%d %d/%d %d/%d\n",
+                        a, a, c, c, d, d, a, a, d, d, b, b);
+                    break;
+                case 2:
+                    snprintf(line, sizeof line, "f %d//%d %d//%d %d//%d %d//%d\n", a, n, c, n + 1, d, n + 1, b, n);
+                    break;
+                case 3:
+                    snprintf(line, sizeof line, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n",
+                        a - positions - 1, a - uvs - 1, n - normals - 1, c - positions - 1, c - uvs - 1, n - normals,
+                        d - positions - 1, d - uvs - 1, n - normals, b - positions - 1, b - uvs - 1, n - normals - 1);
+                    break;
+                default:
+                    snprintf(line, sizeof line, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, n, c, c, n + 1, d, d, n + 1);
+                    break;
+                }
+                text += line;
+            }
+        }
+        return text;
+    }
+
+    template <typename T>
+    bool SameBytes(const vector<T>& a, const vector<T>& b)
+    {
+        return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+    }
+
+    bool SameMaterials(const OBJmesh& a, const OBJmesh& b)
+    {
+        if (a.materials().size() != b.materials().size()) { return false; }
+        for (size_t i = 0; i < a.materials().size(); ++i) {
+            if (a.materials()[i].name != b.materials()[i].name) { return false; }
+        }
+        return a.materialLibraries() == b.materialLibraries();
+    }
+
+    // Twice the signed area of abc; positive when counter-clockwise.
+    double Turn(const gl::Vector2& a, const gl::Vector2& b, const gl::Vector2& c)
+    {
+        return (double(b.x) - a.x) * (double(c.y) - a.y) - (double(b.y) - a.y) * (double(c.x) - a.x);
+    }
+
+    bool Inside(const vector<gl::Vector2>& polygon, const gl::Vector2& p)
+    {
+        bool inside = false;
+        for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+            const gl::Vector2& a = polygon[i];
+            const gl::Vector2& b = polygon[j];
+            if ((a.y > p.y) != (b.y > p.y) && p.x < (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x) { inside = !inside; }
+        }
+        return inside;
+    }
+}
+
+// Splitting the file among workers must not change a single byte of what
+// comes out: the vertices, the faces, their grouping and the materials
+// all have to match parsing on one thread.
+TEST(ObjThreadedParseMatchesSingleThread)
+{
+    check::ScratchFile file{ "threaded_parse.obj" };
+    file.Write(GeneratedObj(6 << 20));
+
+    OBJmesh single{ file.path(), 1 };
+    CHECK(!single.fData().empty());
+    CHECK(single.fData().size() % 3 == 0);
+    CHECK(single.materials().size() == 4);
+    CHECK(single.materialLibraries().size() == 2);
+    CHECK(!single.faceMaterials().empty());
+
+    for (unsigned threads : { 2u, 3u, 4u, 7u, 0u }) {
+        OBJmesh threaded{ file.path(), threads };
+        CHECK(SameBytes(threaded.vData(), single.vData()));
+        CHECK(SameBytes(threaded.fData(), single.fData()));
+        CHECK(SameBytes(threaded.faceSegments(), single.faceSegments()));
+        CHECK(SameBytes(threaded.faceMaterials(), single.faceMaterials()));
+        CHECK(SameMaterials(threaded, single));
+    }
+}
+
+// A concave face comes out as n - 2 triangles wound the way it is, which
+// lie inside it and add up to its area, so none overlap. The faces are
+// tilted out of every axis plane, and one runs clockwise, so the
+// triangulator has to pick its projection and flip it.
+TEST(ObjConcaveFaceTriangulates)
+{
+    vector<gl::Vector2> star, comb{ { 0, 0 }, { 0, 3 }, { 1, 3 }, { 1, 1 }, { 2, 1 }, { 2, 3 }, { 3, 3 }, { 3, 1 }, { 4, 1 }, { 4, 3 }, { 5, 3 }, { 5, 0 } };
+    for (int i = 0; i < 10; ++i) {
+        float angle = i * 0.6283185f, radius = i % 2 ? 0.8f : 2.0f;
+        star.push_back(gl::Vector2{ radius * cos(angle), radius * sin(angle) });
+    }
+
+    for (const vector<gl::Vector2>& polygon : { star, comb }) {
+        string text, face = "f";
+        for (size_t i = 0; i < polygon.size(); ++i) {
+            const gl::Vector2& p = polygon[i];
+            text += "v " + to_string(p.x + 0.3f * p.y) + " " + to_string(0.5f * p.x - p.y) + " " + to_string(0.2f * p.x + 0.7f * p.y) + "\n";
+            face += " " + to_string(i + 1);
+        }
+        check::ScratchFile file{ "concave.obj" };
+        file.Write(text + face + "\n");
+        OBJmesh mesh{ file.path(), 1 };
+
+        // Vertices are numbered in order of first use, so each is the corner
+        // written in the same place.
+        CHECK(mesh.vData().size() == polygon.size());
+        CHECK(mesh.fData().size() == 3 * (polygon.size() - 2));
+        double area = 0.0, covered = 0.0;
+        for (size_t i = 0; i < polygon.size(); ++i) { area += Turn(gl::Vector2{ 0.0f }, polygon[i], polygon[(i + 1) % polygon.size()]); }
+        for (size_t t = 0; t < mesh.fData().size(); t += 3) {
+            const gl::Vector2& a = polygon[mesh.fData()[t]];
+            const gl::Vector2& b = polygon[mesh.fData()[t + 1]];
+            const gl::Vector2& c = polygon[mesh.fData()[t + 2]];
+            CHECK(Turn(a, b, c) * area > 0.0);
+            CHECK(Inside(polygon, (a + b + c) / 3.0f));
+            covered += Turn(a, b, c);
+        }
+        CHECK(abs(covered - area) < 1e-4 * abs(area));
+    }
+}
+
+// Load speed in MB/s of OBJ text, on one thread and on every hardware
+// thread. This times the whole constructor, triangulation and tangents
+// included. Uses about 64 MB of generated OBJ, or the file given after
+// the name:
+//
+//     Tests --bench ObjParseThroughput model.obj
+BENCHMARK(ObjParseThroughput)
+{
+    check::ScratchFile generated{ "parse_throughput.obj" };
+    string path = check::Arguments().empty() ? generated.path() : check::Arguments()[0];
+    if (check::Arguments().empty()) { generated.Write(GeneratedObj(64 << 20)); }
+    double megabytes = static_cast<double>(filesystem::file_size(path)) / 1e6;
+
+    size_t corners = 0;
+    for (unsigned threads : { 1u, 0u }) {
+        double seconds = check::Fastest([&] { corners = OBJmesh{ path, threads }.fData().size(); }, 0.0);
+        printf("    %-12s %.1f MB, %zu corners, %.0f MB/s\n", threads == 1 ? "one thread:" : "all threads:", megabytes, corners, megabytes / seconds);
+    }
+}
+
+// Corners deduplicated per second by the open-addressing table OBJmesh uses,
+// against the unordered_map keyed by a string of the index bytes that it
+// replaced. The corners are those of a side x side grid in face order,
+// each position shared by six corners, with a uv seam down the middle.
+BENCHMARK(ObjVertexTableThroughput)
+{
+    using gl::obj::Index;
+    struct StringHash {
+        size_t operator() (const Index& id) const { return hash<string>{}(string(reinterpret_cast<const char*>(&id), sizeof(Index))); }
+    };
+
+    const int side = 1000;
+    vector<Index> corners;
+    corners.reserve(size_t(side) * side * 6);
+    for (int y = 0; y < side; ++y) {
+        for (int x = 0; x < side; ++x) {
+            auto corner = [&](int cx, int cy) {
+                gl::Int p = cy * (side + 1) + cx;
+                gl::Int t = cx == side / 2 && x < side / 2 ? p + (side + 1) * (side + 1) : p;
+                corners.push_back(Index{ p, t, p });
+            };
+            corner(x, y); corner(x + 1, y); corner(x + 1, y + 1);
+            corner(x, y); corner(x + 1, y + 1); corner(x, y + 1);
+        }
+    }
+
+    size_t unique = 0;
+    double table = check::Fastest([&] {
+        gl::obj::VertexTable vertices{ size_t(side + 1) * (side + 1) };
+        gl::Uint next = 0;
+        for (const Index& id : corners) { next += vertices.Insert(id, next).second; }
+        unique = next;
+    }, 0.0);
+    double map = check::Fastest([&] {
+        unordered_map<Index, gl::Uint, StringHash> vertices;
+        for (const Index& id : corners) {
+            if (vertices.find(id) == vertices.end()) { vertices.emplace(id, static_cast<gl::Uint>(vertices.size())); }
+        }
+    }, 0.0);
+
+    printf("    %zu corners, %zu vertices\n", corners.size(), unique);
+    printf("    VertexTable:        %.1f M corners/s\n", corners.size() / table / 1e6);
+    printf("    string-hashed map:  %.1f M corners/s (%.1fx slower)\n", corners.size() / map / 1e6, map / table);
+}
@@ -0,0 +1,76 @@
+#include <cmath>
+#include <vector>
+
+#include "../SDL2 Template/GL/TangentSpace.h"
+
+#include "Check.h"
+
+using namespace std;
+using namespace gl;
+
+namespace {
+    // A side x side grid of quads spanning o + u * across + v * up for u and
+    // v in [0, 1], with uvs running along u and v, or against u if mirrored.
+    // Normals and tangents are left zero for the generators to fill in.
+    void Sheet(int side, bool mirrored, const Vector3& across, const Vector3& up, vector<Vertex>& vertices, vector<Uint>& triangles)
+    {
+        const Point3 origin{ 0.5f, -1.0f, 2.0f };
+        vertices.assign(size_t(side + 1) * (side + 1), Vertex{});
+        for (int y = 0; y <= side; ++y) {
+            for (int x = 0; x <= side; ++x) {
+                float u = x / float(side), v = y / float(side);
+                Vertex& vertex = vertices[size_t(y) * (side + 1) + x];
+                vertex.position = origin + across * u + up * v;
+                vertex.uv = Vector2{ mirrored ? 1.0f - u : u, v };
+            }
+        }
+        triangles.clear();
+        for (int y = 0; y < side; ++y) {
+            for (int x = 0; x < side; ++x) {
+                Uint a = Uint(y * (side + 1) + x), b = a + 1, c = a + Uint(side + 1), d = c + 1;
+                triangles.insert(triangles.end(), { a, b, d, a, d, c });
+            }
+        }
+    }
+
+    bool Near(const Vector3& a, const Vector3& b)
+    {
+        return glm::length(a - b) < 1e-4f;
+    }
+}
+
+// On a flat sheet every vertex gets the face normal, a unit tangent along
+// +u at right angles to it, and the bitangent sign that makes
+// w * cross(normal, tangent) point along +v; a mirrored uv flips only the
+// tangent and the sign. One quad runs the partly filled SSE batch, the
+// larger sheet full batches too, on one thread and on several.
+TEST(TangentSpaceOnFlatSheet)
+{
+    const Vector3 across{ 2.0f, 0.5f, -1.0f }, up{ 0.25f, 1.0f, 1.5f };
+    const Vector3 normal = glm::normalize(glm::cross(across, up));
+    const Vector3 along = glm::normalize(across);
+    const Vector3 side = glm::cross(normal, along);
+
+    for (int quads : { 1, 7 }) {
+        for (bool mirrored : { false, true }) {
+            for (unsigned threads : { 1u, 0u }) {
+                vector<Vertex> vertices;
+                vector<Uint> triangles;
+                Sheet(quads, mirrored, across, up, vertices, triangles);
+                GenerateNormals(vertices, triangles, {}, threads);
+                GenerateTangents(vertices, triangles, threads);
+
+                for (const Vertex& v : vertices) {
+                    Vector3 tangent{ v.tangent };
+                    CHECK(abs(glm::length(v.normal) - 1.0f) < 1e-5f);
+                    CHECK(abs(glm::length(tangent) - 1.0f) < 1e-5f);
+                    CHECK(abs(glm::dot(v.normal, tangent)) < 1e-5f);
+                    CHECK(Near(v.normal, normal));
+                    CHECK(Near(tangent, mirrored ? -along : along));
+                    CHECK(v.tangent.w == (mirrored ? -1.0f : 1.0f));
+                    CHECK(glm::dot(v.tangent.w * glm::cross(v.normal, tangent), side) > 0.99f);
+                }
+            }
+        }
+    }
+}
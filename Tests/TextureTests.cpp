@@ -0,0 +1,226 @@
+#define SDL_MAIN_HANDLED
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../SDL2 Template/SDL2/SDL.h"
+#include "../Math/include/gl_texture.hpp"
+
+#include "Check.h"
+
+using namespace std;
+
+namespace {
+    bool Covers(const vector<lynda::Rect>& rects, int x, int y)
+    {
+        for (const lynda::Rect& r : rects) {
+            if (x >= r.x && x < r.right() && y >= r.y && y < r.top()) { return true; }
+        }
+        return false;
+    }
+
+    double Decode(int byte)
+    {
+        double c = byte / 255.0;
+        return c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+    }
+
+    double Encode(double linear)
+    {
+        return linear <= 0.0031308 ? linear * 12.92 : 1.055 * pow(linear, 1 / 2.4) - 0.055;
+    }
+
+    // The levels mipChain should make, worked out in doubles a texel at a
+    // time from the same taps, with no tables and no SIMD.
+    vector<lynda::MipLevel> ReferenceChain(const vector<uint8_t>& pixels, int width, int height, int channels, bool srgb, lynda::MipFilter filter)
+    {
+        vector<lynda::MipLevel> chain;
+        const int encoded = srgb && channels >= 3 ? 3 : 0;
+        for (int level = 1; (width >> (level - 1)) > 1 || (height >> (level - 1)) > 1; ++level) {
+            lynda::MipLevel mip{ max(width >> level, 1), max(height >> level, 1), {} };
+            lynda::detail::Taps across = lynda::detail::taps(width, mip.width, filter);
+            lynda::detail::Taps down = lynda::detail::taps(height, mip.height, filter);
+            for (int y = 0; y < mip.height; ++y) {
+                for (int x = 0; x < mip.width; ++x) {
+                    for (int c = 0; c < channels; ++c) {
+                        double sum = 0;
+                        for (int v = 0; v < down.count; ++v) {
+                            for (int h = 0; h < across.count; ++h) {
+                                int byte = pixels[(size_t(down.index[y * down.count + v]) * width + across.index[x * across.count + h]) * channels + c];
+                                sum += double(down.weight[y * down.count + v]) * across.weight[x * across.count + h] * (c < encoded ? Decode(byte) : byte / 255.0);
+                            }
+                        }
+                        sum = min(max(sum, 0.0), 1.0);
+                        mip.texels.push_back(static_cast<uint8_t>((c < encoded ? Encode(sum) : sum) * 255 + 0.5));
+                    }
+                }
+            }
+            chain.push_back(move(mip));
+        }
+        return chain;
+    }
+}
+
+// Coalescing clips to the texture and never leaves out a dirty texel,
+// merges what overlaps and keeps edits far apart as separate uploads.
+TEST(TextureCoalesceCoversDirtyTexels)
+{
+    vector<lynda::Rect> merged = lynda::coalesce({ { 0, 0, 10, 10 }, { 5, 5, 10, 10 }, { 1000, 1000, 4, 4 }, { -5, -5, 3, 3 }, { 90, 90, 50, 50 } }, 100, 100);
+    CHECK(merged.size() == 2);
+
+    mt19937 random{ 22 };
+    for (int trial = 0; trial < 200; ++trial) {
+        const int width = 1 + random() % 150, height = 1 + random() % 150;
+        vector<lynda::Rect> dirty(1 + random() % 12);
+        for (lynda::Rect& r : dirty) {
+            r = lynda::Rect{ int(random() % (width + 20)) - 10, int(random() % (height + 20)) - 10, 1 + int(random() % 40), 1 + int(random() % 40) };
+        }
+        vector<lynda::Rect> uploads = lynda::coalesce(dirty, width, height);
+        CHECK(uploads.size() <= dirty.size());
+        for (const lynda::Rect& r : uploads) {
+            CHECK(r.width > 0 && r.height > 0 && r.x >= 0 && r.y >= 0 && r.right() <= width && r.top() <= height);
+        }
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (Covers(dirty, x, y)) { CHECK(Covers(uploads, x, y)); }
+            }
+        }
+    }
+}
+
+// Every level of every kind of image is within one step of a reference
+// filtered in doubles, whichever SIMD paths this machine takes, on one
+// thread and on several; a padded pitch reads the same image.
+TEST(MipChainMatchesReference)
+{
+    mt19937 random{ 25 };
+    for (int channels = 1; channels <= 4; ++channels) {
+        const int width = 37, height = 12 + channels;
+        vector<uint8_t> pixels(size_t(width) * height * channels);
+        for (uint8_t& byte : pixels) { byte = static_cast<uint8_t>(random()); }
+        const size_t pitch = size_t(width) * channels + 3;
+        vector<uint8_t> padded(pitch * height);
+        for (int y = 0; y < height; ++y) {
+            copy_n(&pixels[size_t(y) * width * channels], width * channels, &padded[y * pitch]);
+        }
+
+        for (lynda::MipFilter filter : { lynda::MipFilter::Box, lynda::MipFilter::Kaiser }) {
+            for (bool srgb : { false, true }) {
+                vector<lynda::MipLevel> expected = ReferenceChain(pixels, width, height, channels, srgb, filter);
+                for (unsigned threads : { 1u, 0u }) {
+                    vector<lynda::MipLevel> chain = lynda::mipChain(pixels.data(), width, height, channels, srgb, filter, 0, 0, threads);
+                    CHECK(chain.size() == expected.size());
+                    CHECK(lynda::mipChain(padded.data(), width, height, channels, srgb, filter, 0, pitch, threads).back().texels == chain.back().texels);
+                    for (size_t level = 0; level < min(chain.size(), expected.size()); ++level) {
+                        CHECK(chain[level].width == expected[level].width && chain[level].height == expected[level].height);
+                        CHECK(chain[level].texels.size() == expected[level].texels.size());
+                        for (size_t i = 0; i < min(chain[level].texels.size(), expected[level].texels.size()); ++i) {
+                            CHECK(abs(chain[level].texels[i] - expected[level].texels[i]) <= 1);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+#ifdef LYNDA_X86
+// The SSE and AVX blends and the SSE row filter give exactly the floats
+// the scalar loops do, over lengths that leave every size of tail.
+TEST(MipChainSimdMatchesScalar)
+{
+    mt19937 random{ 25 };
+    uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+    const bool avx = lynda::detail::detectIsa() == lynda::detail::Isa::Avx2;
+
+    for (int taps : { 1, 2, 7 }) {
+        for (size_t count : { size_t(0), size_t(5), size_t(8), size_t(15), size_t(16), size_t(77) }) {
+            vector<vector<float>> data(taps, vector<float>(count));
+            vector<const float*> rows;
+            vector<float> weights(taps);
+            for (int t = 0; t < taps; ++t) {
+                for (float& value : data[t]) { value = unit(random); }
+                rows.push_back(data[t].data());
+                weights[t] = unit(random) - 0.25f;
+            }
+            vector<float> scalar(count), simd(count);
+            lynda::detail::blendRows(rows.data(), weights.data(), taps, scalar.data(), 0, count);
+            lynda::detail::blendRowsSse(rows.data(), weights.data(), taps, simd.data(), count);
+            CHECK(simd == scalar);
+            if (avx) {
+                lynda::detail::blendRowsAvx(rows.data(), weights.data(), taps, simd.data(), count);
+                CHECK(simd == scalar);
+            }
+        }
+    }
+
+    for (lynda::MipFilter filter : { lynda::MipFilter::Box, lynda::MipFilter::Kaiser }) {
+        const int from = 53, to = 13;
+        lynda::detail::Taps h = lynda::detail::taps(from, to, filter);
+        vector<float> src(size_t(from) * 4);
+        for (float& value : src) { value = unit(random); }
+        vector<float> scalar(size_t(to) * 4), simd(size_t(to) * 4);
+        lynda::detail::filterRow(h, src.data(), scalar.data(), to);
+        lynda::detail::filterRowSse(h, src.data(), simd.data(), to);
+        CHECK(simd == scalar);
+    }
+}
+#endif
+
+// Milliseconds per update of a 2048 x 2048 RGBA8 texture, or one the size
+// given after the name, when 16 scattered rects cover a share of it:
+// the whole image and glGenerateMipmap as before, then only the rects with
+// each way of bringing the mip levels up to date. Needs a GL context, so
+// it opens a hidden window.
+//
+//     Tests --bench TextureDirtyUpload 4096
+BENCHMARK(TextureDirtyUpload)
+{
+    const int side = check::Arguments().empty() ? 2048 : stoi(check::Arguments()[0]);
+
+    SDL_SetMainReady();
+    sdl::Library video{ sdl::Library::Video };
+    video.gl[sdl::gl::ProfileMask] = SDL_GL_CONTEXT_PROFILE_CORE;
+    video.gl[sdl::gl::MajorVersion] = 4;
+    video.gl[sdl::gl::MinorVersion] = 1;
+    sdl::Window* window = video.NewWindow("Tests", 0, 0, 64, 64, static_cast<sdl::Window::Features>(sdl::Window::OpenGL | sdl::Window::Hidden));
+    sdl::gl::Context context = window->CreateContext();
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK) { throw runtime_error{ "Failed to load OpenGL" }; }
+    glGetError();
+
+    mt19937 random{ 22 };
+    vector<unsigned char> image(size_t(side) * side * 4);
+    for (unsigned char& byte : image) { byte = static_cast<unsigned char>(random()); }
+    lynda::Texture texture{ side, side };
+    using Mipmaps = lynda::Texture::Mipmaps;
+
+    printf("    %d x %d RGBA8, ms per update\n", side, side);
+    printf("    uploaded  rects  whole image  rects+Dirty  rects+Full  rects, no mips\n");
+    for (double share : { 0.001, 0.01, 0.05, 0.25, 1.0 }) {
+        const int count = 16, extent = max(1, int(sqrt(share * side * side / count) + 0.5));
+        vector<lynda::Rect> dirty(count);
+        for (lynda::Rect& r : dirty) {
+            r = lynda::Rect{ int(random() % (side - extent + 1)), int(random() % (side - extent + 1)), extent, extent };
+        }
+        vector<lynda::Rect> uploads = lynda::coalesce(dirty, side, side);
+        long long uploaded = 0;
+        for (const lynda::Rect& r : uploads) { uploaded += r.area(); }
+
+        auto time = [&](auto&& update) { return 1e3 * check::Fastest([&] { update(); glFinish(); }); };
+        double whole = time([&] { texture.update(image.data()); });
+        double rects = time([&] { texture.update(image.data(), dirty, Mipmaps::Dirty); });
+        double rectsFull = time([&] { texture.update(image.data(), dirty, Mipmaps::Full); });
+        double rectsOnly = time([&] { texture.update(image.data(), dirty, Mipmaps::None); });
+        printf("    %5.1f%%    %4zu   %8.2f     %8.2f     %8.2f    %8.2f\n",
+            100.0 * uploaded / (double(side) * side), uploads.size(), whole, rects, rectsFull, rectsOnly);
+    }
+    CHECK(glGetError() == GL_NO_ERROR);
+
+    SDL_GL_DeleteContext(context);
+}
@@ -0,0 +1,116 @@
+// Checks for the runtime code that needs no window. Every test runs by
+// default; --bench runs the benchmarks instead, which print their
+// measurements. Naming a case runs only that one, and anything after the
+// name is handed to it, such as a large asset to measure.
+//
+//     Tests [--bench] [case [arguments...]]
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+    vector<string> arguments;
+}
+
+namespace check {
+    vector<Case>& Cases()
+    {
+        static vector<Case> cases;
+        return cases;
+    }
+
+    void That(bool condition, const char* expression, const char* file, int line)
+    {
+        if (!condition) { throw Failure{ string{ file } + "(" + to_string(line) + "): " + expression }; }
+    }
+
+    const vector<string>& Arguments()
+    {
+        return arguments;
+    }
+
+    ScratchFile::ScratchFile(const string& name)
+        : _path{ filesystem::temp_directory_path() / name }
+    {}
+
+    ScratchFile::~ScratchFile()
+    {
+        error_code ignored;
+        filesystem::remove(_path, ignored);
+    }
+
+    void ScratchFile::Write(const string& contents) const
+    {
+        ofstream out{ _path, ios::binary | ios::trunc };
+        out.write(contents.data(), static_cast<streamsize>(contents.size()));
+        if (!out) { throw runtime_error{ "Failed to write file: " + _path.string() }; }
+    }
+
+    void DropCached(const string& filename)
+    {
+#ifdef _WIN32
+        // The cache manager flushes and purges a file's pages when it is
+        // opened unbuffered and no cached handle to it is left.
+        HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, nullptr);
+        if (file != INVALID_HANDLE_VALUE) { CloseHandle(file); }
+#else
+        int file = open(filename.c_str(), O_RDONLY);
+        if (file < 0) { return; }
+        fsync(file);
+        posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+        close(file);
+#endif
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    check::Kind kind = check::Kind::Test;
+    int next = 1;
+    if (next < argc && strcmp(argv[next], "--bench") == 0) {
+        kind = check::Kind::Benchmark;
+        ++next;
+    }
+    const char* only = next < argc ? argv[next++] : nullptr;
+    arguments.assign(argv + next, argv + argc);
+
+    int run = 0, failed = 0;
+    for (const check::Case& test : check::Cases()) {
+        if (only ? strcmp(test.name, only) != 0 : test.kind != kind) { continue; }
+        ++run;
+        auto start = chrono::steady_clock::now();
+        try {
+            test.body();
+            printf("ok      %s (%.0f ms)\n", test.name, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+        }
+        catch (const exception& error) {
+            ++failed;
+            printf("FAILED  %s: %s\n", test.name, error.what());
+        }
+        fflush(stdout);
+    }
+    if (only && !run) {
+        fprintf(stderr, "No case named %s\n", only);
+        return 2;
+    }
+    printf("%d of %d passed\n", run - failed, run);
+    return failed ? 1 : 0;
+}